@@ -202,6 +202,15 @@ void cfs_cpt_clear(struct cfs_cpt_table *cptab, int cpt);
  * nodes in this partition, it might return a different node id each time.
  */
 int cfs_cpt_spread_node(struct cfs_cpt_table *cptab, int cpt);
+/**
+ * account memory allocated for CPU partition \a cpt from numa node \a node,
+ * allocation not from nodes of \a cpt is counted as a locality violation
+ */
+void cfs_cpt_mem_account(struct cfs_cpt_table *cptab, int cpt, int node);
+/**
+ * print numa nodes and count of cross-node allocations of all partitions
+ */
+int cfs_cpt_numa_print(struct cfs_cpt_table *cptab, char *buf, int len);
 
 /**
  * return number of HTs in the same core of \a cpu
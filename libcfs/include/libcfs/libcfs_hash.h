@@ -204,6 +204,12 @@ enum cfs_hash_tag {
          * change on hash table is non-blocking
          */
         CFS_HASH_NBLK_CHANGE    = 1 << 13,
+        /**
+         * cfs_hash_lookup doesn't take any lock, the hlists are terminated
+         * by nulls markers and walked under rcu_read_lock(). User must free
+         * items after a RCU grace period and provide hs_get_rcu.
+         */
+        CFS_HASH_RCU            = 1 << 14,
         /** NB, we typed hs_flags as  __u16, please change it
          * if you need to extend >=16 flags */
 };
@@ -249,6 +255,16 @@ enum cfs_hash_tag {
  * depending on whether the worker task has yet to transfer the object
  * to its new location in the table. Lookups and deletions need to search both
  * locations; additions must take care to only insert into the new bucket.
+ *
+ * RCU lookup:
+ * With CFS_HASH_RCU, each hlist is a hlist_nulls terminated by a marker
+ * which identifies it, and cfs_hash_lookup walks it without any lock.
+ * Items are only freed after a RCU grace period, but they can be moved
+ * to another hlist by rehash or be deleted and added again, a walk which
+ * doesn't end on the marker of the hlist it started on is restarted.
+ * hs_rcu_seq is odd while the rehash worker is moving items, lockless
+ * lookup falls back to the locked path meanwhile. The old bucket-table
+ * is freed by the worker after a grace period.
  */
 
 typedef struct cfs_hash {
@@ -289,6 +305,8 @@ typedef struct cfs_hash {
         __u16                       hs_max_theta;
         /** resize count */
         __u32                       hs_rehash_count;
+        /** odd while items are moved by rehash, for CFS_HASH_RCU only */
+        __u32                       hs_rcu_seq;
         /** # of iterators (caller of cfs_hash_for_each_*) */
         __u32                       hs_iterators;
 	/** rehash workitem */
@@ -355,6 +373,12 @@ typedef struct cfs_hash_ops {
 	void *   (*hs_object)(struct hlist_node *hnode);
 	/** get refcount of item, always called with holding bucket-lock */
 	void     (*hs_get)(cfs_hash_t *hs, struct hlist_node *hnode);
+	/**
+	 * get refcount of item found by lockless lookup of CFS_HASH_RCU
+	 * hash-table, called under rcu_read_lock() without bucket-lock,
+	 * returns 0 if the item is being destroyed
+	 */
+	int      (*hs_get_rcu)(cfs_hash_t *hs, struct hlist_node *hnode);
 	/** release refcount of item */
 	void     (*hs_put)(cfs_hash_t *hs, struct hlist_node *hnode);
 	/** release refcount of item, always called with holding bucket-lock */
@@ -471,6 +495,13 @@ cfs_hash_with_nblk_change(cfs_hash_t *hs)
         return (hs->hs_flags & CFS_HASH_NBLK_CHANGE) != 0;
 }
 
+static inline int
+cfs_hash_with_rcu(cfs_hash_t *hs)
+{
+	/* lookup is lockless and protected by RCU */
+	return (hs->hs_flags & CFS_HASH_RCU) != 0;
+}
+
 static inline int
 cfs_hash_is_exiting(cfs_hash_t *hs)
 {       /* cfs_hash_destroy is called */
@@ -64,6 +64,8 @@ struct kuc_hdr {
 } __attribute__((aligned(sizeof(__u64))));
 
 #define KUC_CHANGELOG_MSG_MAXSIZE (sizeof(struct kuc_hdr)+CR_MAXSIZE)
+/* Several records packed in one message, see CHANGELOG_FLAG_BATCH */
+#define KUC_CHANGELOG_BATCH_MAXSIZE (1 << 15)
 
 #define KUC_MAGIC  0x191C /*Lustre9etLinC */
 #define KUC_FL_BLOCK 0x01   /* Wait for send */
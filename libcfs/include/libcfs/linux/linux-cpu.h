@@ -64,6 +64,8 @@ struct cfs_cpu_partition {
 	nodemask_t			*cpt_nodemask;
 	/* spread rotor for NUMA allocator */
 	unsigned			cpt_spread_rotor;
+	/* # of allocations for this partition not from its nodes */
+	atomic_t			cpt_mem_remote;
 };
 
 /** descriptor for CPU partitions */
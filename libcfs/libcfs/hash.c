@@ -108,6 +108,7 @@
  */
 
 #include <libcfs/libcfs.h>
+#include <linux/rculist_nulls.h>
 
 #if CFS_HASH_DEBUG_LEVEL >= CFS_HASH_DEBUG_1
 static unsigned int warn_on_depth = 8;
@@ -459,9 +460,107 @@ static cfs_hash_hlist_ops_t cfs_hash_dd_hops = {
        .hop_hnode_del  = cfs_hash_dd_hnode_del,
 };
 
+/**
+ * Hash head of CFS_HASH_RCU hash-table, with depth tracking.
+ * The hlist is terminated by a nulls marker which identifies it, so a
+ * lockless walk can tell it has been moved to another hlist.
+ * new element is always added to head of hlist
+ */
+typedef struct {
+	struct hlist_nulls_head	nd_head;	/**< entries list */
+	unsigned int		nd_depth;	/**< list length */
+} cfs_hash_nhead_dep_t;
+
+static int
+cfs_hash_nd_hhead_size(cfs_hash_t *hs)
+{
+	return sizeof(cfs_hash_nhead_dep_t);
+}
+
+static struct hlist_nulls_head *
+cfs_hash_nd_nhead(cfs_hash_t *hs, cfs_hash_bd_t *bd)
+{
+	cfs_hash_nhead_dep_t *head;
+
+	head = (cfs_hash_nhead_dep_t *)&bd->bd_bucket->hsb_head[0];
+	return &head[bd->bd_offset].nd_head;
+}
+
+/* hlist_nulls has the layout of hlist, the locked walkers in this file
+ * stop on the nulls marker, see cfs_hash_hnode_is_end() */
+static struct hlist_head *
+cfs_hash_nd_hhead(cfs_hash_t *hs, cfs_hash_bd_t *bd)
+{
+	CLASSERT(sizeof(struct hlist_nulls_head) == sizeof(struct hlist_head));
+	CLASSERT(offsetof(struct hlist_nulls_node, next) ==
+		 offsetof(struct hlist_node, next));
+	CLASSERT(offsetof(struct hlist_nulls_node, pprev) ==
+		 offsetof(struct hlist_node, pprev));
+
+	return (struct hlist_head *)cfs_hash_nd_nhead(hs, bd);
+}
+
+/* nulls marker of the hlist, it stays the same when rehash reuses the
+ * bucket for the new bucket-table */
+static inline unsigned long
+cfs_hash_nd_nulls(cfs_hash_t *hs, cfs_hash_bd_t *bd)
+{
+	return cfs_hash_bd_index_get(hs, bd);
+}
+
+static int
+cfs_hash_nd_hnode_add(cfs_hash_t *hs, cfs_hash_bd_t *bd,
+		      struct hlist_node *hnode)
+{
+	cfs_hash_nhead_dep_t *nh = container_of(cfs_hash_nd_nhead(hs, bd),
+						cfs_hash_nhead_dep_t, nd_head);
+
+	hlist_nulls_add_head_rcu((struct hlist_nulls_node *)hnode,
+				 &nh->nd_head);
+	return ++nh->nd_depth;
+}
+
+static int
+cfs_hash_nd_hnode_del(cfs_hash_t *hs, cfs_hash_bd_t *bd,
+		      struct hlist_node *hnode)
+{
+	cfs_hash_nhead_dep_t *nh = container_of(cfs_hash_nd_nhead(hs, bd),
+						cfs_hash_nhead_dep_t, nd_head);
+
+	/* keeps ->next for the lockless walkers, and unhashes @hnode */
+	hlist_nulls_del_init_rcu((struct hlist_nulls_node *)hnode);
+	return --nh->nd_depth;
+}
+
+static cfs_hash_hlist_ops_t cfs_hash_nd_hops = {
+       .hop_hhead      = cfs_hash_nd_hhead,
+       .hop_hhead_size = cfs_hash_nd_hhead_size,
+       .hop_hnode_add  = cfs_hash_nd_hnode_add,
+       .hop_hnode_del  = cfs_hash_nd_hnode_del,
+};
+
+/* end of a hlist, NULL or the nulls marker of a CFS_HASH_RCU hlist */
+#define cfs_hash_hnode_is_end(hnode)					\
+	((hnode) == NULL ||						\
+	 is_a_nulls((const struct hlist_nulls_node *)(hnode)))
+
+#define cfs_hash_hnode_for_each(pos, head)				\
+	for (pos = (head)->first; !cfs_hash_hnode_is_end(pos);		\
+	     pos = pos->next)
+
+#define cfs_hash_hnode_for_each_safe(pos, n, head)			\
+	for (pos = (head)->first;					\
+	     !cfs_hash_hnode_is_end(pos) && ({ n = pos->next; 1; });	\
+	     pos = n)
+
 static void
 cfs_hash_hlist_setup(cfs_hash_t *hs)
 {
+	if (cfs_hash_with_rcu(hs)) {
+		hs->hs_hops = &cfs_hash_nd_hops;
+		return;
+	}
+
         if (cfs_hash_with_add_tail(hs)) {
                 hs->hs_hops = cfs_hash_with_depth(hs) ?
                               &cfs_hash_dd_hops : &cfs_hash_dh_hops;
@@ -633,7 +732,7 @@ cfs_hash_bd_lookup_intent(cfs_hash_t *hs, cfs_hash_bd_t *bd,
 	/* with this function, we can avoid a lot of useless refcount ops,
 	 * which are expensive atomic operations most time. */
 	match = intent_add ? NULL : hnode;
-	hlist_for_each(ehnode, hhead) {
+	cfs_hash_hnode_for_each(ehnode, hhead) {
 		if (!cfs_hash_keycmp(hs, key, ehnode))
 			continue;
 
@@ -941,8 +1040,13 @@ cfs_hash_buckets_realloc(cfs_hash_t *hs, cfs_hash_bucket_t **old_bkts,
 		new_bkts[i]->hsb_version = 1;  /* shouldn't be zero */
 		new_bkts[i]->hsb_depmax  = -1; /* unknown */
 		bd.bd_bucket = new_bkts[i];
-		cfs_hash_bd_for_each_hlist(hs, &bd, hhead)
-			INIT_HLIST_HEAD(hhead);
+		cfs_hash_bd_for_each_hlist(hs, &bd, hhead) {
+			if (cfs_hash_with_rcu(hs))
+				INIT_HLIST_NULLS_HEAD(cfs_hash_nd_nhead(hs, &bd),
+						cfs_hash_nd_nulls(hs, &bd));
+			else
+				INIT_HLIST_HEAD(hhead);
+		}
 
                 if (cfs_hash_with_no_lock(hs) ||
                     cfs_hash_with_no_bktlock(hs))
@@ -1053,6 +1157,12 @@ cfs_hash_create(char *name, unsigned cur_bits, unsigned max_bits,
                      (flags & CFS_HASH_NO_LOCK) == 0));
         LASSERT(ergo((flags & CFS_HASH_REHASH_KEY) != 0,
                       ops->hs_keycpy != NULL));
+	/* lockless walk can't follow an item which changes its key or is
+	 * added to the tail */
+	LASSERT(ergo((flags & CFS_HASH_RCU) != 0,
+		     (flags & (CFS_HASH_NO_LOCK | CFS_HASH_ADD_TAIL |
+			       CFS_HASH_REHASH_KEY)) == 0 &&
+		     ops->hs_get_rcu != NULL && ops->hs_put != NULL));
 
         len = (flags & CFS_HASH_BIGNAME) == 0 ?
               CFS_HASH_NAME_LEN : CFS_HASH_BIGNAME_LEN;
@@ -1130,7 +1240,7 @@ cfs_hash_destroy(cfs_hash_t *hs)
 		cfs_hash_bd_lock(hs, &bd, 1);
 
                 cfs_hash_bd_for_each_hlist(hs, &bd, hhead) {
-			hlist_for_each_safe(hnode, pos, hhead) {
+			cfs_hash_hnode_for_each_safe(hnode, pos, hhead) {
 					LASSERTF(!cfs_hash_with_assert_empty(hs),
 					"hash %s bucket %u(%u) is not "
 					" empty: %u items left\n",
@@ -1354,6 +1464,90 @@ cfs_hash_del_key(cfs_hash_t *hs, const void *key)
 }
 EXPORT_SYMBOL(cfs_hash_del_key);
 
+/** times a lockless lookup restarts a walk moved to another hlist */
+#define CFS_HASH_RCU_RESTARTS	4
+
+/**
+ * Lockless lookup of CFS_HASH_RCU hash-table.
+ *
+ * The hlist is walked under rcu_read_lock() and ops->hs_get_rcu takes a
+ * reference on the matched item. Items are freed after a grace period,
+ * so the walk itself is safe, but an item can be deleted and added to
+ * another hlist while we are on it. The walk then ends on the nulls
+ * marker of another hlist and is restarted. The key is checked again
+ * after taking the reference in case the item has been reused. A miss
+ * is only trusted if the rehash worker didn't run meanwhile, which is
+ * tracked by hs_rcu_seq.
+ *
+ * Returns the referenced object, NULL if @key is not in @hs, or
+ * ERR_PTR(-EAGAIN) if caller should retry with bucket lock held.
+ */
+static void *
+cfs_hash_rcu_lookup(cfs_hash_t *hs, const void *key)
+{
+	cfs_hash_bucket_t	**bkts;
+	struct hlist_nulls_node	*node;
+	struct hlist_node	*hnode;
+	cfs_hash_bd_t		bd;
+	unsigned int		seq;
+	unsigned int		bits;
+	unsigned int		index;
+	int			restarts = 0;
+
+	rcu_read_lock();
+	seq = ACCESS_ONCE(hs->hs_rcu_seq);
+	if ((seq & 1) != 0) /* rehash in progress */
+		goto locked;
+	smp_rmb();
+
+	bits = ACCESS_ONCE(hs->hs_cur_bits);
+	bkts = ACCESS_ONCE(hs->hs_buckets);
+	/* bucket-table and bits must be from the same generation */
+	smp_rmb();
+	if (ACCESS_ONCE(hs->hs_rcu_seq) != seq)
+		goto locked;
+
+	index = cfs_hash_id(hs, key, (1U << bits) - 1);
+	bd.bd_bucket = bkts[index & ((1U << (bits - hs->hs_bkt_bits)) - 1)];
+	bd.bd_offset = index >> (bits - hs->hs_bkt_bits);
+restart:
+	for (node = rcu_dereference(cfs_hash_nd_nhead(hs, &bd)->first);
+	     !is_a_nulls(node); node = rcu_dereference(node->next)) {
+		hnode = (struct hlist_node *)node;
+		if (!cfs_hash_keycmp(hs, key, hnode))
+			continue;
+
+		/* dying item, let the locked path decide */
+		if (!CFS_HOP(hs, get_rcu)(hs, hnode))
+			goto locked;
+
+		rcu_read_unlock();
+		if (unlikely(!cfs_hash_keycmp(hs, key, hnode))) {
+			/* item has been reused for another key */
+			cfs_hash_put(hs, hnode);
+			return ERR_PTR(-EAGAIN);
+		}
+		return cfs_hash_object(hs, hnode);
+	}
+
+	if (get_nulls_value(node) != cfs_hash_nd_nulls(hs, &bd)) {
+		/* moved to another hlist by a concurrent del and add */
+		if (++restarts < CFS_HASH_RCU_RESTARTS)
+			goto restart;
+		goto locked;
+	}
+
+	smp_rmb();
+	if (ACCESS_ONCE(hs->hs_rcu_seq) != seq)
+		goto locked;
+
+	rcu_read_unlock();
+	return NULL;
+locked:
+	rcu_read_unlock();
+	return ERR_PTR(-EAGAIN);
+}
+
 /**
  * Lookup an item using @key in the libcfs hash @hs and return it.
  * If the @key is found in the hash hs->hs_get() is called and the
@@ -1361,6 +1555,9 @@ EXPORT_SYMBOL(cfs_hash_del_key);
  * to call the counterpart ops->hs_put using the cfs_hash_put() macro
  * when when finished with the object.  If the @key was not found
  * in the hash @hs NULL is returned.
+ *
+ * With CFS_HASH_RCU, no lock is taken and ops->hs_get_rcu() is called
+ * instead of hs_get(), unless the lookup has to be retried with lock.
  */
 void *
 cfs_hash_lookup(cfs_hash_t *hs, const void *key)
@@ -1369,6 +1566,13 @@ cfs_hash_lookup(cfs_hash_t *hs, const void *key)
 	struct hlist_node     *hnode;
         cfs_hash_bd_t         bds[2];
 
+	if (cfs_hash_with_rcu(hs)) {
+		obj = cfs_hash_rcu_lookup(hs, key);
+		if (!IS_ERR(obj))
+			return obj;
+		obj = NULL;
+	}
+
         cfs_hash_lock(hs, 0);
         cfs_hash_dual_bd_get_and_lock(hs, key, bds, 0);
 
@@ -1469,7 +1673,7 @@ cfs_hash_for_each_tight(cfs_hash_t *hs, cfs_hash_for_each_cb_t func,
 		}
 
 		cfs_hash_bd_for_each_hlist(hs, &bd, hhead) {
-			hlist_for_each_safe(hnode, pos, hhead) {
+			cfs_hash_hnode_for_each_safe(hnode, pos, hhead) {
 				cfs_hash_bucket_validate(hs, &bd, hnode);
 				count++;
 				loop++;
@@ -1611,7 +1815,8 @@ cfs_hash_for_each_relax(cfs_hash_t *hs, cfs_hash_for_each_cb_t func, void *data)
                 version = cfs_hash_bd_version_get(&bd);
 
                 cfs_hash_bd_for_each_hlist(hs, &bd, hhead) {
-                        for (hnode = hhead->first; hnode != NULL;) {
+                        for (hnode = hhead->first;
+			     !cfs_hash_hnode_is_end(hnode);) {
                                 cfs_hash_bucket_validate(hs, &bd, hnode);
                                 cfs_hash_get(hs, hnode);
                                 cfs_hash_bd_unlock(hs, &bd, 0);
@@ -1724,7 +1929,7 @@ cfs_hash_hlist_for_each(cfs_hash_t *hs, unsigned hindex,
 
 	cfs_hash_bd_lock(hs, &bd, 0);
 	hhead = cfs_hash_bd_hhead(hs, &bd);
-	hlist_for_each(hnode, hhead) {
+	cfs_hash_hnode_for_each(hnode, hhead) {
 		if (func(hs, &bd, hnode, data))
 			break;
 	}
@@ -1757,7 +1962,7 @@ cfs_hash_for_each_key(cfs_hash_t *hs, const void *key,
 	cfs_hash_for_each_bd(bds, 2, i) {
 		struct hlist_head *hlist = cfs_hash_bd_hhead(hs, &bds[i]);
 
-		hlist_for_each(hnode, hlist) {
+		cfs_hash_hnode_for_each(hnode, hlist) {
 			cfs_hash_bucket_validate(hs, &bds[i], hnode);
 
 			if (cfs_hash_keycmp(hs, key, hnode)) {
@@ -1837,7 +2042,9 @@ cfs_hash_rehash(cfs_hash_t *hs, int do_rehash)
         }
 
         hs->hs_rehash_bits = rc;
-        if (!do_rehash) {
+        /* old bucket-table of RCU hash is freed after a grace period,
+         * which can't be waited for by caller of add/del */
+        if (!do_rehash || cfs_hash_with_rcu(hs)) {
                 /* launch and return */
 		cfs_wi_schedule(cfs_sched_rehash, &hs->hs_rehash_wi);
                 cfs_hash_unlock(hs, 1);
@@ -1851,6 +2058,32 @@ cfs_hash_rehash(cfs_hash_t *hs, int do_rehash)
 }
 EXPORT_SYMBOL(cfs_hash_rehash);
 
+/**
+ * Lockless lookup of CFS_HASH_RCU hash can miss items while they are
+ * moved between buckets, make hs_rcu_seq odd for the whole rehash so
+ * lookup can fall back to the locked path. Need hold cfs_hash_lock(hs, 1).
+ */
+static inline void
+cfs_hash_rcu_seq_begin(cfs_hash_t *hs)
+{
+	if (!cfs_hash_with_rcu(hs))
+		return;
+
+	LASSERT((hs->hs_rcu_seq & 1) == 0);
+	hs->hs_rcu_seq++;
+	smp_wmb();
+}
+
+static inline void
+cfs_hash_rcu_seq_end(cfs_hash_t *hs)
+{
+	if (!cfs_hash_with_rcu(hs) || (hs->hs_rcu_seq & 1) == 0)
+		return;
+
+	smp_wmb();
+	hs->hs_rcu_seq++;
+}
+
 static int
 cfs_hash_rehash_bd(cfs_hash_t *hs, cfs_hash_bd_t *old)
 {
@@ -1863,7 +2096,7 @@ cfs_hash_rehash_bd(cfs_hash_t *hs, cfs_hash_bd_t *old)
 
 	/* hold cfs_hash_lock(hs, 1), so don't need any bucket lock */
 	cfs_hash_bd_for_each_hlist(hs, old, hhead) {
-		hlist_for_each_safe(hnode, pos, hhead) {
+		cfs_hash_hnode_for_each_safe(hnode, pos, hhead) {
 			key = cfs_hash_key(hs, hnode);
 			LASSERT(key != NULL);
 			/* Validate hnode is in the correct bucket. */
@@ -1892,6 +2125,7 @@ cfs_hash_rehash_worker(cfs_workitem_t *wi)
         int                 bsize;
         int                 count = 0;
         int                 rc = 0;
+        int                 rcu;
         int                 i;
 
         LASSERT (hs != NULL && cfs_hash_with_rehash(hs));
@@ -1932,6 +2166,7 @@ cfs_hash_rehash_worker(cfs_workitem_t *wi)
 
         LASSERT(hs->hs_rehash_buckets == NULL);
         hs->hs_rehash_buckets = bkts;
+        cfs_hash_rcu_seq_begin(hs);
 
         rc = 0;
         cfs_hash_for_each_bucket(hs, &bd, i) {
@@ -1968,13 +2203,19 @@ cfs_hash_rehash_worker(cfs_workitem_t *wi)
         hs->hs_cur_bits = hs->hs_rehash_bits;
  out:
         hs->hs_rehash_bits = 0;
+	cfs_hash_rcu_seq_end(hs);
 	if (rc == -ESRCH) /* never be scheduled again */
 		cfs_wi_exit(cfs_sched_rehash, wi);
         bsize = cfs_hash_bkt_size(hs);
+	rcu = cfs_hash_with_rcu(hs);
         cfs_hash_unlock(hs, 1);
         /* can't refer to @hs anymore because it could be destroyed */
-        if (bkts != NULL)
+	if (bkts != NULL) {
+		/* lockless lookup may still refer to the old bkt-table */
+		if (rcu)
+			synchronize_rcu();
                 cfs_hash_buckets_free(bkts, bsize, new_size, old_size);
+	}
         if (rc != 0)
                 CDEBUG(D_INFO, "early quit of of rehashing: %d\n", rc);
 	/* return 1 only if cfs_wi_exit is called */
@@ -1999,6 +2240,8 @@ void cfs_hash_rehash_key(cfs_hash_t *hs, const void *old_key,
         cfs_hash_bd_t        new_bd;
 
 	LASSERT(!hlist_unhashed(hnode));
+	/* lockless lookup can't detect the key of an item changing */
+	LASSERT(!cfs_hash_with_rcu(hs));
 
         cfs_hash_lock(hs, 0);
 
@@ -0,0 +1,273 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.sun.com/software/products/lustre/docs/GPLv2.pdf
+ *
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa Clara,
+ * CA 95054 USA or visit www.sun.com if you need additional information or
+ * have any questions.
+ *
+ * GPL HEADER END
+ */
+/*
+ * Copyright (c) 2014, Intel Corporation.
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ * Lustre is a trademark of Sun Microsystems, Inc.
+ *
+ * libcfs/libcfs/hash_test.c
+ *
+ * Lookup throughput of cfs_hash with the bucket locks and with
+ * CFS_HASH_RCU, for 1, 2, 4 ... hash_test_threads threads. The benchmark
+ * runs when the module is loaded and the results go to the console:
+ *
+ *   modprobe hash_test hash_test_threads=32; rmmod hash_test
+ */
+
+#define DEBUG_SUBSYSTEM S_LNET
+
+#include <linux/module.h>
+#include <linux/kthread.h>
+#include <libcfs/libcfs.h>
+
+static unsigned int hash_test_threads;
+CFS_MODULE_PARM(hash_test_threads, "i", uint, 0444,
+		"max # of lookup threads, default is # of online CPUs");
+
+static unsigned int hash_test_items = 1 << 16;
+CFS_MODULE_PARM(hash_test_items, "i", uint, 0444,
+		"# of items in the hash");
+
+static unsigned int hash_test_seconds = 2;
+CFS_MODULE_PARM(hash_test_seconds, "i", uint, 0444,
+		"seconds each run lasts");
+
+#define HASH_TEST_BITS		16
+#define HASH_TEST_BKT_BITS	8
+
+struct hash_test_item {
+	__u64			hti_key;
+	atomic_t		hti_ref;
+	struct hlist_node	hti_hnode;
+};
+
+struct hash_test_ctl {
+	cfs_hash_t		*htc_hs;
+	unsigned long		htc_deadline;
+	atomic_t		htc_nrunning;
+	atomic64_t		htc_lookups;
+	struct completion	htc_done;
+};
+
+static struct hash_test_item *hash_test_array;
+/* not on stack, the last thread may still be in complete() */
+static struct hash_test_ctl hash_test_ctl;
+
+static unsigned hash_test_hop_hash(cfs_hash_t *hs, const void *key,
+				   unsigned mask)
+{
+	return cfs_hash_u64_hash(*(const __u64 *)key, mask);
+}
+
+static void *hash_test_hop_key(struct hlist_node *hnode)
+{
+	struct hash_test_item *hti;
+
+	hti = hlist_entry(hnode, struct hash_test_item, hti_hnode);
+	return &hti->hti_key;
+}
+
+static int hash_test_hop_keycmp(const void *key, struct hlist_node *hnode)
+{
+	struct hash_test_item *hti;
+
+	hti = hlist_entry(hnode, struct hash_test_item, hti_hnode);
+	return *(const __u64 *)key == hti->hti_key;
+}
+
+static void *hash_test_hop_object(struct hlist_node *hnode)
+{
+	return hlist_entry(hnode, struct hash_test_item, hti_hnode);
+}
+
+static void hash_test_hop_get(cfs_hash_t *hs, struct hlist_node *hnode)
+{
+	struct hash_test_item *hti;
+
+	hti = hlist_entry(hnode, struct hash_test_item, hti_hnode);
+	atomic_inc(&hti->hti_ref);
+}
+
+static int hash_test_hop_get_rcu(cfs_hash_t *hs, struct hlist_node *hnode)
+{
+	struct hash_test_item *hti;
+
+	hti = hlist_entry(hnode, struct hash_test_item, hti_hnode);
+	return atomic_inc_not_zero(&hti->hti_ref);
+}
+
+static void hash_test_hop_put(cfs_hash_t *hs, struct hlist_node *hnode)
+{
+	struct hash_test_item *hti;
+
+	hti = hlist_entry(hnode, struct hash_test_item, hti_hnode);
+	atomic_dec(&hti->hti_ref);
+}
+
+static cfs_hash_ops_t hash_test_ops = {
+	.hs_hash	= hash_test_hop_hash,
+	.hs_key		= hash_test_hop_key,
+	.hs_keycmp	= hash_test_hop_keycmp,
+	.hs_object	= hash_test_hop_object,
+	.hs_get		= hash_test_hop_get,
+	.hs_get_rcu	= hash_test_hop_get_rcu,
+	.hs_put_locked	= hash_test_hop_put,
+	.hs_put		= hash_test_hop_put,
+};
+
+static int hash_test_thread(void *arg)
+{
+	struct hash_test_ctl	*ctl = arg;
+	struct hash_test_item	*hti;
+	unsigned long		 seed = (unsigned long)current->pid;
+	__u64			 lookups = 0;
+	__u64			 key;
+	int			 i;
+
+	while (time_before(jiffies, ctl->htc_deadline)) {
+		for (i = 0; i < 256; i++) {
+			seed = seed * 1103515245 + 12345;
+			key = (seed >> 8) % hash_test_items;
+
+			hti = cfs_hash_lookup(ctl->htc_hs, &key);
+			LASSERT(hti != NULL && hti->hti_key == key);
+			cfs_hash_put(ctl->htc_hs, &hti->hti_hnode);
+		}
+		lookups += i;
+		cond_resched();
+	}
+
+	atomic64_add(lookups, &ctl->htc_lookups);
+	if (atomic_dec_and_test(&ctl->htc_nrunning))
+		complete(&ctl->htc_done);
+	return 0;
+}
+
+/* returns lookups per second of \a nthreads threads, or negative errno */
+static long long hash_test_run(cfs_hash_t *hs, unsigned int nthreads)
+{
+	struct hash_test_ctl	*ctl = &hash_test_ctl;
+	unsigned int		 i;
+
+	ctl->htc_hs = hs;
+	ctl->htc_deadline = jiffies + cfs_time_seconds(hash_test_seconds);
+	atomic_set(&ctl->htc_nrunning, nthreads);
+	atomic64_set(&ctl->htc_lookups, 0);
+	init_completion(&ctl->htc_done);
+
+	for (i = 0; i < nthreads; i++) {
+		if (!IS_ERR(kthread_run(hash_test_thread, ctl,
+					"hash_test_%02u", i)))
+			continue;
+
+		/* the started threads still have to finish */
+		CERROR("hash_test: can't start thread %u\n", i);
+		if (!atomic_sub_and_test(nthreads - i, &ctl->htc_nrunning))
+			wait_for_completion(&ctl->htc_done);
+		return -ECHILD;
+	}
+
+	wait_for_completion(&ctl->htc_done);
+	return atomic64_read(&ctl->htc_lookups) / hash_test_seconds;
+}
+
+static int hash_test_mode(const char *name, unsigned flags)
+{
+	cfs_hash_t	*hs;
+	long long	 rate;
+	unsigned int	 nthreads;
+	unsigned int	 i;
+	int		 rc = 0;
+
+	hs = cfs_hash_create((char *)name, HASH_TEST_BITS, HASH_TEST_BITS,
+			     HASH_TEST_BKT_BITS, 0, CFS_HASH_MIN_THETA,
+			     CFS_HASH_MAX_THETA, &hash_test_ops,
+			     CFS_HASH_SPIN_BKTLOCK | CFS_HASH_NO_ITEMREF |
+			     flags);
+	if (hs == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < hash_test_items; i++) {
+		hash_test_array[i].hti_key = i;
+		atomic_set(&hash_test_array[i].hti_ref, 1);
+		cfs_hash_add(hs, &hash_test_array[i].hti_key,
+			     &hash_test_array[i].hti_hnode);
+	}
+
+	for (nthreads = 1; ; nthreads = min(nthreads * 2, hash_test_threads)) {
+		rate = hash_test_run(hs, nthreads);
+		if (rate < 0) {
+			rc = rate;
+			break;
+		}
+		LCONSOLE_INFO("hash_test: %s, %u threads: %lld lookups/s\n",
+			      name, nthreads, rate);
+		if (nthreads == hash_test_threads)
+			break;
+	}
+
+	cfs_hash_putref(hs);
+	/* nothing is freed by RCU, but lockless lookups must be done with
+	 * the items before they are reused for the next mode */
+	synchronize_rcu();
+	return rc;
+}
+
+static int __init hash_test_init(void)
+{
+	int rc;
+
+	if (hash_test_threads == 0)
+		hash_test_threads = num_online_cpus();
+	if (hash_test_items == 0 || hash_test_seconds == 0)
+		return -EINVAL;
+
+	LIBCFS_ALLOC(hash_test_array,
+		     sizeof(*hash_test_array) * hash_test_items);
+	if (hash_test_array == NULL)
+		return -ENOMEM;
+
+	rc = hash_test_mode("hash_test_lock", 0);
+	if (rc == 0)
+		rc = hash_test_mode("hash_test_rcu", CFS_HASH_RCU);
+
+	LIBCFS_FREE(hash_test_array,
+		    sizeof(*hash_test_array) * hash_test_items);
+	return rc;
+}
+
+static void __exit hash_test_exit(void)
+{
+}
+
+MODULE_AUTHOR("Sun Microsystems, Inc. <http://www.lustre.org/>");
+MODULE_DESCRIPTION("cfs_hash lookup benchmark");
+MODULE_LICENSE("GPL");
+
+module_init(hash_test_init);
+module_exit(hash_test_exit);
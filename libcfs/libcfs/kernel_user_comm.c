@@ -114,6 +114,7 @@ int libcfs_ukuc_msg_get(lustre_kernelcomm *link, char *buf, int maxsize,
 {
         struct kuc_hdr *kuch;
         int rc = 0;
+	int len;
 
         memset(buf, 0, maxsize);
 
@@ -145,18 +146,29 @@ int libcfs_ukuc_msg_get(lustre_kernelcomm *link, char *buf, int maxsize,
                         break;
                 }
 
-                /* Read payload */
-                rc = read(link->lk_rfd, buf + lhsz, kuch->kuc_msglen - lhsz);
-                if (rc < 0) {
-                        rc = -errno;
-                        break;
-                }
-                if (rc < (kuch->kuc_msglen - lhsz)) {
-                        CERROR("short read: got %d of %d bytes\n",
-                               rc, kuch->kuc_msglen);
-                        rc = -EPROTO;
-                        break;
-                }
+		/* Read payload, messages larger than PIPE_BUF (changelog
+		 * batches) can be split by the pipe, so read until the whole
+		 * message is there */
+		for (len = lhsz; len < kuch->kuc_msglen; len += rc) {
+			rc = read(link->lk_rfd, buf + len,
+				  kuch->kuc_msglen - len);
+			if (rc < 0 && errno == EINTR) {
+				rc = 0;
+				continue;
+			}
+			if (rc < 0) {
+				rc = -errno;
+				break;
+			}
+			if (rc == 0) {
+				CERROR("short read: got %d of %d bytes\n",
+				       len, kuch->kuc_msglen);
+				rc = -EPROTO;
+				break;
+			}
+		}
+		if (rc < 0)
+			break;
 
                 if (kuch->kuc_transport == transport ||
                     kuch->kuc_transport == KUC_TRANSPORT_GENERIC) {
@@ -182,6 +182,26 @@ cfs_cpt_spread_node(struct cfs_cpt_table *cptab, int cpt)
 }
 EXPORT_SYMBOL(cfs_cpt_spread_node);
 
+void
+cfs_cpt_mem_account(struct cfs_cpt_table *cptab, int cpt, int node)
+{
+}
+EXPORT_SYMBOL(cfs_cpt_mem_account);
+
+int
+cfs_cpt_numa_print(struct cfs_cpt_table *cptab, char *buf, int len)
+{
+	int	rc;
+
+	rc = snprintf(buf, len, "%d\t: nodes 0 remote_alloc 0\n", 0);
+	len -= rc;
+	if (len <= 0)
+		return -EFBIG;
+
+	return rc;
+}
+EXPORT_SYMBOL(cfs_cpt_numa_print);
+
 int
 cfs_cpu_ht_nsiblings(int cpu)
 {
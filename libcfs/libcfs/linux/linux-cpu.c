@@ -271,6 +271,43 @@ cfs_cpt_table_print(struct cfs_cpt_table *cptab, char *buf, int len)
 }
 EXPORT_SYMBOL(cfs_cpt_table_print);
 
+int
+cfs_cpt_numa_print(struct cfs_cpt_table *cptab, char *buf, int len)
+{
+	char	*tmp = buf;
+	int	rc = 0;
+	int	i;
+	int	j;
+
+	for (i = 0; i < cptab->ctb_nparts; i++) {
+		struct cfs_cpu_partition *part = &cptab->ctb_parts[i];
+
+		rc = snprintf(tmp, len, "%d\t: nodes ", i);
+		len -= rc;
+		if (len <= 0)
+			return -EFBIG;
+		tmp += rc;
+
+		for_each_node_mask(j, *part->cpt_nodemask) {
+			rc = snprintf(tmp, len, "%d ", j);
+			len -= rc;
+			if (len <= 0)
+				return -EFBIG;
+			tmp += rc;
+		}
+
+		rc = snprintf(tmp, len, "remote_alloc %d\n",
+			      atomic_read(&part->cpt_mem_remote));
+		len -= rc;
+		if (len <= 0)
+			return -EFBIG;
+		tmp += rc;
+	}
+
+	return tmp - buf;
+}
+EXPORT_SYMBOL(cfs_cpt_numa_print);
+
 int
 cfs_cpt_number(struct cfs_cpt_table *cptab)
 {
@@ -576,6 +613,23 @@ cfs_cpt_spread_node(struct cfs_cpt_table *cptab, int cpt)
 }
 EXPORT_SYMBOL(cfs_cpt_spread_node);
 
+void
+cfs_cpt_mem_account(struct cfs_cpt_table *cptab, int cpt, int node)
+{
+	struct cfs_cpu_partition *part;
+
+	if (cpt < 0 || cpt >= cptab->ctb_nparts)
+		return;
+
+	part = &cptab->ctb_parts[cpt];
+	if (likely(node_isset(node, *part->cpt_nodemask)))
+		return;
+
+	/* the node is out of memory, or the partition has no memory */
+	atomic_inc(&part->cpt_mem_remote);
+}
+EXPORT_SYMBOL(cfs_cpt_mem_account);
+
 int
 cfs_cpt_current(struct cfs_cpt_table *cptab, int remap)
 {
@@ -726,12 +780,39 @@ cfs_cpt_choose_ncpus(struct cfs_cpt_table *cptab, int cpt,
 
 #define CPT_WEIGHT_MIN  4u
 
+/**
+ * Return number of online CPUs in each online NUMA node, or 0 if nodes
+ * have different number of CPUs.
+ */
+static unsigned int
+cfs_cpt_node_ncpus(void)
+{
+	unsigned int	ncpu = 0;
+	int		node;
+	int		cpu;
+
+	for_each_online_node(node) {
+		unsigned int n = 0;
+
+		for_each_online_cpu(cpu) {
+			if (cpu_to_node(cpu) == node)
+				n++;
+		}
+
+		if (ncpu != 0 && n != ncpu)
+			return 0;
+		ncpu = n;
+	}
+	return ncpu;
+}
+
 static unsigned int
 cfs_cpt_num_estimate(void)
 {
 	unsigned nnode = num_online_nodes();
 	unsigned ncpu  = num_online_cpus();
 	unsigned ncpt;
+	unsigned node_ncpu;
 
 	if (ncpu <= CPT_WEIGHT_MIN) {
 		ncpt = 1;
@@ -754,6 +835,18 @@ cfs_cpt_num_estimate(void)
 
 	ncpt = nnode;
 
+	/* don't let a partition straddle two NUMA nodes, otherwise threads
+	 * and memory of the partition can't be on the same node */
+	nnode = num_online_nodes();
+	node_ncpu = cfs_cpt_node_ncpus();
+	if (node_ncpu > 0 && ncpt > nnode && ncpt % nnode == 0) {
+		unsigned npart = ncpt / nnode;
+
+		while (node_ncpu % npart != 0)
+			npart--; /* worst case is 1 */
+		ncpt = npart * nnode;
+	}
+
  out:
 #if (BITS_PER_LONG == 32)
 	/* config many CPU partitions on 32-bit system could consume
@@ -1038,6 +1131,31 @@ static struct notifier_block cfs_cpu_notifier = {
 
 #endif
 
+/**
+ * Warn if a CPU partition covers part of a NUMA node and part of another,
+ * memory of this partition will be spread over these nodes.
+ */
+static void
+cfs_cpt_table_check_numa(struct cfs_cpt_table *cptab)
+{
+	int	nnode;
+	int	i;
+
+	if (num_online_nodes() == 1 ||
+	    cptab->ctb_nparts < num_online_nodes())
+		return;
+
+	for (i = 0; i < cptab->ctb_nparts; i++) {
+		nnode = nodes_weight(*cptab->ctb_parts[i].cpt_nodemask);
+		if (nnode > 1) {
+			CWARN("CPU partition %d spans %d NUMA nodes, please "
+			      "set cpu_npartitions to a multiple of %d or "
+			      "set cpu_pattern to match NUMA topology\n",
+			      i, nnode, num_online_nodes());
+		}
+	}
+}
+
 void
 cfs_cpu_fini(void)
 {
@@ -1096,6 +1214,8 @@ cfs_cpu_init(void)
 	}
 	spin_unlock(&cpt_data.cpt_lock);
 
+	cfs_cpt_table_check_numa(cfs_cpt_table);
+
 	LCONSOLE(0, "HW CPU cores: %d, npartitions: %d\n",
 		 num_online_cpus(), cfs_cpt_number(cfs_cpt_table));
 	return 0;
@@ -45,8 +45,12 @@ void *
 cfs_cpt_malloc(struct cfs_cpt_table *cptab, int cpt,
 	       size_t nr_bytes, gfp_t flags)
 {
-	return kmalloc_node(nr_bytes, flags,
-			    cfs_cpt_spread_node(cptab, cpt));
+	void	*ptr;
+
+	ptr = kmalloc_node(nr_bytes, flags, cfs_cpt_spread_node(cptab, cpt));
+	if (ptr != NULL)
+		cfs_cpt_mem_account(cptab, cpt, page_to_nid(virt_to_page(ptr)));
+	return ptr;
 }
 EXPORT_SYMBOL(cfs_cpt_malloc);
 
@@ -61,14 +65,25 @@ cfs_cpt_vzalloc(struct cfs_cpt_table *cptab, int cpt, size_t nr_bytes)
 	 * thread doing FS operations, that can also attempt conflicting FS
 	 * operations, ...
 	 */
-	return vzalloc_node(nr_bytes, cfs_cpt_spread_node(cptab, cpt));
+	void	*ptr;
+
+	ptr = vzalloc_node(nr_bytes, cfs_cpt_spread_node(cptab, cpt));
+	if (ptr != NULL) /* only check the first page */
+		cfs_cpt_mem_account(cptab, cpt,
+				    page_to_nid(vmalloc_to_page(ptr)));
+	return ptr;
 }
 EXPORT_SYMBOL(cfs_cpt_vzalloc);
 
 struct page *
 cfs_page_cpt_alloc(struct cfs_cpt_table *cptab, int cpt, gfp_t flags)
 {
-	return alloc_pages_node(cfs_cpt_spread_node(cptab, cpt), flags, 0);
+	struct page	*page;
+
+	page = alloc_pages_node(cfs_cpt_spread_node(cptab, cpt), flags, 0);
+	if (page != NULL)
+		cfs_cpt_mem_account(cptab, cpt, page_to_nid(page));
+	return page;
 }
 EXPORT_SYMBOL(cfs_page_cpt_alloc);
 
@@ -76,7 +91,12 @@ void *
 cfs_mem_cache_cpt_alloc(struct kmem_cache *cachep, struct cfs_cpt_table *cptab,
 			int cpt, gfp_t flags)
 {
-	return kmem_cache_alloc_node(cachep, flags,
-				     cfs_cpt_spread_node(cptab, cpt));
+	void	*ptr;
+
+	ptr = kmem_cache_alloc_node(cachep, flags,
+				    cfs_cpt_spread_node(cptab, cpt));
+	if (ptr != NULL)
+		cfs_cpt_mem_account(cptab, cpt, page_to_nid(virt_to_page(ptr)));
+	return ptr;
 }
 EXPORT_SYMBOL(cfs_mem_cache_cpt_alloc);
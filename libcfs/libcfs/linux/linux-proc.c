@@ -327,16 +327,13 @@ proc_fail_loc(struct ctl_table *table, int write, void __user *buffer,
 	return rc;
 }
 
-static int __proc_cpt_table(void *data, int write,
+static int __proc_cpt_print(int (*print)(struct cfs_cpt_table *, char *, int),
 			    loff_t pos, void __user *buffer, int nob)
 {
 	char *buf = NULL;
 	int   len = 4096;
 	int   rc  = 0;
 
-	if (write)
-		return -EPERM;
-
 	LASSERT(cfs_cpt_table != NULL);
 
 	while (1) {
@@ -344,7 +341,7 @@ static int __proc_cpt_table(void *data, int write,
 		if (buf == NULL)
 			return -ENOMEM;
 
-		rc = cfs_cpt_table_print(cfs_cpt_table, buf, len);
+		rc = print(cfs_cpt_table, buf, len);
 		if (rc >= 0)
 			break;
 
@@ -368,6 +365,15 @@ static int __proc_cpt_table(void *data, int write,
 	return rc;
 }
 
+static int __proc_cpt_table(void *data, int write,
+			    loff_t pos, void __user *buffer, int nob)
+{
+	if (write)
+		return -EPERM;
+
+	return __proc_cpt_print(cfs_cpt_table_print, pos, buffer, nob);
+}
+
 static int
 proc_cpt_table(struct ctl_table *table, int write, void __user *buffer,
 	       size_t *lenp, loff_t *ppos)
@@ -376,6 +382,23 @@ proc_cpt_table(struct ctl_table *table, int write, void __user *buffer,
 				     __proc_cpt_table);
 }
 
+static int __proc_cpt_numa(void *data, int write,
+			   loff_t pos, void __user *buffer, int nob)
+{
+	if (write)
+		return -EPERM;
+
+	return __proc_cpt_print(cfs_cpt_numa_print, pos, buffer, nob);
+}
+
+static int
+proc_cpt_numa(struct ctl_table *table, int write, void __user *buffer,
+	      size_t *lenp, loff_t *ppos)
+{
+	return lprocfs_call_handler(table->data, write, ppos, buffer, lenp,
+				     __proc_cpt_numa);
+}
+
 static struct ctl_table lnet_table[] = {
 	/*
 	 * NB No .strategy entries have been provided since sysctl(8) prefers
@@ -449,6 +472,13 @@ static struct ctl_table lnet_table[] = {
 		.mode		= 0444,
 		.proc_handler	= &proc_cpt_table,
 	},
+	{
+		INIT_CTL_NAME
+		.procname	= "cpu_partition_numa",
+		.maxlen		= 128,
+		.mode		= 0444,
+		.proc_handler	= &proc_cpt_numa,
+	},
 	{
 		INIT_CTL_NAME
 		.procname	= "upcall",
@@ -45,6 +45,7 @@
 #include "tracefile.h"
 
 #include <libcfs/libcfs.h>
+#include <linux/namei.h>
 
 /* XXX move things up to the top, comment */
 union cfs_trace_data_union (*cfs_trace_data[TCD_MAX_TYPES])[NR_CPUS] __cacheline_aligned;
@@ -52,6 +53,13 @@ union cfs_trace_data_union (*cfs_trace_data[TCD_MAX_TYPES])[NR_CPUS] __cacheline
 char cfs_tracefile[TRACEFILE_NAME_SIZE];
 long long cfs_tracefile_size = CFS_TRACEFILE_SIZE;
 static struct tracefiled_ctl trace_tctl;
+/* the file tracefiled writers share and its name, reopened under
+ * tracefiled_file_mutex, see tracefiled_file_get() */
+static DEFINE_MUTEX(tracefiled_file_mutex);
+static struct file *tracefiled_filp;
+static char tracefiled_file[TRACEFILE_NAME_SIZE];
+/* where the next page goes, reserved by the writers without a lock */
+static atomic64_t tracefiled_pos = ATOMIC64_INIT(0);
 struct mutex cfs_trace_thread_mutex;
 static int thread_running = 0;
 
@@ -542,6 +550,31 @@ static void collect_pages(struct page_collection *pc)
 		collect_pages_on_all_cpus(pc);
 }
 
+/* collect the pages of the CPUs writer \a idx of tracefiled writes */
+static void collect_writer_pages(struct page_collection *pc, int idx)
+{
+	struct cfs_trace_cpu_data *tcd;
+	int i, cpu;
+
+	INIT_LIST_HEAD(&pc->pc_pages);
+
+	if (libcfs_panic_in_progress) {
+		if (idx == 0)
+			panic_collect_pages(pc);
+		return;
+	}
+
+	for_each_possible_cpu(cpu) {
+		if (cpu % trace_tctl.tctl_nwriters != idx)
+			continue;
+
+		cfs_tcd_for_each_type_lock(tcd, i, cpu) {
+			list_splice_init(&tcd->tcd_pages, &pc->pc_pages);
+			tcd->tcd_cur_pages = 0;
+		}
+	}
+}
+
 static void put_pages_back_on_all_cpus(struct page_collection *pc)
 {
         struct cfs_trace_cpu_data *tcd;
@@ -611,13 +644,33 @@ static void put_pages_on_tcd_daemon_list(struct page_collection *pc,
 
 static void put_pages_on_daemon_list(struct page_collection *pc)
 {
-        struct cfs_trace_cpu_data *tcd;
-        int i, cpu;
+	struct cfs_trace_cpu_data *tcd;
+	struct cfs_trace_page	  *tage;
+	struct page_collection	   run;
+
+	/* collect_pages() splices the pages of each tcd as one run.  Hand
+	 * them back a run at a time, so each tcd is locked once and the
+	 * collection is walked once, instead of walking the whole collection
+	 * under the lock of every tcd on the system. */
+	INIT_LIST_HEAD(&run.pc_pages);
+	while (!list_empty(&pc->pc_pages)) {
+		tage = cfs_tage_from_list(pc->pc_pages.next);
+		__LASSERT_TAGE_INVARIANT(tage);
+		tcd = &(*cfs_trace_data[tage->type])[tage->cpu].tcd;
 
-	for_each_possible_cpu(cpu) {
-                cfs_tcd_for_each_type_lock(tcd, i, cpu)
-                        put_pages_on_tcd_daemon_list(pc, tcd);
-        }
+		do {
+			list_move_tail(&tage->linkage, &run.pc_pages);
+			if (list_empty(&pc->pc_pages))
+				break;
+			tage = cfs_tage_from_list(pc->pc_pages.next);
+		} while (tage->cpu == tcd->tcd_cpu &&
+			 tage->type == tcd->tcd_type);
+
+		cfs_trace_lock_tcd(tcd, 1);
+		put_pages_on_tcd_daemon_list(&run, tcd);
+		cfs_trace_unlock_tcd(tcd, 1);
+		__LASSERT(list_empty(&run.pc_pages));
+	}
 }
 
 void cfs_trace_debug_print(void)
@@ -945,13 +998,119 @@ int cfs_trace_get_debug_mb(void)
 	return (total_pages >> (20 - PAGE_CACHE_SHIFT)) + 1;
 }
 
+/* check whether the file tracefiled writes to is still found at its path */
+static bool tracefiled_file_moved(void)
+{
+	struct path path;
+	bool moved;
+
+	if (kern_path(tracefiled_file, LOOKUP_FOLLOW, &path) != 0)
+		return true;
+
+	moved = path.dentry->d_inode != tracefiled_filp->f_dentry->d_inode;
+	path_put(&path);
+
+	return moved;
+}
+
+/* drop the file tracefiled writes to, the next pass opens it again */
+static void tracefiled_file_close(void)
+{
+	if (tracefiled_filp != NULL) {
+		filp_close(tracefiled_filp, NULL);
+		tracefiled_filp = NULL;
+	}
+	tracefiled_file[0] = '\0';
+}
+
+/*
+ * Get a reference on the file tracefiled writes to.
+ *
+ * The file stays open between the passes of the writers. It's reopened when
+ * the daemon has been pointed to another file, or when the file behind the
+ * path changed: a file which was removed or rotated would keep the output
+ * otherwise. Writing continues at the end of the new file.
+ */
+static struct file *tracefiled_file_get(void)
+{
+	struct file *filp = NULL;
+	int rc;
+
+	mutex_lock(&tracefiled_file_mutex);
+	cfs_tracefile_read_lock();
+	if (tracefiled_filp != NULL &&
+	    (strcmp(cfs_tracefile, tracefiled_file) != 0 ||
+	     tracefiled_file_moved()))
+		tracefiled_file_close();
+
+	if (tracefiled_filp == NULL && cfs_tracefile[0] != 0) {
+		filp = filp_open(cfs_tracefile,
+				 O_CREAT | O_RDWR | O_LARGEFILE, 0600);
+		if (IS_ERR(filp)) {
+			rc = PTR_ERR(filp);
+			filp = NULL;
+			printk(KERN_WARNING "couldn't open %s: %d\n",
+			       cfs_tracefile, rc);
+		} else {
+			tracefiled_filp = filp;
+			strcpy(tracefiled_file, cfs_tracefile);
+			if (atomic64_read(&tracefiled_pos) > filp_size(filp))
+				atomic64_set(&tracefiled_pos, filp_size(filp));
+		}
+	}
+	cfs_tracefile_read_unlock();
+
+	filp = tracefiled_filp;
+	if (filp != NULL)
+		get_file(filp);
+	mutex_unlock(&tracefiled_file_mutex);
+
+	return filp;
+}
+
+/* release a reference got by tracefiled_file_get(), a failed write makes
+ * the next pass reopen the file */
+static void tracefiled_file_put(struct file *filp, int error)
+{
+	if (error != 0) {
+		mutex_lock(&tracefiled_file_mutex);
+		if (tracefiled_filp == filp)
+			tracefiled_file_close();
+		mutex_unlock(&tracefiled_file_mutex);
+	}
+	fput(filp);
+}
+
+/* reserve \a len bytes of the file, wrapping at cfs_tracefile_size */
+static loff_t tracefiled_reserve(unsigned int len)
+{
+	loff_t pos;
+	loff_t next;
+
+	do {
+		pos = atomic64_read(&tracefiled_pos);
+		next = pos >= (loff_t)cfs_tracefile_size ? 0 : pos;
+	} while (atomic64_cmpxchg(&tracefiled_pos, pos, next + len) != pos);
+
+	return next;
+}
+
+/*
+ * Debug daemon writer thread.
+ *
+ * Every writer collects and writes the pages of its share of the CPUs, so
+ * the writers only contend on the tcd locks of their own CPUs. They share
+ * the file and reserve the range each page goes to with a cmpxchg, the pages
+ * of different CPUs are interleaved as they were with a single writer.
+ */
 static int tracefiled(void *arg)
 {
 	struct page_collection pc;
-	struct tracefiled_ctl *tctl = arg;
+	struct tracefiled_ctl *tctl = &trace_tctl;
 	struct cfs_trace_page *tage;
 	struct cfs_trace_page *tmp;
 	struct file *filp;
+	int idx = (long)arg;
 	int last_loop = 0;
 	int rc;
 
@@ -965,43 +1124,27 @@ static int tracefiled(void *arg)
 	while (1) {
 		wait_queue_t __wait;
 
-                pc.pc_want_daemon_pages = 0;
-                collect_pages(&pc);
+		pc.pc_want_daemon_pages = 0;
+		collect_writer_pages(&pc, idx);
 		if (list_empty(&pc.pc_pages))
-                        goto end_loop;
-
-                filp = NULL;
-                cfs_tracefile_read_lock();
-                if (cfs_tracefile[0] != 0) {
-			filp = filp_open(cfs_tracefile,
-					 O_CREAT | O_RDWR | O_LARGEFILE,
-					 0600);
-			if (IS_ERR(filp)) {
-				rc = PTR_ERR(filp);
-				filp = NULL;
-				printk(KERN_WARNING "couldn't open %s: "
-				       "%d\n", cfs_tracefile, rc);
-			}
-		}
-                cfs_tracefile_read_unlock();
-                if (filp == NULL) {
-                        put_pages_on_daemon_list(&pc);
+			goto end_loop;
+
+		filp = tracefiled_file_get();
+		if (filp == NULL) {
+			put_pages_on_daemon_list(&pc);
 			__LASSERT(list_empty(&pc.pc_pages));
-                        goto end_loop;
-                }
+			goto end_loop;
+		}
 
+		rc = 0;
 		MMSPACE_OPEN;
 
 		list_for_each_entry_safe(tage, tmp, &pc.pc_pages, linkage) {
-                        static loff_t f_pos;
+			loff_t f_pos;
 
-                        __LASSERT_TAGE_INVARIANT(tage);
-
-                        if (f_pos >= (off_t)cfs_tracefile_size)
-                                f_pos = 0;
-			else if (f_pos > (off_t)filp_size(filp))
-				f_pos = filp_size(filp);
+			__LASSERT_TAGE_INVARIANT(tage);
 
+			f_pos = tracefiled_reserve(tage->used);
 			rc = filp_write(filp, page_address(tage->page),
 					tage->used, &f_pos);
 			if (rc != (int)tage->used) {
@@ -1009,15 +1152,17 @@ static int tracefiled(void *arg)
 				       "but wrote %d\n", tage->used, rc);
 				put_pages_back(&pc);
 				__LASSERT(list_empty(&pc.pc_pages));
+				rc = -EIO;
 				break;
 			}
-                }
+			rc = 0;
+		}
 		MMSPACE_CLOSE;
 
-		filp_close(filp, NULL);
-                put_pages_on_daemon_list(&pc);
+		tracefiled_file_put(filp, rc);
+		put_pages_on_daemon_list(&pc);
 		if (!list_empty(&pc.pc_pages)) {
-                        int i;
+			int i;
 
 			printk(KERN_ALERT "Lustre: trace pages aren't "
 			       " empty\n");
@@ -1054,15 +1199,18 @@ end_loop:
 		waitq_timedwait(&__wait, TASK_INTERRUPTIBLE,
 				cfs_time_seconds(1));
 		remove_wait_queue(&tctl->tctl_waitq, &__wait);
-        }
-	complete(&tctl->tctl_stop);
-        return 0;
+	}
+
+	if (atomic_dec_and_test(&tctl->tctl_nrunning))
+		complete(&tctl->tctl_stop);
+	return 0;
 }
 
 int cfs_trace_start_thread(void)
 {
-        struct tracefiled_ctl *tctl = &trace_tctl;
-        int rc = 0;
+	struct tracefiled_ctl *tctl = &trace_tctl;
+	int rc = 0;
+	int i;
 
 	mutex_lock(&cfs_trace_thread_mutex);
         if (thread_running)
@@ -1072,13 +1220,29 @@ int cfs_trace_start_thread(void)
 	init_completion(&tctl->tctl_stop);
 	init_waitqueue_head(&tctl->tctl_waitq);
 	atomic_set(&tctl->tctl_shutdown, 0);
+	tctl->tctl_nwriters = min_t(int, num_online_cpus(),
+				    TRACEFILED_MAX_WRITERS);
+	atomic_set(&tctl->tctl_nrunning, tctl->tctl_nwriters);
 
-	if (IS_ERR(kthread_run(tracefiled, tctl, "ktracefiled"))) {
-		rc = -ECHILD;
-		goto out;
+	for (i = 0; i < tctl->tctl_nwriters; i++) {
+		if (!IS_ERR(kthread_run(tracefiled, (void *)(long)i,
+					"ktracefiled_%02d", i)))
+			continue;
+
+		/* the CPUs of the missing writers are left to the others */
+		if (i == 0) {
+			rc = -ECHILD;
+			goto out;
+		}
+		printk(KERN_WARNING "Lustre: started %d of %d debug daemon "
+		       "writers\n", i, tctl->tctl_nwriters);
+		atomic_sub(tctl->tctl_nwriters - i, &tctl->tctl_nrunning);
+		tctl->tctl_nwriters = i;
+		break;
 	}
 
-	wait_for_completion(&tctl->tctl_start);
+	for (i = 0; i < tctl->tctl_nwriters; i++)
+		wait_for_completion(&tctl->tctl_start);
 	thread_running = 1;
 out:
 	mutex_unlock(&cfs_trace_thread_mutex);
@@ -1096,6 +1260,10 @@ void cfs_trace_stop_thread(void)
 		atomic_set(&tctl->tctl_shutdown, 1);
 		wait_for_completion(&tctl->tctl_stop);
 		thread_running = 0;
+
+		mutex_lock(&tracefiled_file_mutex);
+		tracefiled_file_close();
+		mutex_unlock(&tracefiled_file_mutex);
 	}
 	mutex_unlock(&cfs_trace_thread_mutex);
 }
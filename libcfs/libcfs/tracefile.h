@@ -228,8 +228,15 @@ struct tracefiled_ctl {
 	wait_queue_head_t	tctl_waitq;
 	pid_t			tctl_pid;
 	atomic_t		tctl_shutdown;
+	/* writer threads, each one writes the pages of every
+	 * tctl_nwriters-th CPU */
+	int			tctl_nwriters;
+	atomic_t		tctl_nrunning;
 };
 
+/* at most one debug daemon writer thread per CPU */
+#define TRACEFILED_MAX_WRITERS	64
+
 /*
  * small data-structure for each page owned by tracefiled.
  */
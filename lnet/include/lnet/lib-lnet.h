@@ -424,6 +424,22 @@ lnet_msg_free (lnet_msg_t *msg)
 
 #else /* !LNET_USE_LIB_FREELIST */
 
+/*
+ * MEs, messages and MDs with a single fragment are allocated from dedicated
+ * slab caches: they are the objects allocated on every send/receive, and the
+ * per-CPU slab freelists avoid the general purpose allocator on the fast
+ * path and keep the objects cacheline aligned.
+ */
+#define LNET_SMALL_MD_SIZE	offsetof(lnet_libmd_t, md_iov.iov[1])
+
+extern struct kmem_cache *lnet_mes_cachep;	  /* MEs kmem_cache */
+extern struct kmem_cache *lnet_msgs_cachep;	  /* messages kmem_cache */
+extern struct kmem_cache *lnet_small_mds_cachep;  /* <= LNET_SMALL_MD_SIZE
+						   * bytes MDs kmem_cache */
+
+int lnet_slab_setup(void);
+void lnet_slab_cleanup(void);
+
 static inline lnet_eq_t *
 lnet_eq_alloc (void)
 {
@@ -441,24 +457,37 @@ lnet_eq_free(lnet_eq_t *eq)
 	LIBCFS_FREE(eq, sizeof(*eq));
 }
 
+static inline unsigned int
+lnet_md_size(unsigned int options, unsigned int niov)
+{
+	if ((options & LNET_MD_KIOV) != 0)
+		return offsetof(lnet_libmd_t, md_iov.kiov[niov]);
+	else
+		return offsetof(lnet_libmd_t, md_iov.iov[niov]);
+}
+
 static inline lnet_libmd_t *
 lnet_md_alloc (lnet_md_t *umd)
 {
-        /* NEVER called with liblock held */
-        lnet_libmd_t *md;
-        unsigned int  size;
-        unsigned int  niov;
-
-        if ((umd->options & LNET_MD_KIOV) != 0) {
-                niov = umd->length;
-                size = offsetof(lnet_libmd_t, md_iov.kiov[niov]);
-        } else {
-                niov = ((umd->options & LNET_MD_IOVEC) != 0) ?
-                       umd->length : 1;
-                size = offsetof(lnet_libmd_t, md_iov.iov[niov]);
-        }
+	/* NEVER called with liblock held */
+	lnet_libmd_t *md;
+	unsigned int  size;
+	unsigned int  niov;
 
-        LIBCFS_ALLOC(md, size);
+	if ((umd->options & LNET_MD_KIOV) != 0)
+		niov = umd->length;
+	else
+		niov = ((umd->options & LNET_MD_IOVEC) != 0) ?
+		       umd->length : 1;
+	size = lnet_md_size(umd->options, niov);
+
+	if (size <= LNET_SMALL_MD_SIZE) {
+		md = kmem_cache_zalloc(lnet_small_mds_cachep, GFP_NOFS);
+		if (md == NULL)
+			CERROR("LNET: out of memory allocating small MD\n");
+	} else {
+		LIBCFS_ALLOC(md, size);
+	}
 
 	if (md != NULL) {
 		/* Set here in case of early free */
@@ -476,41 +505,45 @@ lnet_md_free(lnet_libmd_t *md)
 	/* ALWAYS called with resource lock held */
 	unsigned int  size;
 
-	if ((md->md_options & LNET_MD_KIOV) != 0)
-		size = offsetof(lnet_libmd_t, md_iov.kiov[md->md_niov]);
+	size = lnet_md_size(md->md_options, md->md_niov);
+	if (size <= LNET_SMALL_MD_SIZE)
+		kmem_cache_free(lnet_small_mds_cachep, md);
 	else
-		size = offsetof(lnet_libmd_t, md_iov.iov[md->md_niov]);
-
-	LIBCFS_FREE(md, size);
+		LIBCFS_FREE(md, size);
 }
 
 static inline lnet_me_t *
 lnet_me_alloc (void)
 {
-        /* NEVER called with liblock held */
-        lnet_me_t *me;
+	/* NEVER called with liblock held */
+	lnet_me_t *me;
+
+	me = kmem_cache_zalloc(lnet_mes_cachep, GFP_NOFS);
+	if (me == NULL)
+		CERROR("LNET: out of memory allocating ME\n");
 
-        LIBCFS_ALLOC(me, sizeof(*me));
-        return (me);
+	return me;
 }
 
 static inline void
 lnet_me_free(lnet_me_t *me)
 {
 	/* ALWAYS called with resource lock held */
-	LIBCFS_FREE(me, sizeof(*me));
+	kmem_cache_free(lnet_mes_cachep, me);
 }
 
 static inline lnet_msg_t *
 lnet_msg_alloc(void)
 {
-        /* NEVER called with liblock held */
-        lnet_msg_t *msg;
+	/* NEVER called with liblock held */
+	lnet_msg_t *msg;
 
-        LIBCFS_ALLOC(msg, sizeof(*msg));
+	/* zeroed: NULL pointers, clear flags etc */
+	msg = kmem_cache_zalloc(lnet_msgs_cachep, GFP_NOFS);
+	if (msg == NULL)
+		CERROR("LNET: out of memory allocating message\n");
 
-        /* no need to zero, LIBCFS_ALLOC does for us */
-        return (msg);
+	return msg;
 }
 
 static inline void
@@ -518,7 +551,7 @@ lnet_msg_free(lnet_msg_t *msg)
 {
 	/* ALWAYS called with network lock held */
 	LASSERT(!msg->msg_onactivelist);
-	LIBCFS_FREE(msg, sizeof(*msg));
+	kmem_cache_free(lnet_msgs_cachep, msg);
 }
 
 #define lnet_eq_free_locked(eq)		lnet_eq_free(eq)
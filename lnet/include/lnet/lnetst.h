@@ -71,6 +71,7 @@
 #define LSTIO_TEST_ADD          0xC26           /* add test (to batch) */
 #define LSTIO_BATCH_QUERY       0xC27           /* query batch status */
 #define LSTIO_STAT_QUERY        0xC30           /* get stats */
+#define LSTIO_LAT_QUERY         0xC31           /* get latency histograms */
 
 typedef struct {
         lnet_nid_t              ses_nid;                /* nid of console node */
@@ -517,4 +518,50 @@ typedef struct {
         __u32 ping_errors;
 } WIRE_ATTR sfw_counters_t;
 
+/*
+ * Latency of test RPCs, measured by test clients from posting the request
+ * to completion of the RPC.  Buckets are log-linear: the microseconds below
+ * 2 * LST_LAT_HIST_SUB have a bucket each, above that every power-of-two
+ * range is split into LST_LAT_HIST_SUB linear sub-buckets, so a bucket is at
+ * most 1/LST_LAT_HIST_SUB of its lower bound wide.  The last bucket has no
+ * upper bound, it starts at 7 * 2^24 microseconds (~117 seconds).  Counters
+ * are cumulative since the session was created.
+ */
+#define LST_LAT_HIST_SUB_BITS	2
+#define LST_LAT_HIST_SUB	(1 << LST_LAT_HIST_SUB_BITS)
+#define LST_LAT_HIST_NBUCKETS	104
+
+typedef struct {
+	__u32 lh_max_usec;		/* slowest RPC */
+	__u32 lh_buckets[LST_LAT_HIST_NBUCKETS];
+} WIRE_ATTR sfw_lat_hist_t;
+
+static inline int
+sfw_lat_hist_bucket(__u64 usec)
+{
+	int shift = 0;
+	int i;
+
+	while (usec >= 2 * LST_LAT_HIST_SUB) {
+		usec >>= 1;
+		shift++;
+	}
+
+	i = shift * LST_LAT_HIST_SUB + (int)usec;
+	return i < LST_LAT_HIST_NBUCKETS ? i : LST_LAT_HIST_NBUCKETS - 1;
+}
+
+/* lowest latency in usec accounted in bucket \a i */
+static inline __u64
+sfw_lat_hist_lower(int i)
+{
+	int shift;
+
+	if (i < 2 * LST_LAT_HIST_SUB)
+		return i;
+
+	shift = i / LST_LAT_HIST_SUB - 1;
+	return (__u64)(i % LST_LAT_HIST_SUB + LST_LAT_HIST_SUB) << shift;
+}
+
 #endif
@@ -458,7 +458,58 @@ lnet_counters_reset(void)
 }
 EXPORT_SYMBOL(lnet_counters_reset);
 
-#ifdef LNET_USE_LIB_FREELIST
+#ifndef LNET_USE_LIB_FREELIST
+
+struct kmem_cache *lnet_mes_cachep;		/* MEs kmem_cache */
+struct kmem_cache *lnet_msgs_cachep;		/* messages kmem_cache */
+struct kmem_cache *lnet_small_mds_cachep;	/* <= LNET_SMALL_MD_SIZE bytes
+						 * MDs kmem_cache */
+
+int
+lnet_slab_setup(void)
+{
+	lnet_mes_cachep = kmem_cache_create("lnet_MEs", sizeof(lnet_me_t),
+					    0, SLAB_HWCACHE_ALIGN, NULL);
+	if (lnet_mes_cachep == NULL)
+		goto failed;
+
+	lnet_msgs_cachep = kmem_cache_create("lnet_msgs", sizeof(lnet_msg_t),
+					     0, SLAB_HWCACHE_ALIGN, NULL);
+	if (lnet_msgs_cachep == NULL)
+		goto failed;
+
+	lnet_small_mds_cachep = kmem_cache_create("lnet_small_MDs",
+						  LNET_SMALL_MD_SIZE, 0,
+						  SLAB_HWCACHE_ALIGN, NULL);
+	if (lnet_small_mds_cachep == NULL)
+		goto failed;
+
+	return 0;
+failed:
+	lnet_slab_cleanup();
+	return -ENOMEM;
+}
+
+void
+lnet_slab_cleanup(void)
+{
+	if (lnet_small_mds_cachep != NULL) {
+		kmem_cache_destroy(lnet_small_mds_cachep);
+		lnet_small_mds_cachep = NULL;
+	}
+
+	if (lnet_msgs_cachep != NULL) {
+		kmem_cache_destroy(lnet_msgs_cachep);
+		lnet_msgs_cachep = NULL;
+	}
+
+	if (lnet_mes_cachep != NULL) {
+		kmem_cache_destroy(lnet_mes_cachep);
+		lnet_mes_cachep = NULL;
+	}
+}
+
+#else /* LNET_USE_LIB_FREELIST */
 
 int
 lnet_freelist_init(lnet_freelist_t *fl, int n, int size)
@@ -1665,6 +1716,15 @@ LNetInit(void)
 		return -1;
 	}
 
+#ifndef LNET_USE_LIB_FREELIST
+	rc = lnet_slab_setup();
+	if (rc != 0) {
+		CERROR("Can't create LNet slab caches: %d\n", rc);
+		lnet_destroy_locks();
+		return -1;
+	}
+#endif
+
 	the_lnet.ln_refcount = 0;
 	the_lnet.ln_init = 1;
 	LNetInvalidateHandle(&the_lnet.ln_rc_eqh);
@@ -1718,6 +1778,9 @@ LNetFini(void)
 	while (!list_empty(&the_lnet.ln_lnds))
 		lnet_unregister_lnd(list_entry(the_lnet.ln_lnds.next,
 					       lnd_t, lnd_list));
+#ifndef LNET_USE_LIB_FREELIST
+	lnet_slab_cleanup();
+#endif
 	lnet_destroy_locks();
 
 	the_lnet.ln_init = 0;
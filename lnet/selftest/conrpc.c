@@ -232,6 +232,9 @@ lstcon_rpc_trans_name(int transop)
         if (transop == LST_TRANS_STATQRY)
                 return "STATQRY";
 
+	if (transop == LST_TRANS_LATQRY)
+		return "LATQRY";
+
         return "Unknown";
 }
 
@@ -704,6 +707,24 @@ lstcon_statrpc_prep(lstcon_node_t *nd, unsigned feats, lstcon_rpc_t **crpc)
         return 0;
 }
 
+int
+lstcon_latrpc_prep(lstcon_node_t *nd, unsigned feats, __u32 first,
+		   lstcon_rpc_t **crpc)
+{
+	srpc_lat_reqst_t *lrq;
+	int		  rc;
+
+	rc = lstcon_rpc_prep(nd, SRPC_SERVICE_QUERY_LAT, feats, 0, 0, crpc);
+	if (rc != 0)
+		return rc;
+
+	lrq = &(*crpc)->crp_rpc->crpc_reqstmsg.msg_body.lat_reqst;
+	lrq->lat_sid = console_session.ses_id;
+	lrq->lat_first = first;
+
+	return 0;
+}
+
 static lnet_process_id_packed_t *
 lstcon_next_id(int idx, int nkiov, lnet_kiov_t *kiov)
 {
@@ -973,6 +994,7 @@ lstcon_rpc_stat_reply(lstcon_rpc_trans_t *trans, srpc_msg_t *msg,
         srpc_batch_reply_t *bat_rep;
         srpc_test_reply_t  *test_rep;
         srpc_stat_reply_t  *stat_rep;
+	srpc_lat_reply_t   *lat_rep;
         int                 rc = 0;
 
 	switch (trans->tas_opc) {
@@ -1074,6 +1096,18 @@ lstcon_rpc_stat_reply(lstcon_rpc_trans_t *trans, srpc_msg_t *msg,
                 rc = stat_rep->str_status;
                 break;
 
+	case LST_TRANS_LATQRY:
+		lat_rep = &msg->msg_body.lat_reply;
+
+		if (lat_rep->lat_status == 0) {
+			lstcon_statqry_stat_success(stat, 1);
+			return;
+		}
+
+		lstcon_statqry_stat_failure(stat, 1);
+		rc = lat_rep->lat_status;
+		break;
+
         default:
                 LBUG();
         }
@@ -1145,6 +1179,10 @@ lstcon_rpc_trans_ndlist(struct list_head *ndlist,
 		case LST_TRANS_STATQRY:
 			rc = lstcon_statrpc_prep(nd, feats, &rpc);
                         break;
+		case LST_TRANS_LATQRY:
+			rc = lstcon_latrpc_prep(nd, feats, *(__u32 *)arg,
+						&rpc);
+			break;
                 default:
                         rc = -EINVAL;
                         break;
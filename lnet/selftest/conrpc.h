@@ -110,6 +110,7 @@ typedef struct lstcon_rpc_trans {
 #define LST_TRANS_TSBSRVQRY     0x16
 
 #define LST_TRANS_STATQRY       0x21
+#define LST_TRANS_LATQRY        0x22
 
 typedef int (* lstcon_rpc_cond_func_t)(int, struct lstcon_node *, void *);
 typedef int (*lstcon_rpc_readent_func_t)(int, srpc_msg_t *,
@@ -125,6 +126,8 @@ int  lstcon_testrpc_prep(struct lstcon_node *nd, int transop, unsigned version,
                          struct lstcon_test *test, lstcon_rpc_t **crpc);
 int  lstcon_statrpc_prep(struct lstcon_node *nd, unsigned version,
 			 lstcon_rpc_t **crpc);
+int  lstcon_latrpc_prep(struct lstcon_node *nd, unsigned version,
+			__u32 first, lstcon_rpc_t **crpc);
 void lstcon_rpc_put(lstcon_rpc_t *crpc);
 int  lstcon_rpc_trans_prep(struct list_head *translist,
 			   int transop, lstcon_rpc_trans_t **transpp);
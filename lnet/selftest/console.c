@@ -1507,33 +1507,74 @@ lstcon_statrpc_readent(int transop, srpc_msg_t *msg,
 }
 
 static int
-lstcon_ndlist_stat(struct list_head *ndlist,
+lstcon_latrpc_readent(int transop, srpc_msg_t *msg,
+		      lstcon_rpc_ent_t __user *ent_up)
+{
+	srpc_lat_reply_t      *rep = &msg->msg_body.lat_reply;
+	sfw_lat_hist_t __user *lh_up;
+
+	if (rep->lat_status != 0)
+		return 0;
+
+	if (rep->lat_first >= LST_LAT_HIST_NBUCKETS)
+		return -EPROTO;
+
+	/* the pages of a histogram are read by successive transactions */
+	lh_up = (sfw_lat_hist_t __user *)&ent_up->rpe_payload[0];
+	if (copy_to_user(&lh_up->lh_max_usec, &rep->lat_max_usec,
+			 sizeof(rep->lat_max_usec)) ||
+	    copy_to_user(&lh_up->lh_buckets[rep->lat_first],
+			 &rep->lat_buckets[0], sizeof(rep->lat_buckets)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int
+lstcon_ndlist_stat(struct list_head *ndlist, int transop,
 		   int timeout, struct list_head __user *result_up)
 {
 	struct list_head    head;
 	lstcon_rpc_trans_t *trans;
+	__u32		    first = 0;
 	int		    rc;
 
+	LASSERT(transop == LST_TRANS_STATQRY || transop == LST_TRANS_LATQRY);
+
 	INIT_LIST_HEAD(&head);
 
-        rc = lstcon_rpc_trans_ndlist(ndlist, &head,
-                                     LST_TRANS_STATQRY, NULL, NULL, &trans);
-        if (rc != 0) {
-                CERROR("Can't create transaction: %d\n", rc);
-                return rc;
-        }
+	/* a latency histogram is read a page at a time */
+	do {
+		rc = lstcon_rpc_trans_ndlist(ndlist, &head, transop, &first,
+					     NULL, &trans);
+		if (rc != 0) {
+			CERROR("Can't create transaction: %d\n", rc);
+			return rc;
+		}
 
-        lstcon_rpc_trans_postwait(trans, LST_VALIDATE_TIMEOUT(timeout));
+		lstcon_rpc_trans_postwait(trans,
+					  LST_VALIDATE_TIMEOUT(timeout));
 
-        rc = lstcon_rpc_trans_interpreter(trans, result_up,
-                                          lstcon_statrpc_readent);
-        lstcon_rpc_trans_destroy(trans);
+		rc = lstcon_rpc_trans_interpreter(trans, result_up,
+						  transop == LST_TRANS_STATQRY ?
+						  lstcon_statrpc_readent :
+						  lstcon_latrpc_readent);
+		lstcon_rpc_trans_destroy(trans);
 
-        return rc;
+		/* a failed node reports its error instead of a histogram */
+		if (rc != 0 || transop != LST_TRANS_LATQRY ||
+		    lstcon_trans_stat()->trs_rpc_errno != 0 ||
+		    lstcon_trans_stat()->trs_fwk_errno != 0)
+			break;
+
+		first += SRPC_LAT_PAGE_NBUCKETS;
+	} while (first < LST_LAT_HIST_NBUCKETS);
+
+	return rc;
 }
 
 int
-lstcon_group_stat(char *grp_name, int timeout,
+lstcon_group_stat(char *grp_name, int transop, int timeout,
 		  struct list_head __user *result_up)
 {
         lstcon_group_t     *grp;
@@ -1545,7 +1586,8 @@ lstcon_group_stat(char *grp_name, int timeout,
                 return rc;
         }
 
-        rc = lstcon_ndlist_stat(&grp->grp_ndl_list, timeout, result_up);
+	rc = lstcon_ndlist_stat(&grp->grp_ndl_list, transop,
+				timeout, result_up);
 
         lstcon_group_put(grp);
 
@@ -1553,7 +1595,7 @@ lstcon_group_stat(char *grp_name, int timeout,
 }
 
 int
-lstcon_nodes_stat(int count, lnet_process_id_t __user *ids_up,
+lstcon_nodes_stat(int count, lnet_process_id_t __user *ids_up, int transop,
 		  int timeout, struct list_head __user *result_up)
 {
         lstcon_ndlink_t         *ndl;
@@ -1589,7 +1631,8 @@ lstcon_nodes_stat(int count, lnet_process_id_t __user *ids_up,
                 return rc;
         }
 
-        rc = lstcon_ndlist_stat(&tmp->grp_ndl_list, timeout, result_up);
+	rc = lstcon_ndlist_stat(&tmp->grp_ndl_list, transop,
+				timeout, result_up);
 
         lstcon_group_put(tmp);
 
@@ -244,10 +244,11 @@ extern int lstcon_batch_list(int idx, int namelen, char __user *name_up);
 extern int lstcon_batch_info(char *name, lstcon_test_batch_ent_t __user *ent_up,
 			     int server, int testidx, int *index_p,
 			     int *ndent_p, lstcon_node_ent_t __user *dents_up);
-extern int lstcon_group_stat(char *grp_name, int timeout,
+extern int lstcon_group_stat(char *grp_name, int transop, int timeout,
 			     struct list_head __user *result_up);
 extern int lstcon_nodes_stat(int count, lnet_process_id_t __user *ids_up,
-			     int timeout, struct list_head __user *result_up);
+			     int transop, int timeout,
+			     struct list_head __user *result_up);
 extern int lstcon_test_add(char *batch_name, int type, int loop,
 			   int concur, int dist, int span,
 			   char *src_name, char *dst_name,
@@ -85,6 +85,16 @@ do {                                    \
         __swab64s(&(rc).bulk_put);      \
 } while (0)
 
+#define sfw_unpack_lat_page(rep)                        \
+do {                                                    \
+	int __i;                                        \
+                                                        \
+	__swab32s(&(rep)->lat_max_usec);                \
+	__swab32s(&(rep)->lat_first);                   \
+	for (__i = 0; __i < SRPC_LAT_PAGE_NBUCKETS; __i++) \
+		__swab32s(&(rep)->lat_buckets[__i]);    \
+} while (0)
+
 #define sfw_unpack_lnet_counters(lc)    \
 do {                                    \
         __swab32s(&(lc).errors);        \
@@ -435,13 +445,73 @@ sfw_get_stats (srpc_stat_reqst_t *request, srpc_stat_reply_t *reply)
 	return 0;
 }
 
+/* merge a page of the latency histograms of all CPU partitions */
+static int
+sfw_get_lat_hist(srpc_lat_reqst_t *request, srpc_lat_reply_t *reply)
+{
+	sfw_session_t	    *sn = sfw_data.fw_session;
+	struct sfw_lat_part *part;
+	__u32		     first = request->lat_first;
+	int		     i;
+	int		     j;
+
+	reply->lat_sid = (sn == NULL) ? LST_INVALID_SID : sn->sn_id;
+
+	if (request->lat_sid.ses_nid == LNET_NID_ANY ||
+	    first >= LST_LAT_HIST_NBUCKETS ||
+	    first % SRPC_LAT_PAGE_NBUCKETS != 0) {
+		reply->lat_status = EINVAL;
+		return 0;
+	}
+
+	if (sn == NULL || !sfw_sid_equal(request->lat_sid, sn->sn_id)) {
+		reply->lat_status = ESRCH;
+		return 0;
+	}
+
+	reply->lat_first = first;
+	reply->lat_max_usec = 0;
+	memset(reply->lat_buckets, 0, sizeof(reply->lat_buckets));
+
+	cfs_percpt_for_each(part, i, sn->sn_lat_parts) {
+		spin_lock(&part->slp_lock);
+		for (j = 0; j < SRPC_LAT_PAGE_NBUCKETS; j++)
+			reply->lat_buckets[j] +=
+				part->slp_hist.lh_buckets[first + j];
+		if (part->slp_hist.lh_max_usec > reply->lat_max_usec)
+			reply->lat_max_usec = part->slp_hist.lh_max_usec;
+		spin_unlock(&part->slp_lock);
+	}
+
+	reply->lat_status = 0;
+	return 0;
+}
+
+static void
+sfw_record_latency(sfw_session_t *sn, srpc_client_rpc_t *rpc)
+{
+	struct sfw_lat_part *part = sn->sn_lat_parts[lnet_cpt_current()];
+	__u64		     usec = srpc_clock_usec() - rpc->crpc_start;
+
+	if (usec > (__u32)~0U)
+		usec = (__u32)~0U;
+
+	spin_lock(&part->slp_lock);
+	part->slp_hist.lh_buckets[sfw_lat_hist_bucket(usec)]++;
+	if (usec > part->slp_hist.lh_max_usec)
+		part->slp_hist.lh_max_usec = usec;
+	spin_unlock(&part->slp_lock);
+}
+
 int
 sfw_make_session(srpc_mksn_reqst_t *request, srpc_mksn_reply_t *reply)
 {
-	sfw_session_t *sn = sfw_data.fw_session;
-	srpc_msg_t    *msg = container_of(request, srpc_msg_t,
-					  msg_body.mksn_reqst);
-	int	       cplen = 0;
+	sfw_session_t	    *sn = sfw_data.fw_session;
+	srpc_msg_t	    *msg = container_of(request, srpc_msg_t,
+						msg_body.mksn_reqst);
+	struct sfw_lat_part *part;
+	int		     cplen = 0;
+	int		     i;
 
         if (request->mksn_sid.ses_nid == LNET_NID_ANY) {
                 reply->mksn_sid = (sn == NULL) ? LST_INVALID_SID : sn->sn_id;
@@ -490,6 +560,16 @@ sfw_make_session(srpc_mksn_reqst_t *request, srpc_mksn_reply_t *reply)
 	sfw_init_session(sn, request->mksn_sid,
 			 msg->msg_ses_feats, &request->mksn_name[0]);
 
+	sn->sn_lat_parts = cfs_percpt_alloc(lnet_cpt_table(),
+					    sizeof(struct sfw_lat_part));
+	if (sn->sn_lat_parts == NULL) {
+		LIBCFS_FREE(sn, sizeof(*sn));
+		CERROR("dropping RPC mksn under memory pressure\n");
+		return -ENOMEM;
+	}
+	cfs_percpt_for_each(part, i, sn->sn_lat_parts)
+		spin_lock_init(&part->slp_lock);
+
 	spin_lock(&sfw_data.fw_lock);
 
 	sfw_deactivate_session();
@@ -710,6 +790,8 @@ sfw_destroy_session (sfw_session_t *sn)
 		sfw_destroy_batch(batch);
 	}
 
+	if (sn->sn_lat_parts != NULL)
+		cfs_percpt_free(sn->sn_lat_parts);
 	LIBCFS_FREE(sn, sizeof(*sn));
 	atomic_dec(&sfw_data.fw_nzombies);
 	return;
@@ -915,6 +997,9 @@ sfw_test_rpc_done (srpc_client_rpc_t *rpc)
 
         tsi->tsi_ops->tso_done_rpc(tsu, rpc);
 
+	if (rpc->crpc_status == 0)
+		sfw_record_latency(tsi->tsi_batch->bat_session, rpc);
+
 	spin_lock(&tsi->tsi_lock);
 
 	LASSERT(sfw_test_active(tsi));
@@ -1343,6 +1428,11 @@ sfw_handle_server_rpc(struct srpc_server_rpc *rpc)
                                    &reply->msg_body.stat_reply);
                 break;
 
+	case SRPC_SERVICE_QUERY_LAT:
+		rc = sfw_get_lat_hist(&request->msg_body.lat_reqst,
+				      &reply->msg_body.lat_reply);
+		break;
+
         case SRPC_SERVICE_DEBUG:
                 rc = sfw_debug_session(&request->msg_body.dbg_reqst,
                                        &reply->msg_body.dbg_reply);
@@ -1498,6 +1588,24 @@ sfw_unpack_message (srpc_msg_t *msg)
                 return;
         }
 
+	if (msg->msg_type == SRPC_MSG_LAT_REQST) {
+		srpc_lat_reqst_t *req = &msg->msg_body.lat_reqst;
+
+		__swab64s(&req->lat_rpyid);
+		sfw_unpack_sid(req->lat_sid);
+		__swab32s(&req->lat_first);
+		return;
+	}
+
+	if (msg->msg_type == SRPC_MSG_LAT_REPLY) {
+		srpc_lat_reply_t *rep = &msg->msg_body.lat_reply;
+
+		__swab32s(&rep->lat_status);
+		sfw_unpack_sid(rep->lat_sid);
+		sfw_unpack_lat_page(rep);
+		return;
+	}
+
         if (msg->msg_type == SRPC_MSG_MKSN_REQST) {
                 srpc_mksn_reqst_t *req = &msg->msg_body.mksn_reqst;
 
@@ -1654,6 +1762,11 @@ static srpc_service_t sfw_services[] =
                 /* sv_name */  "query stats",
                 0
         },
+        {
+                /* sv_id */    SRPC_SERVICE_QUERY_LAT,
+                /* sv_name */  "query latency",
+                0
+        },
         {
                 /* sv_id */    SRPC_SERVICE_MAKE_SESSION,
                 /* sv_name */  "make session",
@@ -1393,6 +1393,7 @@ srpc_post_rpc (srpc_client_rpc_t *rpc)
                 libcfs_id2str(rpc->crpc_dest), rpc->crpc_service,
                 rpc->crpc_timeout);
 
+	rpc->crpc_start = srpc_clock_usec();
         srpc_add_client_rpc_timer(rpc);
         swi_schedule_workitem(&rpc->crpc_wi);
         return;
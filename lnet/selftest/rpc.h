@@ -63,6 +63,8 @@ typedef enum {
         SRPC_MSG_PING_REPLY     = 15,
         SRPC_MSG_JOIN_REQST     = 16,
         SRPC_MSG_JOIN_REPLY     = 17,
+        SRPC_MSG_LAT_REQST      = 18,
+        SRPC_MSG_LAT_REPLY      = 19,
 } srpc_msg_type_t;
 
 /* CAVEAT EMPTOR:
@@ -168,6 +170,24 @@ typedef struct {
         lnet_counters_t         str_lnet;
 } WIRE_ATTR srpc_stat_reply_t;
 
+/* a latency histogram doesn't fit in a srpc_msg_t, it's queried by pages of
+ * SRPC_LAT_PAGE_NBUCKETS buckets */
+#define SRPC_LAT_PAGE_NBUCKETS	26
+
+typedef struct {
+	__u64			lat_rpyid;	/* reply buffer matchbits */
+	lst_sid_t		lat_sid;	/* session id */
+	__u32			lat_first;	/* first bucket of the page */
+} WIRE_ATTR srpc_lat_reqst_t;
+
+typedef struct {
+	__u32			lat_status;
+	lst_sid_t		lat_sid;
+	__u32			lat_max_usec;	/* slowest RPC */
+	__u32			lat_first;	/* first bucket of the page */
+	__u32			lat_buckets[SRPC_LAT_PAGE_NBUCKETS];
+} WIRE_ATTR srpc_lat_reply_t;
+
 typedef struct {
         __u32                   blk_opc;        /* bulk operation code */
         __u32                   blk_npg;        /* # of pages */
@@ -274,6 +294,8 @@ typedef struct srpc_msg {
                 srpc_test_reply_t    tes_reply;
                 srpc_join_reqst_t    join_reqst;
                 srpc_join_reply_t    join_reply;
+                srpc_lat_reqst_t     lat_reqst;
+                srpc_lat_reply_t     lat_reply;
 
                 srpc_ping_reqst_t    ping_reqst;
                 srpc_ping_reply_t    ping_reply;
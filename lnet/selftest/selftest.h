@@ -43,12 +43,15 @@
 
 #define LNET_ONLY
 
-#ifndef __KERNEL__
+#ifdef __KERNEL__
+#include <linux/ktime.h>
+#else
 
 /* XXX workaround XXX */
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
 #endif
+#include <time.h>
 
 #endif
 #include <libcfs/libcfs.h>
@@ -90,6 +93,7 @@ struct sfw_test_instance;
 #define SRPC_SERVICE_TEST               4
 #define SRPC_SERVICE_QUERY_STAT         5
 #define SRPC_SERVICE_JOIN               6
+#define SRPC_SERVICE_QUERY_LAT          7
 #define SRPC_FRAMEWORK_SERVICE_MAX_ID   10
 /* other services start from SRPC_FRAMEWORK_SERVICE_MAX_ID+1 */
 #define SRPC_SERVICE_BRW                11
@@ -134,6 +138,9 @@ srpc_service2request (int service)
 
         case SRPC_SERVICE_JOIN:
                 return SRPC_MSG_JOIN_REQST;
+
+        case SRPC_SERVICE_QUERY_LAT:
+                return SRPC_MSG_LAT_REQST;
         }
 }
 
@@ -229,6 +236,7 @@ typedef struct srpc_client_rpc {
         void               (*crpc_fini)(struct srpc_client_rpc *);
         int                  crpc_status;    /* completion status */
         void                *crpc_priv;      /* caller data */
+	__u64			crpc_start;	/* when RPC was posted, usec */
 
         /* state flags */
         unsigned int         crpc_aborted:1; /* being given up */
@@ -336,6 +344,13 @@ typedef struct srpc_service {
         int              (*sv_bulk_ready) (srpc_server_rpc_t *, int);
 } srpc_service_t;
 
+/* latency histogram of the test RPCs completed on a CPU partition */
+struct sfw_lat_part {
+	/* serialize updates of slp_hist */
+	spinlock_t		slp_lock;
+	sfw_lat_hist_t		slp_hist;
+};
+
 typedef struct {
 	/* chain on fw_zombie_sessions */
 	struct list_head	sn_list;
@@ -351,6 +366,8 @@ typedef struct {
 	atomic_t		sn_brw_errors;
 	atomic_t		sn_ping_errors;
 	cfs_time_t		sn_started;
+	/* latency histograms per CPU partition, merged when queried */
+	struct sfw_lat_part   **sn_lat_parts;
 } sfw_session_t;
 
 #define sfw_sid_equal(sid0, sid1)     ((sid0).ses_nid == (sid1).ses_nid && \
@@ -508,6 +525,20 @@ swi_deschedule_workitem(swi_workitem_t *swi)
 	return cfs_wi_deschedule(swi->swi_sched, &swi->swi_workitem);
 }
 
+/* monotonic clock of the RPC latencies, in microseconds */
+static inline __u64
+srpc_clock_usec(void)
+{
+#ifdef __KERNEL__
+	return ktime_to_us(ktime_get());
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (__u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
 #ifndef __KERNEL__
 static inline int
 swi_check_events(void)
@@ -1502,12 +1502,31 @@ lst_stat_ioctl (char *name, int count, lnet_process_id_t *idsp,
         return lst_ioctl (LSTIO_STAT_QUERY, &args, sizeof(args));
 }
 
+int
+lst_lat_ioctl(char *name, int count, lnet_process_id_t *idsp,
+	      int timeout, struct list_head *resultp)
+{
+	lstio_stat_args_t args = {0};
+
+	args.lstio_sta_key     = session_key;
+	args.lstio_sta_timeout = timeout;
+	args.lstio_sta_nmlen   = strlen(name);
+	args.lstio_sta_namep   = name;
+	args.lstio_sta_count   = count;
+	args.lstio_sta_idsp    = idsp;
+	args.lstio_sta_resultp = resultp;
+
+	return lst_ioctl(LSTIO_LAT_QUERY, &args, sizeof(args));
+}
+
 typedef struct {
 	struct list_head              srp_link;
         int                     srp_count;
         char                   *srp_name;
         lnet_process_id_t      *srp_ids;
 	struct list_head              srp_result[2];
+	/* latency histograms, only allocated for "stat --lat" */
+	struct list_head	srp_lat[2];
 } lst_stat_req_param_t;
 
 static void
@@ -1515,8 +1534,10 @@ lst_stat_req_param_free(lst_stat_req_param_t *srp)
 {
         int     i;
 
-        for (i = 0; i < 2; i++)
-                lst_free_rpcent(&srp->srp_result[i]);
+	for (i = 0; i < 2; i++) {
+		lst_free_rpcent(&srp->srp_result[i]);
+		lst_free_rpcent(&srp->srp_lat[i]);
+	}
 
         if (srp->srp_ids != NULL)
                 free(srp->srp_ids);
@@ -1525,7 +1546,8 @@ lst_stat_req_param_free(lst_stat_req_param_t *srp)
 }
 
 static int
-lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
+lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp,
+			 int save_old, int lat)
 {
         lst_stat_req_param_t *srp = NULL;
         int                   count = save_old ? 2 : 1;
@@ -1539,6 +1561,8 @@ lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
         memset(srp, 0, sizeof(*srp));
 	INIT_LIST_HEAD(&srp->srp_result[0]);
 	INIT_LIST_HEAD(&srp->srp_result[1]);
+	INIT_LIST_HEAD(&srp->srp_lat[0]);
+	INIT_LIST_HEAD(&srp->srp_lat[1]);
 
         rc = lst_get_node_count(LST_OPC_GROUP, name,
                                 &srp->srp_count, NULL);
@@ -1567,6 +1591,16 @@ lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
                         fprintf(stderr, "Out of memory\n");
                         break;
                 }
+
+		if (!lat)
+			continue;
+
+		rc = lst_alloc_rpcent(&srp->srp_lat[i], srp->srp_count,
+				      sizeof(sfw_lat_hist_t));
+		if (rc != 0) {
+			fprintf(stderr, "Out of memory\n");
+			break;
+		}
         }
 
         if (rc == 0) {
@@ -1863,9 +1897,182 @@ lst_print_stat(char *name, struct list_head *resultp,
         if (!lnet)  /* TODO */
                 return;
 
+	if (type == 0) /* machine readable, see lst_print_stat_record() */
+		return;
+
         lst_print_lnet_stat(name, bwrt, rdwr, type);
 }
 
+#define LST_STAT_FMT_TEXT	0
+#define LST_STAT_FMT_JSON	1
+#define LST_STAT_FMT_CSV	2
+
+typedef struct {
+	__u64		lat_rpcs;	/* # RPCs completed in the interval */
+	__u32		lat_p50;	/* percentiles in usec */
+	__u32		lat_p99;
+	__u32		lat_p999;
+	__u32		lat_max;	/* max since the session started */
+	int		lat_valid;
+} lst_lat_result_t;
+
+/* estimate the latency which \a pct of RPCs didn't exceed, interpolating
+ * linearly inside the log-linear bucket the percentile falls into */
+static __u32
+lst_lat_percentile(__u64 *buckets, __u64 total, __u32 max, double pct)
+{
+	__u64	target = (__u64)(total * pct / 100);
+	__u64	sum = 0;
+	double	lo;
+	double	hi;
+	double	val;
+	int	i;
+
+	if (target == 0)
+		target = 1;
+
+	for (i = 0; i < LST_LAT_HIST_NBUCKETS; i++) {
+		if (sum + buckets[i] >= target)
+			break;
+		sum += buckets[i];
+	}
+
+	if (i == LST_LAT_HIST_NBUCKETS)
+		return max;
+
+	lo = sfw_lat_hist_lower(i);
+	hi = i == LST_LAT_HIST_NBUCKETS - 1 ? max : sfw_lat_hist_lower(i + 1);
+	val = lo + (hi - lo) * (target - sum) / buckets[i];
+
+	return val > max ? max : (__u32)val;
+}
+
+/* merge the histograms of all nodes and calculate percentiles of RPCs
+ * completed since the previous sample */
+static void
+lst_cal_lat(struct list_head *resultp, int idx, lst_lat_result_t *res)
+{
+	lstcon_rpc_ent_t *new;
+	lstcon_rpc_ent_t *old;
+	sfw_lat_hist_t	 *lat_new;
+	sfw_lat_hist_t	 *lat_old;
+	__u64		  buckets[LST_LAT_HIST_NBUCKETS];
+	__u64		  total = 0;
+	__u32		  max = 0;
+	int		  i;
+
+	memset(res, 0, sizeof(*res));
+	memset(buckets, 0, sizeof(buckets));
+
+	new = list_entry(&resultp[idx], lstcon_rpc_ent_t, rpe_link);
+	old = list_entry(&resultp[1 - idx], lstcon_rpc_ent_t, rpe_link);
+
+	while (1) {
+		new = list_entry(new->rpe_link.next, lstcon_rpc_ent_t,
+				 rpe_link);
+		old = list_entry(old->rpe_link.next, lstcon_rpc_ent_t,
+				 rpe_link);
+		if (&new->rpe_link == &resultp[idx] ||
+		    &old->rpe_link == &resultp[1 - idx])
+			break;
+
+		/* first sample or group has been changed */
+		if (new->rpe_peer.nid == LNET_NID_ANY ||
+		    new->rpe_peer.nid != old->rpe_peer.nid ||
+		    new->rpe_peer.pid != old->rpe_peer.pid)
+			return;
+
+		if (new->rpe_rpc_errno != 0 || new->rpe_fwk_errno != 0 ||
+		    old->rpe_rpc_errno != 0 || old->rpe_fwk_errno != 0)
+			continue;
+
+		lat_new = (sfw_lat_hist_t *)&new->rpe_payload[0];
+		lat_old = (sfw_lat_hist_t *)&old->rpe_payload[0];
+
+		for (i = 0; i < LST_LAT_HIST_NBUCKETS; i++) {
+			/* counters are reset if the node rejoined */
+			if (lat_new->lh_buckets[i] < lat_old->lh_buckets[i])
+				buckets[i] += lat_new->lh_buckets[i];
+			else
+				buckets[i] += lat_new->lh_buckets[i] -
+					      lat_old->lh_buckets[i];
+		}
+
+		if (lat_new->lh_max_usec > max)
+			max = lat_new->lh_max_usec;
+	}
+
+	for (i = 0; i < LST_LAT_HIST_NBUCKETS; i++)
+		total += buckets[i];
+
+	res->lat_valid = 1;
+	res->lat_rpcs  = total;
+	res->lat_max   = max;
+	if (total == 0)
+		return;
+
+	res->lat_p50  = lst_lat_percentile(buckets, total, max, 50);
+	res->lat_p99  = lst_lat_percentile(buckets, total, max, 99);
+	res->lat_p999 = lst_lat_percentile(buckets, total, max, 99.9);
+}
+
+static void
+lst_print_lat(char *name, lst_lat_result_t *res)
+{
+	if (!res->lat_valid)
+		return;
+
+	fprintf(stdout, "[RPC Latency of %s]\n", name);
+	fprintf(stdout, "RPCs: %-8llu p50: %-8u p99: %-8u p99.9: %-8u "
+		"Max: %u usec\n", (unsigned long long)res->lat_rpcs,
+		res->lat_p50, res->lat_p99, res->lat_p999, res->lat_max);
+}
+
+/* one record per group and sample, for consumption by scripts */
+static void
+lst_print_stat_record(int fmt, time_t now, char *name, int lnet,
+		      lst_lat_result_t *res)
+{
+	static int	csv_header;
+	lst_lnet_stat_result_t *ls = &lnet_stat_result;
+
+	/* first sample has no diff to report */
+	if ((!lnet || ls->lnet_stat_count == 0) && !res->lat_valid)
+		return;
+
+	if (fmt == LST_STAT_FMT_CSV) {
+		if (!csv_header) {
+			fprintf(stdout, "time,group,recv_rpc_s,send_rpc_s,"
+				"recv_mb_s,send_mb_s,rpcs,p50_us,p99_us,"
+				"p99.9_us,max_us\n");
+			csv_header = 1;
+		}
+
+		fprintf(stdout, "%ld,%s,%.0f,%.0f,%.2f,%.2f,%llu,%u,%u,%u,%u\n",
+			(long)now, name,
+			ls->lnet_total_rcvrate, ls->lnet_total_sndrate,
+			ls->lnet_total_rcvperf, ls->lnet_total_sndperf,
+			(unsigned long long)res->lat_rpcs, res->lat_p50,
+			res->lat_p99, res->lat_p999, res->lat_max);
+	} else {
+		fprintf(stdout, "{\"time\": %ld, \"group\": \"%s\", "
+			"\"recv_rpc_s\": %.0f, \"send_rpc_s\": %.0f, "
+			"\"recv_mb_s\": %.2f, \"send_mb_s\": %.2f",
+			(long)now, name,
+			ls->lnet_total_rcvrate, ls->lnet_total_sndrate,
+			ls->lnet_total_rcvperf, ls->lnet_total_sndperf);
+		if (res->lat_valid)
+			fprintf(stdout, ", \"rpcs\": %llu, \"p50_us\": %u, "
+				"\"p99_us\": %u, \"p99.9_us\": %u, "
+				"\"max_us\": %u",
+				(unsigned long long)res->lat_rpcs,
+				res->lat_p50, res->lat_p99, res->lat_p999,
+				res->lat_max);
+		fprintf(stdout, "}\n");
+	}
+	fflush(stdout);
+}
+
 int
 jt_lst_stat(int argc, char **argv)
 {
@@ -1881,6 +2088,8 @@ jt_lst_stat(int argc, char **argv)
         int                   rdwr    = 0;
         int                   type    = -1;
         int                   idx     = 0;
+	int		      lat     = 0;
+	int		      fmt     = LST_STAT_FMT_TEXT;
         int                   rc;
         int                   c;
 
@@ -1898,6 +2107,8 @@ jt_lst_stat(int argc, char **argv)
 		{"avg"	     , no_argument,	 0, 'g' },
 		{"min"	     , no_argument,	 0, 'n' },
 		{"max"	     , no_argument,	 0, 'x' },
+		{"lat"	     , no_argument,	 0, 'L' },
+		{"format"    , required_argument, 0, 'f' },
 		{0,	       0,		 0,  0  }
         };
 
@@ -1908,7 +2119,8 @@ jt_lst_stat(int argc, char **argv)
         }
 
         while (1) {
-		c = getopt_long(argc, argv, "t:d:lcbarwgnx", stat_opts, &optidx);
+		c = getopt_long(argc, argv, "t:d:lcbarwgnxLf:", stat_opts,
+				&optidx);
 
                 if (c == -1)
                         break;
@@ -1962,6 +2174,21 @@ jt_lst_stat(int argc, char **argv)
                         }
                         type |= 4;
                         break;
+		case 'L':
+			lat = 1;
+			break;
+		case 'f':
+			if (strcmp(optarg, "text") == 0) {
+				fmt = LST_STAT_FMT_TEXT;
+			} else if (strcmp(optarg, "json") == 0) {
+				fmt = LST_STAT_FMT_JSON;
+			} else if (strcmp(optarg, "csv") == 0) {
+				fmt = LST_STAT_FMT_CSV;
+			} else {
+				fprintf(stderr, "Unknown format %s\n", optarg);
+				return -1;
+			}
+			break;
 
                 default:
                         lst_print_usage(argv[0]);
@@ -1991,7 +2218,7 @@ jt_lst_stat(int argc, char **argv)
 	INIT_LIST_HEAD(&head);
 
         while (optind < argc) {
-                rc = lst_stat_req_param_alloc(argv[optind++], &srp, 1);
+		rc = lst_stat_req_param_alloc(argv[optind++], &srp, 1, lat);
                 if (rc != 0)
                         goto out;
 
@@ -1999,6 +2226,7 @@ jt_lst_stat(int argc, char **argv)
         }
 
         do {
+		lst_lat_result_t lat_res;
                 time_t  now = time(NULL);
 
                 if (now - last < delay) {
@@ -2018,7 +2246,31 @@ jt_lst_stat(int argc, char **argv)
                         }
 
 			lst_print_stat(srp->srp_name, srp->srp_result,
-				       idx, lnet, bwrt, rdwr, type);
+				       idx, lnet, bwrt, rdwr,
+				       fmt == LST_STAT_FMT_TEXT ? type : 0);
+
+			memset(&lat_res, 0, sizeof(lat_res));
+			if (lat) {
+				rc = lst_lat_ioctl(srp->srp_name,
+						   srp->srp_count, srp->srp_ids,
+						   timeout, &srp->srp_lat[idx]);
+				if (rc == -1) {
+					lst_print_error("stat",
+						"Failed to get latency of %s: "
+						"%s\n", srp->srp_name,
+						strerror(errno));
+					goto out;
+				}
+
+				lst_cal_lat(srp->srp_lat, idx, &lat_res);
+				if (fmt == LST_STAT_FMT_TEXT)
+					lst_print_lat(srp->srp_name, &lat_res);
+				lst_reset_rpcent(&srp->srp_lat[1 - idx]);
+			}
+
+			if (fmt != LST_STAT_FMT_TEXT)
+				lst_print_stat_record(fmt, now, srp->srp_name,
+						      lnet, &lat_res);
 
                         lst_reset_rpcent(&srp->srp_result[1 - idx]);
                 }
@@ -2091,7 +2343,7 @@ jt_lst_show_error(int argc, char **argv)
 	INIT_LIST_HEAD(&head);
 
         while (optind < argc) {
-                rc = lst_stat_req_param_alloc(argv[optind++], &srp, 0);
+		rc = lst_stat_req_param_alloc(argv[optind++], &srp, 0, 0);
                 if (rc != 0)
                         goto out;
 
@@ -3241,6 +3493,7 @@ static command_t lst_cmdlist[] = {
           "Usage: lst list_group [--active] [--busy] [--down] [--unknown] GROUP ..."    },
 	{"stat",                jt_lst_stat,            NULL,
 	 "Usage: lst stat [--bw] [--rate] [--read] [--write] [--max] [--min] [--avg] "
+	 "[--lat] [--format text|json|csv]"
 	 " [--timeout #] [--delay #] [--count #] GROUP [GROUP]"                         },
         {"show_error",          jt_lst_show_error,      NULL,
          "Usage: lst show_error NAME | IDS ..."                                         },
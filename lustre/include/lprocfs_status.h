@@ -81,6 +81,8 @@ enum {
         BRW_W_DISK_IOSIZE,
         BRW_R_DIO_FRAGS,
         BRW_W_DIO_FRAGS,
+	BRW_R_EXTENTS_MB,
+	BRW_W_EXTENTS_MB,
         BRW_LAST,
 };
 
@@ -495,6 +495,11 @@ enum lu_object_header_flags {
 	 * Mark this object has already been taken out of cache.
 	 */
 	LU_OBJECT_UNHASHED = 1,
+	/**
+	 * Object was referenced again while staying on the LRU list, it
+	 * gets a second chance instead of being purged, see lu_site_purge().
+	 */
+	LU_OBJECT_LRU_REF = 2,
 };
 
 enum lu_object_header_attr {
@@ -564,12 +569,13 @@ struct lu_site_bkt_data {
 	 */
 	long			lsb_busy;
 	/**
-	 * LRU list, updated on each access to object. Protected by
-	 * bucket lock of lu_site::ls_obj_hash.
+	 * LRU list, protected by bucket lock of lu_site::ls_obj_hash.
 	 *
-	 * "Cold" end of LRU is lu_site::ls_lru.next. Accessed object are
-	 * moved to the lu_site::ls_lru.prev (this is due to the non-existence
-	 * of list_for_each_entry_safe_reverse()).
+	 * "Cold" end of LRU is lu_site::ls_lru.next. The list is maintained
+	 * lazily: an object is added to the tail when its last reference is
+	 * released, and isn't removed by lookup. Busy objects are dropped
+	 * from the list, and referenced ones (LU_OBJECT_LRU_REF) are rotated
+	 * to the tail by lu_site_purge(), unless it purges the whole site.
 	 */
 	struct list_head	lsb_lru;
 	/**
@@ -590,9 +596,16 @@ enum {
         LU_SS_CACHE_RACE,
         LU_SS_CACHE_DEATH_RACE,
         LU_SS_LRU_PURGED,
+	/** lu_object_find_at() time in usec, one lookup of
+	 * LU_SITE_LOOKUP_SAMPLE is timed on each CPU */
+	LU_SS_LOOKUP_TIME,
+	/** lookups which found the bucket lock held */
+	LU_SS_LOOKUP_CONTENDED,
         LU_SS_LAST_STAT
 };
 
+#define LU_SITE_LOOKUP_SAMPLE	64
+
 /**
  * lu_site is a "compartment" within which objects are unique, and LRU
  * discipline is maintained.
@@ -1109,6 +1122,14 @@ struct lu_context_key {
          */
         void   (*lct_exit)(const struct lu_context *ctx,
                            struct lu_context_key *key, void *data);
+	/**
+	 * Optional method to return a value to its freshly constructed
+	 * state. Keys providing it have their values kept across requests by
+	 * lu_context_pool, instead of being destroyed and re-created for every
+	 * pooled context.
+	 */
+	void   (*lct_reset)(const struct lu_context *ctx,
+			    struct lu_context_key *key, void *data);
 	/**
 	 * Internal implementation detail: index within lu_context::lc_value[]
 	 * reserved for this key.
@@ -1159,6 +1180,16 @@ struct lu_context_key {
         LU_KEY_INIT(mod,type);        \
         LU_KEY_FINI(mod,type)
 
+#define LU_KEY_RESET(mod, type)						\
+	static void mod##_key_reset(const struct lu_context *ctx,	\
+				    struct lu_context_key *key, void *data) \
+	{								\
+		type *info = data;					\
+									\
+		memset(info, 0, sizeof(*info));				\
+	}								\
+	struct __##mod##__dummy_reset {;} /* semicolon catcher */
+
 #define LU_CONTEXT_KEY_DEFINE(mod, tags)                \
         struct lu_context_key mod##_thread_key = {      \
                 .lct_tags = tags,                       \
@@ -1242,6 +1273,48 @@ void  lu_context_enter (struct lu_context *ctx);
 void  lu_context_exit  (struct lu_context *ctx);
 int   lu_context_refill(struct lu_context *ctx);
 
+/**
+ * Cache of key value arrays for short-lived contexts, e.g., per-request
+ * sessions of a ptlrpc service.
+ *
+ * A context released with lu_context_pool_put() keeps values of the keys
+ * having lu_context_key::lct_reset(): they are reset and the whole value
+ * array is parked in the pool, to be handed over to the next context
+ * initialized by lu_context_pool_get(). Values of other keys are destroyed
+ * as usual. Cached values are destroyed by lu_context_key_quiesce(), so
+ * pooled contexts don't prevent module unloading.
+ */
+struct lu_context_pool {
+	spinlock_t		  lcp_lock;
+	/** tags of contexts using this pool */
+	__u32			  lcp_tags;
+	/** # of cached value arrays */
+	unsigned int		  lcp_count;
+	/** max # of cached value arrays */
+	unsigned int		  lcp_max;
+	/** cached value arrays */
+	void			***lcp_cache;
+	/**
+	 * Pseudo-context owning cached values, used for lu_ref tracking and
+	 * to destroy cached values.
+	 */
+	struct lu_context	  lcp_ctx;
+	/** linkage into the global list of pools */
+	struct list_head	  lcp_linkage;
+	/** # of key values created for contexts of this pool */
+	__u64			  lcp_allocated;
+	/** # of key values taken from the cache */
+	__u64			  lcp_reused;
+	/** # of key values destroyed when a context was returned */
+	__u64			  lcp_freed;
+};
+
+int  lu_context_pool_init(struct lu_context_pool *pool, __u32 tags,
+			  unsigned int max);
+void lu_context_pool_fini(struct lu_context_pool *pool);
+int  lu_context_pool_get(struct lu_context_pool *pool, struct lu_context *ctx);
+void lu_context_pool_put(struct lu_context_pool *pool, struct lu_context *ctx);
+
 /*
  * Helper functions to operate on multiple keys. These are used by the default
  * device type operations, defined by LU_TYPE_INIT_FINI().
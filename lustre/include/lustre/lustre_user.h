@@ -842,6 +842,13 @@ enum changelog_send_flag {
 	CHANGELOG_FLAG_BLOCK    = 0x02,
 	/* Pack jobid into the changelog records if available. */
 	CHANGELOG_FLAG_JOBID    = 0x04,
+	/* Pack as many records as fit in KUC_CHANGELOG_BATCH_MAXSIZE in a
+	 * single CL_RECORDS message, already remapped to the format the
+	 * reader expects. */
+	CHANGELOG_FLAG_BATCH	= 0x08,
+	/* Only send records matching the icc_endrec, icc_typemask and
+	 * icc_fid_{start,end} filters of struct ioc_changelog. */
+	CHANGELOG_FLAG_FILTER	= 0x10,
 };
 
 #define CR_MAXSIZE cfs_size_round(2 * NAME_MAX + 2 + \
@@ -1009,11 +1016,19 @@ struct ioc_changelog {
         __u32 icc_mdtindex;
         __u32 icc_id;
         __u32 icc_flags;
+	/* filters, only used with CHANGELOG_FLAG_FILTER, and only copied
+	 * in by the kernel then, the struct of old binaries stops here */
+	__u32		icc_typemask;	/* 1 << CL_* to send, 0 for all */
+	__u64		icc_endrec;	/* last record to send, 0 for all */
+	lustre_fid	icc_fid_start;	/* target FID range, zero for all */
+	lustre_fid	icc_fid_end;
 };
 
 enum changelog_message_type {
         CL_RECORD = 10, /* message is a changelog_rec */
         CL_EOF    = 11, /* at end of current changelog */
+	CL_RECORDS = 12, /* message is a batch of changelog_recs, each one
+			  * padded to a multiple of 8 bytes */
 };
 
 /********* Misc **********/
@@ -142,6 +142,9 @@ extern int llapi_file_lookup(int dirfd, const char *name);
 				 VERBOSE_OBJID | VERBOSE_GENERATION |\
 				 VERBOSE_LAYOUT)
 
+/* max number of threads of a parallel llapi_find() */
+#define LLAPI_FIND_MAX_THREADS	64
+
 struct find_param {
 	unsigned int		 fp_max_depth;
 	dev_t			 fp_dev;
@@ -227,6 +230,13 @@ struct find_param {
 	unsigned long		 fp_got_uuids:1,
 				 fp_obds_printed:1;
 	unsigned int		 fp_depth;
+
+	/* Appended to keep the layout of the fields above. */
+	/* number of threads scanning directories, see llapi_find(),
+	 * at most LLAPI_FIND_MAX_THREADS */
+	unsigned int		 fp_threads;
+	/* out: number of entries checked by llapi_find() */
+	unsigned long long	 fp_scanned;
 };
 
 extern int llapi_ostlist(char *path, struct find_param *param);
@@ -333,10 +343,26 @@ extern int llapi_swap_layouts(const char *path1, const char *path2,
  * converted to extented format in the lustre api to ease changelog analysis. */
 #define HAVE_CHANGELOG_EXTEND_REC 1
 
+/* Records to report, checked in the kernel before they are copied to the
+ * reader. Consumers sharing a changelog can each be given a disjoint range
+ * of records with startrec and cf_endrec. */
+struct changelog_filter {
+	long long	cf_endrec;	/* last record to report, 0 for all */
+	__u32		cf_typemask;	/* 1 << CL_* to report, 0 for all */
+	lustre_fid	cf_fid_start;	/* target FID range, zero for all */
+	lustre_fid	cf_fid_end;
+};
+
 extern int llapi_changelog_start(void **priv, enum changelog_send_flag flags,
 				 const char *mdtname, long long startrec);
+extern int llapi_changelog_start_filter(void **priv,
+					enum changelog_send_flag flags,
+					const char *mdtname, long long startrec,
+					const struct changelog_filter *filter);
 extern int llapi_changelog_fini(void **priv);
 extern int llapi_changelog_recv(void *priv, struct changelog_rec **rech);
+extern int llapi_changelog_recv_batch(void *priv, struct changelog_rec **recs,
+				      int nrecs);
 extern int llapi_changelog_free(struct changelog_rec **rech);
 /* Allow records up to endrec to be destroyed; requires registered id. */
 extern int llapi_changelog_clear(const char *mdtname, const char *idstr,
@@ -969,6 +969,9 @@ struct ldlm_resource {
 	struct lu_ref		lr_reference;
 
 	struct inode		*lr_lvb_inode;
+	/** resource is freed after a RCU grace period, see
+	 * ldlm_res_hop_get_rcu() */
+	struct rcu_head		lr_rcu;
 };
 
 static inline bool ldlm_has_layout(struct ldlm_lock *lock)
@@ -85,6 +85,9 @@ void lmv_free_md(union lmv_mds_md *lmm);
 int lmv_alloc_memmd(struct lmv_stripe_md **lsmp, int stripe_count);
 void lmv_free_memmd(struct lmv_stripe_md *lsm);
 
+struct lmv_dir_merge;
+void lmv_free_dir_merge(struct lmv_dir_merge *merge);
+
 int lmvea_load_shards(const struct lu_env *env, struct dt_object *obj,
 		      struct lu_dirent *ent, struct lu_buf *buf,
 		      bool resize);
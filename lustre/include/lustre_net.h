@@ -121,6 +121,12 @@
 
 #define PTLRPC_NTHRS_INIT	2
 
+/**
+ * Max # of request session value arrays cached by each service partition,
+ * see ptlrpc_service_part::scp_ses_pool.
+ */
+#define PTLRPC_SES_POOL_MAX	64
+
 /**
  * Buffer Constants
  *
@@ -2647,6 +2653,8 @@ struct ptlrpc_service_part {
 	int				scp_nthrs_running;
 	/** service threads list */
 	struct list_head		scp_threads;
+	/** cache of request session key values */
+	struct lu_context_pool		scp_ses_pool;
 
 	/**
 	 * serialize the following fields, used for protecting
@@ -785,8 +785,12 @@ enum md_cli_flags {
 	CLI_HASH64      = 1 << 2,
 	CLI_API32       = 1 << 3,
 	CLI_MIGRATE     = 1 << 4,
+	CLI_READDIR_HIT = 1 << 5, /* md_read_page() found the page cached */
+	CLI_READDIR_ASYNC = 1 << 6, /* md_read_page() only starts the read */
 };
 
+struct lmv_dir_merge;
+
 struct md_op_data {
         struct lu_fid           op_fid1; /* operation fid1 (usualy parent) */
         struct lu_fid           op_fid2; /* operation fid2 (usualy child) */
@@ -826,6 +830,11 @@ struct md_op_data {
 
 	/* Used by readdir */
 	unsigned int		op_max_pages;
+	/* readdir: READPAGE RPCs to send ahead of the page read */
+	unsigned int		op_ra_rpcs;
+	/* readdir: merge state of a striped directory kept by the open file,
+	 * NULL if the caller has none */
+	struct lmv_dir_merge	**op_dir_merge;
 
 	/* used to transfer info between the stacks of MD client
 	 * see enum op_cli_flags */
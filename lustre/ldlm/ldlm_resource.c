@@ -462,6 +462,20 @@ static void ldlm_res_hop_get_locked(cfs_hash_t *hs, struct hlist_node *hnode)
         ldlm_resource_getref(res);
 }
 
+/*
+ * Get a reference on a resource found by the lockless lookup of
+ * cfs_hash_lookup(). The last reference is dropped with the bucket lock
+ * held and the resource is removed from the hash under the same lock,
+ * a resource without reference is being freed.
+ */
+static int ldlm_res_hop_get_rcu(cfs_hash_t *hs, struct hlist_node *hnode)
+{
+	struct ldlm_resource *res;
+
+	res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
+	return atomic_inc_not_zero(&res->lr_refcount);
+}
+
 static void ldlm_res_hop_put_locked(cfs_hash_t *hs, struct hlist_node *hnode)
 {
         struct ldlm_resource *res;
@@ -486,6 +500,7 @@ static cfs_hash_ops_t ldlm_ns_hash_ops = {
         .hs_keycpy      = NULL,
         .hs_object      = ldlm_res_hop_object,
         .hs_get         = ldlm_res_hop_get_locked,
+        .hs_get_rcu     = ldlm_res_hop_get_rcu,
         .hs_put_locked  = ldlm_res_hop_put_locked,
         .hs_put         = ldlm_res_hop_put
 };
@@ -497,6 +512,7 @@ static cfs_hash_ops_t ldlm_ns_fid_hash_ops = {
         .hs_keycpy      = NULL,
         .hs_object      = ldlm_res_hop_object,
         .hs_get         = ldlm_res_hop_get_locked,
+        .hs_get_rcu     = ldlm_res_hop_get_rcu,
         .hs_put_locked  = ldlm_res_hop_put_locked,
         .hs_put         = ldlm_res_hop_put
 };
@@ -602,7 +618,8 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
                                          CFS_HASH_DEPTH |
                                          CFS_HASH_BIGNAME |
                                          CFS_HASH_SPIN_BKTLOCK |
-                                         CFS_HASH_NO_ITEMREF);
+                                         CFS_HASH_NO_ITEMREF |
+                                         CFS_HASH_RCU);
         if (ns->ns_rs_hash == NULL)
                 GOTO(out_ns, NULL);
 
@@ -1079,6 +1096,12 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
         LASSERT(ns->ns_rs_hash != NULL);
         LASSERT(name->name[0] != 0);
 
+	/* most lookups find the resource, do it without the bucket lock,
+	 * the locked lookup below gets the bucket version for creation */
+	res = cfs_hash_lookup(ns->ns_rs_hash, (void *)name);
+	if (res != NULL)
+		return res;
+
         cfs_hash_bd_get_and_lock(ns->ns_rs_hash, (void *)name, &bd, 0);
         hnode = cfs_hash_bd_lookup_locked(ns->ns_rs_hash, &bd, (void *)name);
         if (hnode != NULL) {
@@ -1177,6 +1200,20 @@ static void __ldlm_resource_putref_final(cfs_hash_bd_t *bd,
                 ldlm_namespace_put(nsb->nsb_namespace);
 }
 
+static void ldlm_resource_free_rcu(struct rcu_head *head)
+{
+	struct ldlm_resource *res;
+
+	res = container_of(head, struct ldlm_resource, lr_rcu);
+	OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+}
+
+/* lockless lookup of ns_rs_hash may still look at the resource */
+static void ldlm_resource_free(struct ldlm_resource *res)
+{
+	call_rcu(&res->lr_rcu, ldlm_resource_free_rcu);
+}
+
 /* Returns 1 if the resource was freed, 0 if it remains. */
 int ldlm_resource_putref(struct ldlm_resource *res)
 {
@@ -1193,7 +1230,7 @@ int ldlm_resource_putref(struct ldlm_resource *res)
 		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
 		if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
 			ns->ns_lvbo->lvbo_free(res);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+		ldlm_resource_free(res);
 		return 1;
 	}
 	return 0;
@@ -1223,7 +1260,7 @@ int ldlm_resource_putref_locked(struct ldlm_resource *res)
 		 */
 		if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
 			ns->ns_lvbo->lvbo_free(res);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+		ldlm_resource_free(res);
 
 		cfs_hash_bd_lock(ns->ns_rs_hash, &bd, 1);
 		return 1;
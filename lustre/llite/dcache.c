@@ -367,14 +367,21 @@ static int ll_revalidate_dentry(struct dentry *dentry,
 	if (dentry->d_inode && dentry->d_inode->i_op->follow_link)
 		return 1;
 
-	/* Last path component lookup for open or create - we always
-	 * return 0 here to go through re-lookup and properly signal
-	 * MDS whenever we do or do not want an open-cache to be engaged.
+	/* Last path component lookup for open or create - we return 0
+	 * here to go through re-lookup and properly signal MDS whenever
+	 * we do or do not want an open-cache to be engaged, unless the
+	 * file is opened often enough to be served by a cached open
+	 * handle (or an open by FID fetching one), see
+	 * ll_file_open_cacheable().
 	 * For create we also ensure the entry is really created no matter
 	 * what races might have happened.
 	 * LU-4367 */
-	if (lookup_flags & (LOOKUP_OPEN | LOOKUP_CREATE))
+	if (lookup_flags & (LOOKUP_OPEN | LOOKUP_CREATE)) {
+		if (!(lookup_flags & LOOKUP_CREATE) && dentry->d_inode != NULL &&
+		    ll_file_open_cacheable(dentry->d_inode))
+			return 1;
 		return 0;
+	}
 
 	if (!dentry_may_statahead(dir, dentry))
 		return 1;
@@ -138,18 +138,105 @@
  * mdc_adjust_dirpages().
  *
  */
+/*
+ * readdir read-ahead
+ *
+ * Once a directory is read sequentially, md_read_page() is asked to keep
+ * op_ra_rpcs READPAGE RPCs in flight ahead of the reader. The pages read
+ * ahead stay in the page cache of the directory under its UPDATE lock, like
+ * the pages read synchronously.
+ *
+ * Enough RPCs are needed to cover the READPAGE latency while the reader uses
+ * the pages of one RPC: the latency is measured on synchronous reads, and
+ * increased when the reader has to wait for a page being read ahead.
+ */
+#define LL_DIR_RA_WAIT_NS	(100 * NSEC_PER_USEC)
+
+static inline __u64 ll_dir_ra_avg(__u64 avg, __u64 val)
+{
+	return avg == 0 ? val : (avg * 7 + val) / 8;
+}
+
+static void ll_dir_ra_update(struct ll_sb_info *sbi,
+			     struct ll_dir_ra_state *ra, __u64 offset,
+			     __u64 now)
+{
+	__u64 rpcs;
+
+	/* the next page, or the rest of the last page after a short
+	 * getdents() */
+	if (ra->dra_seq == 0 || offset < ra->dra_start ||
+	    offset > ra->dra_end) {
+		ra->dra_seq = 0;
+		ra->dra_rpcs = 0;
+		return;
+	}
+
+	ra->dra_use_ns = ll_dir_ra_avg(ra->dra_use_ns, now - ra->dra_last_ns);
+	if (++ra->dra_seq < LL_DIR_RA_SEQ_MIN || sbi->ll_dir_ra_max == 0) {
+		ra->dra_rpcs = 0;
+		return;
+	}
+
+	rpcs = div64_u64(ra->dra_rpc_ns,
+			 ra->dra_use_ns * sbi->ll_md_brw_pages + 1);
+	ra->dra_rpcs = clamp_t(__u64, rpcs + 1, 1, sbi->ll_dir_ra_max);
+}
+
+static void ll_dir_ra_done(struct ll_dir_ra_state *ra, struct page *page,
+			   bool hit, __u64 start, __u64 now)
+{
+	struct lu_dirpage *dp = page_address(page);
+
+	if (!hit)
+		ra->dra_rpc_ns = ll_dir_ra_avg(ra->dra_rpc_ns, now - start);
+	else if (now - start > LL_DIR_RA_WAIT_NS)
+		/* waited for a page read ahead, not far enough */
+		ra->dra_rpc_ns += now - start;
+	else
+		ra->dra_rpc_ns -= ra->dra_rpc_ns / 64;
+
+	if (ra->dra_seq == 0)
+		ra->dra_seq = 1;	/* start of a sequence */
+	ra->dra_start = le64_to_cpu(dp->ldp_hash_start);
+	ra->dra_end = le64_to_cpu(dp->ldp_hash_end);
+	ra->dra_last_ns = now;
+}
+
 struct page *ll_get_dir_page(struct inode *dir, struct md_op_data *op_data,
 			     __u64 offset, struct ll_dir_chain *chain)
 {
+	struct ll_sb_info	*sbi = ll_i2sbi(dir);
+	struct ll_dir_ra_state	*ra = chain->ldc_ra;
 	struct md_callback	cb_op;
 	struct page		*page;
+	__u64			start = 0;
+	bool			hit;
 	int			rc;
 
+	op_data->op_ra_rpcs = 0;
+	if (ra != NULL) {
+		start = ktime_to_ns(ktime_get());
+		ll_dir_ra_update(sbi, ra, offset, start);
+		op_data->op_ra_rpcs = ra->dra_rpcs;
+	}
+	op_data->op_cli_flags &= ~CLI_READDIR_HIT;
+
 	cb_op.md_blocking_ast = ll_md_blocking_ast;
 	rc = md_read_page(ll_i2mdexp(dir), op_data, &cb_op, offset, &page);
 	if (rc != 0)
 		return ERR_PTR(rc);
 
+	/* pages of striped directories are built by LMV for each read */
+	if (ll_i2info(dir)->lli_lsm_md != NULL)
+		return page;
+
+	hit = op_data->op_cli_flags & CLI_READDIR_HIT;
+	ll_stats_ops_tally(sbi, hit ? LPROC_LL_READDIR_HITS :
+				      LPROC_LL_READDIR_MISSES, 1);
+	if (ra != NULL)
+		ll_dir_ra_done(ra, page, hit, start, ktime_to_ns(ktime_get()));
+
 	return page;
 }
 
@@ -177,11 +264,11 @@ void ll_release_page(struct inode *inode, struct page *page,
 
 #ifdef HAVE_DIR_CONTEXT
 int ll_dir_read(struct inode *inode, __u64 *ppos, struct md_op_data *op_data,
-		struct dir_context *ctx)
+		struct ll_dir_ra_state *ra, struct dir_context *ctx)
 {
 #else
 int ll_dir_read(struct inode *inode, __u64 *ppos, struct md_op_data *op_data,
-		void *cookie, filldir_t filldir)
+		struct ll_dir_ra_state *ra, void *cookie, filldir_t filldir)
 {
 #endif
 	struct ll_sb_info    *sbi        = ll_i2sbi(inode);
@@ -195,6 +282,7 @@ int ll_dir_read(struct inode *inode, __u64 *ppos, struct md_op_data *op_data,
 	ENTRY;
 
 	ll_dir_chain_init(&chain);
+	chain.ldc_ra = ra;
 
 	page = ll_get_dir_page(inode, op_data, pos, &chain);
 
@@ -351,12 +439,16 @@ static int ll_readdir(struct file *filp, void *cookie, filldir_t filldir)
 		}
 	}
 	op_data->op_max_pages = sbi->ll_md_brw_pages;
+	if (lfd != NULL)
+		op_data->op_dir_merge = &lfd->fd_dir_merge;
 #ifdef HAVE_DIR_CONTEXT
 	ctx->pos = pos;
-	rc = ll_dir_read(inode, &pos, op_data, ctx);
+	rc = ll_dir_read(inode, &pos, op_data, lfd != NULL ? &lfd->fd_dra : NULL,
+			 ctx);
 	pos = ctx->pos;
 #else
-	rc = ll_dir_read(inode, &pos, op_data, cookie, filldir);
+	rc = ll_dir_read(inode, &pos, op_data, lfd != NULL ? &lfd->fd_dra : NULL,
+			 cookie, filldir);
 #endif
 	if (lfd != NULL)
 		lfd->lfd_pos = pos;
@@ -877,6 +969,31 @@ out:
 	return rc;
 }
 
+/*
+ * struct ioc_changelog grew the filter fields, binaries built before that
+ * pass the old, smaller struct. Only copy the filter in if the caller says
+ * it's there with CHANGELOG_FLAG_FILTER.
+ */
+static int changelog_ioctl(int cmd, struct obd_export *exp,
+			   struct ioc_changelog __user *uicc)
+{
+	struct ioc_changelog icc;
+
+	memset(&icc, 0, sizeof(icc));
+	if (copy_from_user(&icc, uicc,
+			   offsetof(struct ioc_changelog, icc_typemask)))
+		return -EFAULT;
+
+	if (cmd == OBD_IOC_CHANGELOG_SEND &&
+	    icc.icc_flags & CHANGELOG_FLAG_FILTER &&
+	    copy_from_user(&icc.icc_typemask, &uicc->icc_typemask,
+			   sizeof(icc) -
+			   offsetof(struct ioc_changelog, icc_typemask)))
+		return -EFAULT;
+
+	return obd_iocontrol(cmd, exp, sizeof(icc), &icc, NULL);
+}
+
 static int quotactl_ioctl(struct ll_sb_info *sbi, struct if_quotactl *qctl)
 {
         int cmd = qctl->qc_cmd;
@@ -1649,9 +1766,8 @@ out_rmdir:
         }
         case OBD_IOC_CHANGELOG_SEND:
         case OBD_IOC_CHANGELOG_CLEAR:
-		rc = copy_and_ioctl(cmd, sbi->ll_md_exp, (void __user *)arg,
-                                    sizeof(struct ioc_changelog));
-                RETURN(rc);
+		RETURN(changelog_ioctl(cmd, sbi->ll_md_exp,
+				       (struct ioc_changelog __user *)arg));
 	case OBD_IOC_FID2PATH:
 		RETURN(ll_fid2path(inode, (void __user *)arg));
 	case LL_IOC_GETPARENT:
@@ -76,8 +76,12 @@ static struct ll_file_data *ll_file_data_get(void)
 
 static void ll_file_data_put(struct ll_file_data *fd)
 {
-        if (fd != NULL)
-                OBD_SLAB_FREE_PTR(fd, ll_file_data_slab);
+	if (fd == NULL)
+		return;
+
+	if (fd->fd_dir_merge != NULL)
+		lmv_free_dir_merge(fd->fd_dir_merge);
+	OBD_SLAB_FREE_PTR(fd, ll_file_data_slab);
 }
 
 void ll_pack_inode2opdata(struct inode *inode, struct md_op_data *op_data,
@@ -262,6 +266,54 @@ int ll_md_real_close(struct inode *inode, fmode_t fmode)
 	RETURN(rc);
 }
 
+/**
+ * Update open heat of \a inode on close. Called under lli_och_mutex.
+ */
+static void ll_file_open_heat(struct inode *inode)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	cfs_time_t now = cfs_time_current();
+	cfs_duration_t window;
+
+	window = cfs_time_seconds(ll_i2sbi(inode)->ll_oc_thrsh_ms) / 1000;
+	if (cfs_time_after(now, cfs_time_add(lli->lli_open_heat_time,
+					     window))) {
+		lli->lli_open_heat_time = now;
+		lli->lli_open_heat_count = 0;
+	}
+	lli->lli_open_heat_count++;
+}
+
+/**
+ * Whether a new open of \a inode may skip the open intent lookup and be
+ * served by a cached open handle, or, if there is none yet, by an open by
+ * FID fetching an OPEN lock to cache the handle under.
+ *
+ * Used by ll_revalidate_dentry() for a file that was recently closed at
+ * least ll_sb_info::ll_oc_thrsh_count times within ll_oc_thrsh_ms. Cached
+ * handles are closed when their OPEN lock is cancelled, either by conflict
+ * or from the LRU, see ll_md_blocking_ast().
+ */
+bool ll_file_open_cacheable(struct inode *inode)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	cfs_duration_t window;
+
+	if (!S_ISREG(inode->i_mode) || sbi->ll_oc_thrsh_count == 0)
+		return false;
+
+	/* unused handles are kept under an OPEN lock only */
+	if (lli->lli_mds_read_och != NULL || lli->lli_mds_write_och != NULL ||
+	    lli->lli_mds_exec_och != NULL)
+		return true;
+
+	window = cfs_time_seconds(sbi->ll_oc_thrsh_ms) / 1000;
+	return lli->lli_open_heat_count >= sbi->ll_oc_thrsh_count &&
+	       !cfs_time_after(cfs_time_current(),
+			       cfs_time_add(lli->lli_open_heat_time, window));
+}
+
 static int ll_md_close(struct obd_export *md_exp, struct inode *inode,
 		       struct file *file)
 {
@@ -302,6 +354,7 @@ static int ll_md_close(struct obd_export *md_exp, struct inode *inode,
                 ldlm_policy_data_t policy = {.l_inodebits={MDS_INODELOCK_OPEN}};
 
 		mutex_lock(&lli->lli_och_mutex);
+		ll_file_open_heat(inode);
                 if (fd->fd_omode & FMODE_WRITE) {
                         lockmode = LCK_CW;
                         LASSERT(lli->lli_open_fd_write_count);
@@ -624,6 +677,11 @@ restart:
                         }
 
                         ll_release_openhandle(file->f_dentry, it);
+			ll_stats_ops_tally(ll_i2sbi(inode),
+					   LPROC_LL_OPENCACHE_MISSES, 1);
+		} else if (S_ISREG(inode->i_mode)) {
+			ll_stats_ops_tally(ll_i2sbi(inode),
+					   LPROC_LL_OPENCACHE_HITS, 1);
                 }
                 (*och_usecount)++;
 
@@ -666,6 +724,9 @@ restart:
                         GOTO(out_och_free, rc = -ENOMEM);
 
                 (*och_usecount)++;
+		if (S_ISREG(inode->i_mode))
+			ll_stats_ops_tally(ll_i2sbi(inode),
+					   LPROC_LL_OPENCACHE_MISSES, 1);
 
                 /* md_intent_lock() didn't get a request ref if there was an
                  * open error, so don't do cleanup on the request here
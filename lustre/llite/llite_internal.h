@@ -169,6 +169,10 @@ struct ll_inode_info {
 	__u64				lli_open_fd_exec_count;
 	/* Protects access to och pointers and their usage counters */
 	struct mutex			lli_och_mutex;
+	/* start of the current open heat window and # of closes within it,
+	 * protected by lli_och_mutex, see ll_file_open_cacheable() */
+	cfs_time_t			lli_open_heat_time;
+	unsigned int			lli_open_heat_count;
 
 	struct inode			lli_vfs_inode;
 
@@ -552,6 +556,16 @@ struct ll_sb_info {
 						  * count */
 	atomic_t		  ll_agl_total;  /* AGL thread started count */
 
+	/* open handle cache: keep open handles of a file under an OPEN lock
+	 * once it has been closed ll_oc_thrsh_count times within
+	 * ll_oc_thrsh_ms, 0 count disables it */
+	unsigned int		  ll_oc_thrsh_count;
+	unsigned int		  ll_oc_thrsh_ms;
+
+	/* most READPAGE RPCs read ahead of a sequential readdir, 0
+	 * disables readdir read-ahead */
+	unsigned int		  ll_dir_ra_max;
+
 	dev_t			  ll_sdev_orig; /* save s_dev before assign for
 						 * clustred nfs */
 	struct rmtacl_ctl_table	  ll_rct;
@@ -563,6 +577,15 @@ struct ll_sb_info {
 
 #define LL_DEFAULT_MAX_RW_CHUNK      (32 * 1024 * 1024)
 
+/* default open handle cache thresholds */
+#define LL_OC_THRSH_COUNT_DEF	5
+#define LL_OC_THRSH_MS_DEF	100
+
+/* readdir read-ahead */
+#define LL_DIR_RA_MAX_DEF	8
+#define LL_DIR_RA_MAX		64
+#define LL_DIR_RA_SEQ_MIN	2	/* sequential pages to start */
+
 /*
  * per file-descriptor read-ahead data.
  */
@@ -645,8 +668,22 @@ struct ll_readahead_state {
 
 extern struct kmem_cache *ll_file_data_slab;
 struct lustre_handle;
+/* readdir read-ahead state of an open directory, see ll_dir_ra_update() */
+struct ll_dir_ra_state {
+	__u64		dra_start;	/* hash range of the last page read */
+	__u64		dra_end;
+	unsigned int	dra_seq;	/* pages read in sequence */
+	unsigned int	dra_rpcs;	/* READPAGE RPCs to read ahead */
+	__u64		dra_last_ns;	/* when the last page was returned */
+	__u64		dra_rpc_ns;	/* READPAGE latency */
+	__u64		dra_use_ns;	/* time to use a page */
+};
+
 struct ll_file_data {
 	struct ll_readahead_state fd_ras;
+	struct ll_dir_ra_state fd_dra;
+	/* readdir state of a striped directory, see lmv_read_striped_page() */
+	struct lmv_dir_merge *fd_dir_merge;
 	struct ccc_grouplock fd_grouplock;
 	__u64 lfd_pos;
 	__u32 fd_flags;
@@ -741,15 +778,21 @@ enum {
 	LPROC_LL_LISTXATTR,
 	LPROC_LL_REMOVEXATTR,
 	LPROC_LL_INODE_PERM,
+	LPROC_LL_OPENCACHE_HITS,
+	LPROC_LL_OPENCACHE_MISSES,
+	LPROC_LL_READDIR_HITS,
+	LPROC_LL_READDIR_MISSES,
 	LPROC_LL_FILE_OPCODES
 };
 
 /* llite/dir.c */
 struct ll_dir_chain {
+	struct ll_dir_ra_state	*ldc_ra;	/* NULL: no read-ahead */
 };
 
 static inline void ll_dir_chain_init(struct ll_dir_chain *chain)
 {
+	chain->ldc_ra = NULL;
 }
 
 static inline void ll_dir_chain_fini(struct ll_dir_chain *chain)
@@ -760,10 +803,10 @@ extern const struct file_operations ll_dir_operations;
 extern const struct inode_operations ll_dir_inode_operations;
 #ifdef HAVE_DIR_CONTEXT
 int ll_dir_read(struct inode *inode, __u64 *pos, struct md_op_data *op_data,
-		struct dir_context *ctx);
+		struct ll_dir_ra_state *ra, struct dir_context *ctx);
 #else
 int ll_dir_read(struct inode *inode, __u64 *pos, struct md_op_data *op_data,
-		void *cookie, filldir_t filldir);
+		struct ll_dir_ra_state *ra, void *cookie, filldir_t filldir);
 #endif
 int ll_get_mdt_idx(struct inode *inode);
 int ll_get_mdt_idx_by_fid(struct ll_sb_info *sbi, const struct lu_fid *fid);
@@ -820,6 +863,7 @@ int ll_glimpse_ioctl(struct ll_sb_info *sbi,
 void ll_ioepoch_open(struct ll_inode_info *lli, __u64 ioepoch);
 int ll_release_openhandle(struct dentry *, struct lookup_intent *);
 int ll_md_real_close(struct inode *inode, fmode_t fmode);
+bool ll_file_open_cacheable(struct inode *inode);
 void ll_ioepoch_close(struct inode *inode, struct md_op_data *op_data,
                       struct obd_client_handle **och, unsigned long flags);
 void ll_done_writing_attr(struct inode *inode, struct md_op_data *op_data);
@@ -142,6 +142,10 @@ static struct ll_sb_info *ll_init_sbi(void)
 	atomic_set(&sbi->ll_agl_total, 0);
 	sbi->ll_flags |= LL_SBI_AGL_ENABLED;
 
+	sbi->ll_oc_thrsh_count = LL_OC_THRSH_COUNT_DEF;
+	sbi->ll_oc_thrsh_ms = LL_OC_THRSH_MS_DEF;
+	sbi->ll_dir_ra_max = LL_DIR_RA_MAX_DEF;
+
 	/* root squash */
 	sbi->ll_squash.rsi_uid = 0;
 	sbi->ll_squash.rsi_gid = 0;
@@ -243,9 +243,10 @@ static int ll_get_name(struct dentry *dentry, char *name,
 	op_data->op_max_pages = ll_i2sbi(dir)->ll_md_brw_pages;
 	mutex_lock(&dir->i_mutex);
 #ifdef HAVE_DIR_CONTEXT
-	rc = ll_dir_read(dir, &pos, op_data, &lgd.ctx);
+	rc = ll_dir_read(dir, &pos, op_data, NULL, &lgd.ctx);
 #else
-	rc = ll_dir_read(dir, &pos, op_data, &lgd, ll_nfs_get_name_filldir);
+	rc = ll_dir_read(dir, &pos, op_data, NULL, &lgd,
+			 ll_nfs_get_name_filldir);
 #endif
 	mutex_unlock(&dir->i_mutex);
 	ll_finish_md_op_data(op_data);
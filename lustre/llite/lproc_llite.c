@@ -715,6 +715,92 @@ static ssize_t ll_statahead_agl_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(ll_statahead_agl);
 
+static int ll_opencache_threshold_count_seq_show(struct seq_file *m, void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	return seq_printf(m, "%u\n", sbi->ll_oc_thrsh_count);
+}
+
+static ssize_t
+ll_opencache_threshold_count_seq_write(struct file *file,
+				       const char __user *buffer,
+				       size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ll_sb_info *sbi = ll_s2sbi((struct super_block *)m->private);
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < 0)
+		return -ERANGE;
+
+	sbi->ll_oc_thrsh_count = val;
+	return count;
+}
+LPROC_SEQ_FOPS(ll_opencache_threshold_count);
+
+static int ll_opencache_threshold_ms_seq_show(struct seq_file *m, void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	return seq_printf(m, "%u\n", sbi->ll_oc_thrsh_ms);
+}
+
+static ssize_t
+ll_opencache_threshold_ms_seq_write(struct file *file,
+				    const char __user *buffer,
+				    size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ll_sb_info *sbi = ll_s2sbi((struct super_block *)m->private);
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val <= 0)
+		return -ERANGE;
+
+	sbi->ll_oc_thrsh_ms = val;
+	return count;
+}
+LPROC_SEQ_FOPS(ll_opencache_threshold_ms);
+
+static int ll_dir_readahead_max_seq_show(struct seq_file *m, void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	return seq_printf(m, "%u\n", sbi->ll_dir_ra_max);
+}
+
+static ssize_t
+ll_dir_readahead_max_seq_write(struct file *file, const char __user *buffer,
+			       size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ll_sb_info *sbi = ll_s2sbi((struct super_block *)m->private);
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < 0 || val > LL_DIR_RA_MAX)
+		return -ERANGE;
+
+	sbi->ll_dir_ra_max = val;
+	return count;
+}
+LPROC_SEQ_FOPS(ll_dir_readahead_max);
+
 static int ll_statahead_stats_seq_show(struct seq_file *m, void *v)
 {
 	struct super_block *sb = m->private;
@@ -1002,6 +1088,12 @@ struct lprocfs_vars lprocfs_llite_obd_vars[] = {
 	  .fops	=	&ll_statahead_max_fops			},
 	{ .name	=	"statahead_agl",
 	  .fops	=	&ll_statahead_agl_fops			},
+	{ .name	=	"opencache_threshold_count",
+	  .fops	=	&ll_opencache_threshold_count_fops	},
+	{ .name	=	"opencache_threshold_ms",
+	  .fops	=	&ll_opencache_threshold_ms_fops		},
+	{ .name	=	"dir_readahead_max",
+	  .fops	=	&ll_dir_readahead_max_fops		},
 	{ .name	=	"statahead_stats",
 	  .fops	=	&ll_statahead_stats_fops		},
 	{ .name	=	"lazystatfs",
@@ -1079,6 +1171,10 @@ static const struct llite_file_opcode {
         { LPROC_LL_LISTXATTR,      LPROCFS_TYPE_REGS, "listxattr" },
         { LPROC_LL_REMOVEXATTR,    LPROCFS_TYPE_REGS, "removexattr" },
         { LPROC_LL_INODE_PERM,     LPROCFS_TYPE_REGS, "inode_permission" },
+	{ LPROC_LL_OPENCACHE_HITS, LPROCFS_TYPE_REGS, "opencache_hits" },
+	{ LPROC_LL_OPENCACHE_MISSES, LPROCFS_TYPE_REGS, "opencache_misses" },
+	{ LPROC_LL_READDIR_HITS,   LPROCFS_TYPE_REGS, "readdir_hits" },
+	{ LPROC_LL_READDIR_MISSES, LPROCFS_TYPE_REGS, "readdir_misses" },
 };
 
 void ll_stats_ops_tally(struct ll_sb_info *sbi, int op, int count)
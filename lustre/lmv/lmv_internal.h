@@ -132,6 +132,37 @@ static inline int lmv_stripe_md_size(int stripe_count)
 	return sizeof(*lsm) + stripe_count * sizeof(lsm->lsm_md_oinfo[0]);
 }
 
+/* READPAGE RPCs read ahead in each stripe of a striped directory */
+#define LMV_STRIPE_RA_RPCS	1
+
+/* position of the readdir of a striped directory in one of its stripes */
+struct lmv_stripe_cursor {
+	struct page	*lsc_page;	/* page of the next entry, NULL once
+					 * the stripe is exhausted */
+	void		*lsc_addr;	/* lsc_page kmap()ed while a page
+					 * is built, NULL otherwise */
+	unsigned int	 lsc_offset;	/* offset of the next entry in it */
+};
+
+/* readdir state of a striped directory kept by the open file, so that the
+ * entries of all the stripes are merged by hash without looking them up
+ * again for each page built, see lmv_read_striped_page() */
+struct lmv_dir_merge {
+	__u32			 ldm_stripe_count;
+	__u32			 ldm_layout_version;
+	struct page		*ldm_page;	/* last page built */
+	__u64			 ldm_start;	/* its hash range */
+	__u64			 ldm_end;
+	struct lmv_stripe_cursor ldm_cursors[0];
+};
+
+static inline int lmv_dir_merge_size(int stripe_count)
+{
+	struct lmv_dir_merge *merge;
+
+	return sizeof(*merge) + stripe_count * sizeof(merge->ldm_cursors[0]);
+}
+
 static inline const struct lmv_oinfo *
 lsm_name_to_stripe_info(const struct lmv_stripe_md *lsm, const char *name,
 			int namelen)
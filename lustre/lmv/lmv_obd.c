@@ -2223,280 +2223,476 @@ static int lmv_fsync(struct obd_export *exp, const struct lu_fid *fid,
 	RETURN(rc);
 }
 
+/* Switch op_data over to stripe \a i of the striped directory */
+static struct lmv_tgt_desc *lmv_stripe_target(struct lmv_obd *lmv,
+					      struct md_op_data *op_data,
+					      int i)
+{
+	struct lmv_oinfo	*oinfo = &op_data->op_mea1->lsm_md_oinfo[i];
+	struct lmv_tgt_desc	*tgt;
+
+	tgt = lmv_get_target(lmv, oinfo->lmo_mds, NULL);
+	if (IS_ERR(tgt))
+		return tgt;
+
+	/* op_data will be shared by each stripe, so we need
+	 * reset these value for each stripe */
+	op_data->op_fid1 = oinfo->lmo_fid;
+	op_data->op_fid2 = oinfo->lmo_fid;
+	op_data->op_data = oinfo->lmo_root;
+
+	return tgt;
+}
+
+/* Skip dummy entries, and . and .. of all stripes but the first one,
+ * because there can only be one . and .. in a directory */
+static bool lmv_stripe_dirent_skip(const struct lu_dirent *ent, int i)
+{
+	int namelen = le16_to_cpu(ent->lde_namelen);
+
+	if (namelen == 0)
+		return true;
+
+	return i != 0 && ent->lde_name[0] == '.' &&
+	       (namelen == 1 || (namelen == 2 && ent->lde_name[1] == '.'));
+}
+
+/* The cursors only keep a reference on their page between two readdir
+ * calls, the page is mapped while the entries are read from it */
+static void lmv_stripe_cursor_map(struct lmv_stripe_cursor *lsc)
+{
+	if (lsc->lsc_page != NULL && lsc->lsc_addr == NULL)
+		lsc->lsc_addr = kmap(lsc->lsc_page);
+}
+
+static void lmv_stripe_cursor_unmap(struct lmv_stripe_cursor *lsc)
+{
+	if (lsc->lsc_addr != NULL) {
+		kunmap(lsc->lsc_page);
+		lsc->lsc_addr = NULL;
+	}
+}
+
+static void lmv_stripe_cursor_put(struct lmv_stripe_cursor *lsc)
+{
+	if (lsc->lsc_page != NULL) {
+		lmv_stripe_cursor_unmap(lsc);
+		page_cache_release(lsc->lsc_page);
+		lsc->lsc_page = NULL;
+	}
+}
+
+static inline struct lu_dirent *
+lmv_stripe_cursor_ent(const struct lmv_stripe_cursor *lsc)
+{
+	LASSERT(lsc->lsc_addr != NULL);
+	return lsc->lsc_addr + lsc->lsc_offset;
+}
+
+static void lmv_dir_merge_unmap(struct lmv_dir_merge *merge)
+{
+	int i;
+
+	for (i = 0; i < merge->ldm_stripe_count; i++)
+		lmv_stripe_cursor_unmap(&merge->ldm_cursors[i]);
+}
+
 /**
- * Get current minimum entry from striped directory
- *
- * This function will search the dir entry, whose hash value is the
- * closest(>=) to @hash_offset, from all of sub-stripes, and it is
- * only being called for striped directory.
+ * Position the cursor of a stripe on its first entry whose hash is not
+ * less than \a hash, reading the following pages of the stripe as needed.
  *
- * \param[in] exp		export of LMV
- * \param[in] op_data		parameters transferred beween client MD stack
- *                              stripe_information will be included in this
- *                              parameter
- * \param[in] cb_op		ldlm callback being used in enqueue in
- *                              mdc_read_page
- * \param[in] hash_offset	the hash value, which is used to locate
- *                              minum(closet) dir entry
- * \param[in|out] stripe_offset the caller use this to indicate the stripe
- *                              index of last entry, so to avoid hash conflict
- *                              between stripes. It will also be used to
- *                              return the stripe index of current dir entry.
- * \param[in|out] entp		the minum entry and it also is being used
- *                              to input the last dir entry to resolve the
- *                              hash conflict
+ * \param[in] exp	export of LMV
+ * \param[in] op_data	readdir parameters, switched over to the stripe
+ * \param[in] cb_op	ldlm callback being used in enqueue in mdc_read_page
+ * \param[in] lsc	cursor of the stripe, its page is NULL once the
+ *                      stripe is exhausted, and left mapped otherwise
+ * \param[in] i		stripe index
+ * \param[in] hash	hash to look up
  *
- * \param[out] ppage		the page which holds the minum entry
- *
- * \retval                      = 0 get the entry successfully
- *                              negative errno (< 0) does not get the entry
+ * \retval		0 on success, negative errno on failure
  */
-static int lmv_get_min_striped_entry(struct obd_export *exp,
-				     struct md_op_data *op_data,
-				     struct md_callback *cb_op,
-				     __u64 hash_offset, int *stripe_offset,
-				     struct lu_dirent **entp,
-				     struct page **ppage)
+static int lmv_stripe_cursor_seek(struct obd_export *exp,
+				  struct md_op_data *op_data,
+				  struct md_callback *cb_op,
+				  struct lmv_stripe_cursor *lsc, int i,
+				  __u64 hash)
 {
-	struct obd_device	*obd = exp->exp_obd;
-	struct lmv_obd		*lmv = &obd->u.lmv;
-	struct lmv_stripe_md	*lsm = op_data->op_mea1;
+	struct lmv_obd		*lmv = &exp->exp_obd->u.lmv;
 	struct lmv_tgt_desc	*tgt;
-	int			stripe_count;
-	struct lu_dirent	*min_ent = NULL;
-	struct page		*min_page = NULL;
-	int			min_idx = 0;
-	int			i;
-	int			rc = 0;
-	ENTRY;
+	struct lu_dirpage	*dp;
+	struct lu_dirent	*ent;
+	struct page		*page;
+	int			rc;
 
-	stripe_count = lsm->lsm_md_stripe_count;
-	for (i = 0; i < stripe_count; i++) {
-		struct lu_dirent	*ent = NULL;
-		struct page		*page = NULL;
-		struct lu_dirpage	*dp;
-		__u64			stripe_hash = hash_offset;
+	lmv_stripe_cursor_put(lsc);
 
-		tgt = lmv_get_target(lmv, lsm->lsm_md_oinfo[i].lmo_mds, NULL);
-		if (IS_ERR(tgt))
-			GOTO(out, rc = PTR_ERR(tgt));
-
-		/* op_data will be shared by each stripe, so we need
-		 * reset these value for each stripe */
-		op_data->op_fid1 = lsm->lsm_md_oinfo[i].lmo_fid;
-		op_data->op_fid2 = lsm->lsm_md_oinfo[i].lmo_fid;
-		op_data->op_data = lsm->lsm_md_oinfo[i].lmo_root;
-next:
-		rc = md_read_page(tgt->ltd_exp, op_data, cb_op, stripe_hash,
-				  &page);
+	tgt = lmv_stripe_target(lmv, op_data, i);
+	if (IS_ERR(tgt))
+		return PTR_ERR(tgt);
+
+	while (hash != MDS_DIR_END_OFF) {
+		rc = md_read_page(tgt->ltd_exp, op_data, cb_op, hash, &page);
 		if (rc != 0)
-			GOTO(out, rc);
+			return rc;
 
 		dp = page_address(page);
 		for (ent = lu_dirent_start(dp); ent != NULL;
 		     ent = lu_dirent_next(ent)) {
-			/* Skip dummy entry */
-			if (le16_to_cpu(ent->lde_namelen) == 0)
+			if (le64_to_cpu(ent->lde_hash) < hash ||
+			    lmv_stripe_dirent_skip(ent, i))
 				continue;
 
-			if (le64_to_cpu(ent->lde_hash) < hash_offset)
-				continue;
+			/* md_read_page() returns the page mapped */
+			lsc->lsc_page = page;
+			lsc->lsc_addr = dp;
+			lsc->lsc_offset = (char *)ent - (char *)dp;
+			return 0;
+		}
 
-			if (le64_to_cpu(ent->lde_hash) == hash_offset &&
-			    (*entp == ent || i < *stripe_offset))
-				continue;
+		/* reach the end of this page, go to the next one */
+		hash = le64_to_cpu(dp->ldp_hash_end);
+		kunmap(page);
+		page_cache_release(page);
+	}
 
-			/* skip . and .. for other stripes */
-			if (i != 0 &&
-			    (strncmp(ent->lde_name, ".",
-				     le16_to_cpu(ent->lde_namelen)) == 0 ||
-			     strncmp(ent->lde_name, "..",
-				     le16_to_cpu(ent->lde_namelen)) == 0))
-				continue;
-			break;
+	return 0;
+}
+
+/* Move the cursor of stripe \a i to the entry after its current one */
+static int lmv_stripe_cursor_next(struct obd_export *exp,
+				  struct md_op_data *op_data,
+				  struct md_callback *cb_op,
+				  struct lmv_stripe_cursor *lsc, int i)
+{
+	struct lu_dirpage	*dp = lsc->lsc_addr;
+	struct lu_dirent	*ent = lmv_stripe_cursor_ent(lsc);
+	__u64			hash;
+
+	while ((ent = lu_dirent_next(ent)) != NULL) {
+		if (!lmv_stripe_dirent_skip(ent, i)) {
+			lsc->lsc_offset = (char *)ent - (char *)dp;
+			return 0;
 		}
+	}
 
-		if (ent == NULL) {
-			stripe_hash = le64_to_cpu(dp->ldp_hash_end);
+	hash = le64_to_cpu(dp->ldp_hash_end);
+	if (hash == MDS_DIR_END_OFF) {
+		lmv_stripe_cursor_put(lsc);
+		return 0;
+	}
 
-			kunmap(page);
-			page_cache_release(page);
-			page = NULL;
+	return lmv_stripe_cursor_seek(exp, op_data, cb_op, lsc, i, hash);
+}
 
-			/* reach the end of current stripe, go to next stripe */
-			if (stripe_hash == MDS_DIR_END_OFF)
-				continue;
-			else
-				goto next;
-		}
+/**
+ * Position the cursors of all the stripes at \a hash.
+ *
+ * The READPAGE RPCs of all the stripes are sent at once first, so that
+ * reading the first page of a striped directory takes about as long as
+ * reading one of its stripes. The read-ahead of each stripe then keeps
+ * the stripes read in parallel while their entries are merged.
+ */
+static int lmv_dir_merge_seek(struct obd_export *exp,
+			      struct md_op_data *op_data,
+			      struct md_callback *cb_op,
+			      struct lmv_dir_merge *merge, __u64 hash)
+{
+	struct lmv_obd		*lmv = &exp->exp_obd->u.lmv;
+	struct lmv_tgt_desc	*tgt;
+	struct page		*page;
+	int			i;
+	int			rc;
 
-		if (min_ent != NULL) {
-			if (le64_to_cpu(min_ent->lde_hash) >
-			    le64_to_cpu(ent->lde_hash)) {
-				min_ent = ent;
-				kunmap(min_page);
-				page_cache_release(min_page);
-				min_idx = i;
-				min_page = page;
-			} else {
-				kunmap(page);
-				page_cache_release(page);
-				page = NULL;
-			}
-		} else {
-			min_ent = ent;
-			min_page = page;
-			min_idx = i;
+	for (i = 0; i < merge->ldm_stripe_count; i++)
+		lmv_stripe_cursor_put(&merge->ldm_cursors[i]);
+
+	if (merge->ldm_stripe_count > 1) {
+		op_data->op_cli_flags |= CLI_READDIR_ASYNC;
+		for (i = 0; i < merge->ldm_stripe_count; i++) {
+			tgt = lmv_stripe_target(lmv, op_data, i);
+			if (!IS_ERR(tgt))
+				md_read_page(tgt->ltd_exp, op_data, cb_op,
+					     hash, &page);
 		}
+		op_data->op_cli_flags &= ~CLI_READDIR_ASYNC;
 	}
 
-out:
-	if (*ppage != NULL) {
-		kunmap(*ppage);
-		page_cache_release(*ppage);
+	for (i = 0; i < merge->ldm_stripe_count; i++) {
+		rc = lmv_stripe_cursor_seek(exp, op_data, cb_op,
+					    &merge->ldm_cursors[i], i, hash);
+		if (rc != 0)
+			return rc;
 	}
-	*stripe_offset = min_idx;
-	*entp = min_ent;
-	*ppage = min_page;
-	RETURN(rc);
+
+	return 0;
 }
 
 /**
- * Build dir entry page from a striped directory
+ * Read again the stripes whose cursor page was dropped from the cache since
+ * the last page was built, the UPDATE lock of the stripe being cancelled.
+ */
+static int lmv_dir_merge_revalidate(struct obd_export *exp,
+				    struct md_op_data *op_data,
+				    struct md_callback *cb_op,
+				    struct lmv_dir_merge *merge)
+{
+	struct lmv_stripe_cursor	*lsc;
+	__u64				hash;
+	int				i;
+	int				rc;
+
+	for (i = 0; i < merge->ldm_stripe_count; i++) {
+		lsc = &merge->ldm_cursors[i];
+		if (lsc->lsc_page == NULL || lsc->lsc_page->mapping != NULL)
+			continue;
+
+		lmv_stripe_cursor_map(lsc);
+		hash = le64_to_cpu(lmv_stripe_cursor_ent(lsc)->lde_hash);
+		rc = lmv_stripe_cursor_seek(exp, op_data, cb_op, lsc, i, hash);
+		if (rc != 0)
+			return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Build a dir entry page of a striped directory
  *
- * This function gets one entry by @offset from a striped directory. It will
- * read entries from all of stripes, and choose one closest to the required
- * offset(&offset). A few notes
- * 1. skip . and .. for non-zero stripes, because there can only have one .
- * and .. in a directory.
- * 2. op_data will be shared by all of stripes, instead of allocating new
- * one, so need to restore before reusing.
- * 3. release the entry page if that is not being chosen.
+ * Fill a page with the entries of all the stripes in hash order, taking the
+ * entry of the smallest hash among the cursors of the stripes each time. A
+ * few notes
+ * 1. . and .. of the stripes are replaced with the master FID and the FID of
+ * its parent.
+ * 2. the page built is kept in @merge, so that the reader can come back to
+ * it, e.g. once its buffer is full.
  *
- * \param[in] exp	obd export refer to LMV
- * \param[in] op_data	hold those MD parameters of read_entry
- * \param[in] cb_op	ldlm callback being used in enqueue in mdc_read_entry
- * \param[out] ldp	the entry being read
- * \param[out] ppage	the page holding the entry. Note: because the entry
- *                      will be accessed in upper layer, so we need hold the
- *                      page until the usages of entry is finished, see
- *                      ll_dir_entry_next.
+ * \param[in] exp		export of LMV
+ * \param[in] op_data		parameters of the readdir
+ * \param[in] cb_op		ldlm callback being used in enqueue in
+ *                              mdc_read_page
+ * \param[in] merge		cursors of the stripes
+ * \param[in] offset		hash of the page start
+ * \param[in] master_fid	FID of the striped directory
+ * \param[out] ppage		the page built
  *
- * retval		=0 if get entry successfully
- *                      <0 cannot get entry
+ * \retval			0 on success, negative errno on failure
  */
-static int lmv_read_striped_page(struct obd_export *exp,
-				 struct md_op_data *op_data,
-				 struct md_callback *cb_op,
-				 __u64 offset, struct page **ppage)
-{
-	struct obd_device	*obd = exp->exp_obd;
-	struct lu_fid		master_fid = op_data->op_fid1;
-	struct inode		*master_inode = op_data->op_data;
+static int lmv_dir_merge_fill(struct obd_export *exp,
+			      struct md_op_data *op_data,
+			      struct md_callback *cb_op,
+			      struct lmv_dir_merge *merge, __u64 offset,
+			      const struct lu_fid *master_fid,
+			      struct page **ppage)
+{
+	struct lu_fid		parent_fid = op_data->op_fid3;
 	__u64			hash_offset = offset;
 	struct lu_dirpage	*dp;
-	struct page		*min_ent_page = NULL;
-	struct page		*ent_page = NULL;
+	struct page		*ent_page;
 	struct lu_dirent	*ent;
-	void			*area;
-	int			ent_idx = 0;
-	struct lu_dirent	*min_ent = NULL;
-	struct lu_dirent	*last_ent;
+	struct lu_dirent	*last_ent = NULL;
+	__u32			flags = LDF_COLLIDE;
 	size_t			left_bytes;
-	int			rc;
-	ENTRY;
-
-	rc = lmv_check_connect(obd);
-	if (rc)
-		RETURN(rc);
+	int			i;
+	int			rc = 0;
 
-	/* Allocate a page and read entries from all of stripes and fill
-	 * the page by hash order */
 	ent_page = alloc_page(GFP_KERNEL);
 	if (ent_page == NULL)
-		RETURN(-ENOMEM);
+		return -ENOMEM;
+
+	for (i = 0; i < merge->ldm_stripe_count; i++)
+		lmv_stripe_cursor_map(&merge->ldm_cursors[i]);
 
 	/* Initialize the entry page */
 	dp = kmap(ent_page);
 	memset(dp, 0, sizeof(*dp));
 	dp->ldp_hash_start = cpu_to_le64(offset);
-	dp->ldp_flags |= LDF_COLLIDE;
 
-	area = dp + 1;
+	ent = (void *)(dp + 1);
 	left_bytes = PAGE_CACHE_SIZE - sizeof(*dp);
-	ent = area;
-	last_ent = ent;
-	do {
-		__u16	ent_size;
-
-		/* Find the minum entry from all sub-stripes */
-		rc = lmv_get_min_striped_entry(exp, op_data, cb_op, hash_offset,
-					       &ent_idx, &min_ent,
-					       &min_ent_page);
-		if (rc != 0)
-			GOTO(out, rc);
+	while (1) {
+		struct lu_dirent	*min_ent = NULL;
+		int			min_idx = 0;
+		__u16			namelen;
+		__u16			ent_size;
+
+		/* Find the minimum entry from all sub-stripes */
+		for (i = 0; i < merge->ldm_stripe_count; i++) {
+			struct lu_dirent *tmp;
+
+			if (merge->ldm_cursors[i].lsc_page == NULL)
+				continue;
 
-		/* If it can not get minum entry, it means it already reaches
-		 * the end of this directory */
+			tmp = lmv_stripe_cursor_ent(&merge->ldm_cursors[i]);
+			if (min_ent == NULL || le64_to_cpu(tmp->lde_hash) <
+					       le64_to_cpu(min_ent->lde_hash)) {
+				min_ent = tmp;
+				min_idx = i;
+			}
+		}
+
+		/* all the stripes are exhausted */
 		if (min_ent == NULL) {
-			last_ent->lde_reclen = 0;
 			hash_offset = MDS_DIR_END_OFF;
-			GOTO(out, rc);
+			break;
 		}
 
+		hash_offset = le64_to_cpu(min_ent->lde_hash);
+		namelen = le16_to_cpu(min_ent->lde_namelen);
 		ent_size = le16_to_cpu(min_ent->lde_reclen);
-
 		/* the last entry lde_reclen is 0, but it might not
 		 * the end of this entry of this temporay entry */
 		if (ent_size == 0)
-			ent_size = lu_dirent_calc_size(
-					le16_to_cpu(min_ent->lde_namelen),
+			ent_size = lu_dirent_calc_size(namelen,
 					le32_to_cpu(min_ent->lde_attrs));
-		if (ent_size > left_bytes) {
-			last_ent->lde_reclen = cpu_to_le16(0);
-			hash_offset = le64_to_cpu(min_ent->lde_hash);
-			GOTO(out, rc);
-		}
+		if (ent_size > left_bytes)
+			break;
 
 		memcpy(ent, min_ent, ent_size);
 
 		/* Replace . with master FID and Replace .. with the parent FID
 		 * of master object */
-		if (strncmp(ent->lde_name, ".",
-			    le16_to_cpu(ent->lde_namelen)) == 0 &&
-		    le16_to_cpu(ent->lde_namelen) == 1)
-			fid_cpu_to_le(&ent->lde_fid, &master_fid);
-		else if (strncmp(ent->lde_name, "..",
-				   le16_to_cpu(ent->lde_namelen)) == 0 &&
-			   le16_to_cpu(ent->lde_namelen) == 2)
-			fid_cpu_to_le(&ent->lde_fid, &op_data->op_fid3);
+		if (namelen == 1 && ent->lde_name[0] == '.')
+			fid_cpu_to_le(&ent->lde_fid, master_fid);
+		else if (namelen == 2 && strncmp(ent->lde_name, "..", 2) == 0)
+			fid_cpu_to_le(&ent->lde_fid, &parent_fid);
 
 		left_bytes -= ent_size;
 		ent->lde_reclen = cpu_to_le16(ent_size);
 		last_ent = ent;
 		ent = (void *)ent + ent_size;
-		hash_offset = le64_to_cpu(min_ent->lde_hash);
-		if (hash_offset == MDS_DIR_END_OFF) {
-			last_ent->lde_reclen = 0;
+		if (hash_offset == MDS_DIR_END_OFF)
 			break;
+
+		rc = lmv_stripe_cursor_next(exp, op_data, cb_op,
+					    &merge->ldm_cursors[min_idx],
+					    min_idx);
+		if (rc != 0) {
+			kunmap(ent_page);
+			__free_page(ent_page);
+			return rc;
 		}
-	} while (1);
-out:
-	if (min_ent_page != NULL) {
-		kunmap(min_ent_page);
-		page_cache_release(min_ent_page);
 	}
 
-	if (unlikely(rc != 0)) {
-		__free_page(ent_page);
-		ent_page = NULL;
-	} else {
-		if (ent == area)
-			dp->ldp_flags |= LDF_EMPTY;
-		dp->ldp_flags = cpu_to_le32(dp->ldp_flags);
-		dp->ldp_hash_end = cpu_to_le64(hash_offset);
+	if (last_ent != NULL)
+		last_ent->lde_reclen = 0;
+	else
+		flags |= LDF_EMPTY;
+	dp->ldp_flags = cpu_to_le32(flags);
+	dp->ldp_hash_end = cpu_to_le64(hash_offset);
+
+	if (merge->ldm_page != NULL)
+		__free_page(merge->ldm_page);
+	page_cache_get(ent_page);
+	merge->ldm_page = ent_page;
+	merge->ldm_start = offset;
+	merge->ldm_end = hash_offset;
+
+	*ppage = ent_page;
+
+	return 0;
+}
+
+/**
+ * Release the readdir state of a striped directory
+ *
+ * \param[in] merge	state allocated by lmv_read_striped_page()
+ */
+void lmv_free_dir_merge(struct lmv_dir_merge *merge)
+{
+	int i;
+
+	if (merge->ldm_page != NULL)
+		__free_page(merge->ldm_page);
+
+	for (i = 0; i < merge->ldm_stripe_count; i++)
+		lmv_stripe_cursor_put(&merge->ldm_cursors[i]);
+
+	OBD_FREE(merge, lmv_dir_merge_size(merge->ldm_stripe_count));
+}
+EXPORT_SYMBOL(lmv_free_dir_merge);
+
+/**
+ * Build dir entry page from a striped directory
+ *
+ * This function gets the page of entries starting at @offset from a striped
+ * directory, merging the entries of all of the stripes by hash. The cursors
+ * of the stripes are kept in the merge state of the open directory
+ * (op_data->op_dir_merge), so that a sequential readdir reads each page of
+ * each stripe only once, and the stripes are read in parallel. A few notes
+ * 1. if the caller has no merge state, e.g. statahead, a temporary one is
+ * used for this page only.
+ * 2. op_data will be shared by all of stripes, instead of allocating new
+ * one, so need to restore before reusing.
+ *
+ * \param[in] exp	obd export refer to LMV
+ * \param[in] op_data	hold those MD parameters of read_entry
+ * \param[in] cb_op	ldlm callback being used in enqueue in mdc_read_entry
+ * \param[in] offset	the hash of the first entry of the page
+ * \param[out] ppage	the page built. Note: it is not in the page cache,
+ *                      the caller releases it with __free_page(), see
+ *                      ll_release_page().
+ *
+ * retval		=0 if get entry successfully
+ *                      <0 cannot get entry
+ */
+static int lmv_read_striped_page(struct obd_export *exp,
+				 struct md_op_data *op_data,
+				 struct md_callback *cb_op,
+				 __u64 offset, struct page **ppage)
+{
+	struct lmv_stripe_md	*lsm = op_data->op_mea1;
+	struct lu_fid		master_fid = op_data->op_fid1;
+	struct inode		*master_inode = op_data->op_data;
+	unsigned int		ra_rpcs = op_data->op_ra_rpcs;
+	struct lmv_dir_merge	*merge = NULL;
+	int			rc;
+	ENTRY;
+
+	if (op_data->op_dir_merge != NULL) {
+		merge = *op_data->op_dir_merge;
+		/* the layout changed since the last readdir */
+		if (merge != NULL &&
+		    (merge->ldm_stripe_count != lsm->lsm_md_stripe_count ||
+		     merge->ldm_layout_version !=
+					lsm->lsm_md_layout_version)) {
+			lmv_free_dir_merge(merge);
+			*op_data->op_dir_merge = NULL;
+			merge = NULL;
+		}
+	}
+
+	if (merge == NULL) {
+		OBD_ALLOC(merge, lmv_dir_merge_size(lsm->lsm_md_stripe_count));
+		if (merge == NULL)
+			RETURN(-ENOMEM);
+
+		merge->ldm_stripe_count = lsm->lsm_md_stripe_count;
+		merge->ldm_layout_version = lsm->lsm_md_layout_version;
+		if (op_data->op_dir_merge != NULL)
+			*op_data->op_dir_merge = merge;
 	}
 
+	/* the reader comes back to the last page built, e.g. after its
+	 * buffer was filled */
+	if (merge->ldm_page != NULL && offset >= merge->ldm_start &&
+	    offset < merge->ldm_end) {
+		page_cache_get(merge->ldm_page);
+		kmap(merge->ldm_page);
+		*ppage = merge->ldm_page;
+		GOTO(out, rc = 0);
+	}
+
+	op_data->op_ra_rpcs = max_t(unsigned int, ra_rpcs, LMV_STRIPE_RA_RPCS);
+	if (merge->ldm_page != NULL && offset == merge->ldm_end)
+		rc = lmv_dir_merge_revalidate(exp, op_data, cb_op, merge);
+	else
+		rc = lmv_dir_merge_seek(exp, op_data, cb_op, merge, offset);
+	if (rc == 0)
+		rc = lmv_dir_merge_fill(exp, op_data, cb_op, merge, offset,
+					&master_fid, ppage);
+	lmv_dir_merge_unmap(merge);
+
 	/* We do not want to allocate md_op_data during each
 	 * dir entry reading, so op_data will be shared by every stripe,
 	 * then we need to restore it back to original value before
@@ -2504,8 +2700,15 @@ out:
 	op_data->op_fid1 = master_fid;
 	op_data->op_fid2 = master_fid;
 	op_data->op_data = master_inode;
-
-	*ppage = ent_page;
+	op_data->op_ra_rpcs = ra_rpcs;
+out:
+	if (op_data->op_dir_merge == NULL) {
+		lmv_free_dir_merge(merge);
+	} else if (rc != 0) {
+		/* the cursors are not consistent any more */
+		lmv_free_dir_merge(merge);
+		*op_data->op_dir_merge = NULL;
+	}
 
 	RETURN(rc);
 }
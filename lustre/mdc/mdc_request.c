@@ -41,6 +41,7 @@
 #include <linux/miscdevice.h>
 #include <linux/init.h>
 #include <linux/utsname.h>
+#include <linux/workqueue.h>
 
 #include <lustre_acl.h>
 #include <lustre_ioctl.h>
@@ -1024,34 +1025,27 @@ static int mdc_done_writing(struct obd_export *exp, struct md_op_data *op_data,
         RETURN(rc);
 }
 
-static int mdc_getpage(struct obd_export *exp, const struct lu_fid *fid,
-		       __u64 offset, struct obd_capa *oc,
-		       struct page **pages, int npages,
-		       struct ptlrpc_request **request)
+/* Prepare a READPAGE RPC reading \a npages at hash \a offset */
+static struct ptlrpc_request *
+mdc_getpage_prep(struct obd_export *exp, const struct lu_fid *fid,
+		 __u64 offset, struct obd_capa *oc, struct page **pages,
+		 int npages)
 {
 	struct ptlrpc_request   *req;
 	struct ptlrpc_bulk_desc *desc;
 	int                      i;
-	wait_queue_head_t        waitq;
-	int                      resends = 0;
-	struct l_wait_info       lwi;
 	int                      rc;
-	ENTRY;
 
-	*request = NULL;
-	init_waitqueue_head(&waitq);
-
-restart_bulk:
 	req = ptlrpc_request_alloc(class_exp2cliimp(exp), &RQF_MDS_READPAGE);
 	if (req == NULL)
-		RETURN(-ENOMEM);
+		return ERR_PTR(-ENOMEM);
 
 	mdc_set_capa_size(req, &RMF_CAPA1, oc);
 
 	rc = ptlrpc_request_pack(req, LUSTRE_MDS_VERSION, MDS_READPAGE);
 	if (rc) {
 		ptlrpc_request_free(req);
-		RETURN(rc);
+		return ERR_PTR(rc);
 	}
 
 	req->rq_request_portal = MDS_READPAGE_PORTAL;
@@ -1061,7 +1055,7 @@ restart_bulk:
 				    MDS_BULK_PORTAL);
 	if (desc == NULL) {
 		ptlrpc_request_free(req);
-		RETURN(-ENOMEM);
+		return ERR_PTR(-ENOMEM);
 	}
 
 	/* NB req now owns desc and will free it when it gets freed */
@@ -1071,6 +1065,51 @@ restart_bulk:
 	mdc_readdir_pack(req, offset, PAGE_CACHE_SIZE * npages, fid, oc);
 
 	ptlrpc_request_set_replen(req);
+
+	return req;
+}
+
+/* Check the bulk of a completed READPAGE RPC */
+static int mdc_getpage_check(struct obd_export *exp,
+			     struct ptlrpc_request *req, int npages)
+{
+	int rc;
+
+	rc = sptlrpc_cli_unwrap_bulk_read(req, req->rq_bulk,
+					  req->rq_bulk->bd_nob_transferred);
+	if (rc < 0)
+		return rc;
+
+	if (req->rq_bulk->bd_nob_transferred & ~LU_PAGE_MASK) {
+		CERROR("%s: unexpected bytes transferred: %d (%ld expected)\n",
+		       exp->exp_obd->obd_name, req->rq_bulk->bd_nob_transferred,
+		       PAGE_CACHE_SIZE * npages);
+		return -EPROTO;
+	}
+
+	return 0;
+}
+
+static int mdc_getpage(struct obd_export *exp, const struct lu_fid *fid,
+		       __u64 offset, struct obd_capa *oc,
+		       struct page **pages, int npages,
+		       struct ptlrpc_request **request)
+{
+	struct ptlrpc_request   *req;
+	wait_queue_head_t        waitq;
+	int                      resends = 0;
+	struct l_wait_info       lwi;
+	int                      rc;
+	ENTRY;
+
+	*request = NULL;
+	init_waitqueue_head(&waitq);
+
+restart_bulk:
+	req = mdc_getpage_prep(exp, fid, offset, oc, pages, npages);
+	if (IS_ERR(req))
+		RETURN(PTR_ERR(req));
+
 	rc = ptlrpc_queue_wait(req);
 	if (rc) {
 		ptlrpc_req_finished(req);
@@ -1090,21 +1129,12 @@ restart_bulk:
 		goto restart_bulk;
 	}
 
-	rc = sptlrpc_cli_unwrap_bulk_read(req, req->rq_bulk,
-					  req->rq_bulk->bd_nob_transferred);
+	rc = mdc_getpage_check(exp, req, npages);
 	if (rc < 0) {
 		ptlrpc_req_finished(req);
 		RETURN(rc);
 	}
 
-	if (req->rq_bulk->bd_nob_transferred & ~LU_PAGE_MASK) {
-		CERROR("%s: unexpected bytes transferred: %d (%ld expected)\n",
-		       exp->exp_obd->obd_name, req->rq_bulk->bd_nob_transferred,
-		       PAGE_CACHE_SIZE * npages);
-		ptlrpc_req_finished(req);
-		RETURN(-EPROTO);
-	}
-
 	*request = req;
 	RETURN(0);
 }
@@ -1145,8 +1175,7 @@ static struct page *mdc_page_locate(struct address_space *mapping, __u64 *hash,
 		 * page cannot be truncated (while DLM lock is held) and,
 		 * hence, can avoid restart.
 		 *
-		 * In fact, page cannot be locked here at all, because
-		 * mdc_read_page_remote does synchronous io.
+		 * The page is locked while mdc_readahead_send() reads it.
 		 */
 		wait_on_page_locked(page);
 		if (PageUptodate(page)) {
@@ -1183,6 +1212,10 @@ static struct page *mdc_page_locate(struct address_space *mapping, __u64 *hash,
 				    le32_to_cpu(dp->ldp_flags) & LDF_COLLIDE);
 				page = NULL;
 			}
+		} else if (page->mapping == NULL) {
+			/* a failed read-ahead removed it, read it again */
+			page_cache_release(page);
+			page = NULL;
 		} else {
 			page_cache_release(page);
 			page = ERR_PTR(-EIO);
@@ -1304,6 +1337,7 @@ struct readpage_param {
 	int			rp_hash64;
 	struct obd_export	*rp_exp;
 	struct md_callback	*rp_cb;
+	int			rp_remote;	/* read from the MDT */
 };
 
 #ifndef HAVE_DELETE_FROM_PAGE_CACHE
@@ -1324,20 +1358,92 @@ static inline void delete_from_page_cache(struct page *page)
  * in CFS_PAGE_SIZE (if CFS_PAGE_SIZE greater than LU_PAGE_SIZE), and the
  * lu_dirpage for this integrated page will be adjusted.
  **/
+/**
+ * Complete the read of \a npages directory pages, of which \a nob bytes
+ * were transferred, or which failed with \a rc. pages[0] is already in the
+ * page cache and locked, the other pages are added to it.
+ *
+ * \retval the hash following the last page read, MDS_DIR_END_OFF if none
+ */
+static __u64 mdc_dirpages_install(struct inode *inode, struct page **pages,
+				  int npages, int nob, int hash64, int rc)
+{
+	struct page		*page;
+	struct lu_dirpage	*dp;
+	__u64			 next = MDS_DIR_END_OFF;
+	int			 rd_pgs = 0; /* number of pages read actually */
+	int			 i;
+
+	if (rc < 0) {
+		/* page0 is special, which was added into page cache early */
+		delete_from_page_cache(pages[0]);
+	} else {
+		int lu_pgs;
+
+		rd_pgs = (nob + PAGE_CACHE_SIZE - 1) >> PAGE_CACHE_SHIFT;
+		lu_pgs = nob >> LU_PAGE_SHIFT;
+		LASSERT(!(nob & ~LU_PAGE_MASK));
+
+		CDEBUG(D_INODE, "read %d(%d) pages\n", rd_pgs, lu_pgs);
+
+		mdc_adjust_dirpages(pages, rd_pgs, lu_pgs);
+
+		if (rd_pgs > 0) {
+			dp = kmap(pages[rd_pgs - 1]);
+			next = le64_to_cpu(dp->ldp_hash_end);
+			kunmap(pages[rd_pgs - 1]);
+		}
+
+		SetPageUptodate(pages[0]);
+	}
+	unlock_page(pages[0]);
+
+	CDEBUG(D_CACHE, "read %d/%d pages\n", rd_pgs, npages);
+	for (i = 1; i < npages; i++) {
+		unsigned long	offset;
+		__u64		hash;
+		int ret;
+
+		page = pages[i];
+
+		if (rc < 0 || i >= rd_pgs) {
+			page_cache_release(page);
+			continue;
+		}
+
+		SetPageUptodate(page);
+
+		dp = kmap(page);
+		hash = le64_to_cpu(dp->ldp_hash_start);
+		kunmap(page);
+
+		offset = hash_x_index(hash, hash64);
+
+		prefetchw(&page->flags);
+		ret = add_to_page_cache_lru(page, inode->i_mapping, offset,
+					    GFP_NOFS);
+		if (ret == 0)
+			unlock_page(page);
+		else
+			CDEBUG(D_VFSTRACE, "page %lu add to page cache failed:"
+			       " rc = %d\n", offset, ret);
+		page_cache_release(page);
+	}
+
+	return next;
+}
+
 static int mdc_read_page_remote(void *data, struct page *page0)
 {
 	struct readpage_param	*rp = data;
 	struct page		**page_pool;
 	struct page		*page;
-	struct lu_dirpage	*dp;
-	int			rd_pgs = 0; /* number of pages read actually */
 	int			npages;
 	struct md_op_data	*op_data = rp->rp_mod;
 	struct ptlrpc_request	*req;
 	int			max_pages = op_data->op_max_pages;
 	struct inode		*inode;
 	struct lu_fid		*fid;
-	int			i;
 	int			rc;
 	ENTRY;
 
@@ -1361,65 +1467,223 @@ static int mdc_read_page_remote(void *data, struct page *page0)
 		page_pool[npages] = page;
 	}
 
+	rp->rp_remote = 1;
 	rc = mdc_getpage(rp->rp_exp, fid, rp->rp_off, op_data->op_capa1,
 			 page_pool, npages, &req);
-	if (rc < 0) {
-		/* page0 is special, which was added into page cache early */
-		delete_from_page_cache(page0);
-	} else {
-		int lu_pgs;
+	mdc_dirpages_install(inode, page_pool, npages,
+			     rc < 0 ? 0 : req->rq_bulk->bd_nob_transferred,
+			     rp->rp_hash64, rc);
+	ptlrpc_req_finished(req);
 
-		rd_pgs = (req->rq_bulk->bd_nob_transferred +
-			    PAGE_CACHE_SIZE - 1) >> PAGE_CACHE_SHIFT;
-		lu_pgs = req->rq_bulk->bd_nob_transferred >>
-							LU_PAGE_SHIFT;
-		LASSERT(!(req->rq_bulk->bd_nob_transferred & ~LU_PAGE_MASK));
+	if (page_pool != &page0)
+		OBD_FREE(page_pool, sizeof(page_pool[0]) * max_pages);
 
-		CDEBUG(D_INODE, "read %d(%d) pages\n", rd_pgs, lu_pgs);
+	RETURN(rc);
+}
+
+/* state of a chain of read-ahead READPAGE RPCs, see mdc_readahead_start() */
+struct mdc_readahead_args {
+	struct obd_export	*ra_exp;
+	struct inode		*ra_inode;
+	struct lu_fid		 ra_fid;
+	struct obd_capa		*ra_capa;
+	struct lustre_handle	 ra_lockh;
+	__u32			 ra_lock_mode;
+	struct page	       **ra_pages;
+	int			 ra_npages;
+	int			 ra_max_pages;
+	int			 ra_hash64;
+	int			 ra_left;	/* RPCs to send after this one */
+	struct work_struct	 ra_work;	/* release, see mdc_ra_wq */
+};
+
+/* Releases the chains finished by ptlrpcd: the last iput() of the directory
+ * may clear the inode and send a close RPC, which ptlrpcd must not wait for */
+static struct workqueue_struct *mdc_ra_wq;
+
+/* most cached pages looked up to find where read-ahead should start */
+#define MDC_RA_SKIP_MAX		(2 * PTLRPC_MAX_BRW_PAGES)
+
+static void mdc_readahead_fini(struct mdc_readahead_args *ra)
+{
+	ldlm_lock_decref(&ra->ra_lockh, ra->ra_lock_mode);
+	capa_put(ra->ra_capa);
+	iput(ra->ra_inode);
+	class_export_put(ra->ra_exp);
+	OBD_FREE(ra->ra_pages, sizeof(ra->ra_pages[0]) * ra->ra_max_pages);
+	OBD_FREE_PTR(ra);
+}
+
+static void mdc_readahead_fini_work(struct work_struct *work)
+{
+	mdc_readahead_fini(container_of(work, struct mdc_readahead_args,
+					ra_work));
+}
+
+static int mdc_readahead_send(struct mdc_readahead_args *ra, __u64 hash);
+
+/* a blocking callback is pending on the UPDATE lock, stop the chain and
+ * drop its reference so that the lock can be cancelled */
+static bool mdc_readahead_lock_busy(struct mdc_readahead_args *ra)
+{
+	struct ldlm_lock *lock;
+	bool		  busy;
 
-		mdc_adjust_dirpages(page_pool, rd_pgs, lu_pgs);
+	lock = ldlm_handle2lock(&ra->ra_lockh);
+	if (lock == NULL)
+		return true;
+	busy = ldlm_is_cbpending(lock);
+	LDLM_LOCK_PUT(lock);
+
+	return busy;
+}
+
+static int mdc_readahead_interpret(const struct lu_env *env,
+				   struct ptlrpc_request *req, void *args,
+				   int rc)
+{
+	struct mdc_readahead_args *ra = *(struct mdc_readahead_args **)args;
+	struct page		  *page0 = ra->ra_pages[0];
+	__u64			   next;
 
-		SetPageUptodate(page0);
+	if (rc == 0)
+		rc = mdc_getpage_check(ra->ra_exp, req, ra->ra_npages);
+	next = mdc_dirpages_install(ra->ra_inode, ra->ra_pages,
+				    ra->ra_npages,
+				    rc < 0 ? 0 : req->rq_bulk->bd_nob_transferred,
+				    ra->ra_hash64, rc);
+	/* the reader reaching the last RPC of the chain starts another one */
+	if (rc == 0 && ra->ra_left == 0)
+		SetPageReadahead(page0);
+	page_cache_release(page0);
+
+	if (rc == 0 && ra->ra_left > 0 && next != MDS_DIR_END_OFF &&
+	    !mdc_readahead_lock_busy(ra)) {
+		ra->ra_left--;
+		if (mdc_readahead_send(ra, next) == 0)
+			return 0;
 	}
-	unlock_page(page0);
+	INIT_WORK(&ra->ra_work, mdc_readahead_fini_work);
+	queue_work(mdc_ra_wq, &ra->ra_work);
 
-	ptlrpc_req_finished(req);
-	CDEBUG(D_CACHE, "read %d/%d pages\n", rd_pgs, npages);
-	for (i = 1; i < npages; i++) {
-		unsigned long	offset;
-		__u64		hash;
-		int ret;
+	return 0;
+}
 
-		page = page_pool[i];
+/* Send a READPAGE RPC for the pages starting at \a hash */
+static int mdc_readahead_send(struct mdc_readahead_args *ra, __u64 hash)
+{
+	struct address_space	*mapping = ra->ra_inode->i_mapping;
+	struct ptlrpc_request	*req;
+	struct page		*page;
+	int			 npages;
+	int			 rc;
 
-		if (rc < 0 || i >= rd_pgs) {
-			page_cache_release(page);
-			continue;
-		}
+	for (npages = 0; npages < ra->ra_max_pages; npages++) {
+		page = __page_cache_alloc(GFP_NOFS | __GFP_COLD);
+		if (page == NULL)
+			break;
+		ra->ra_pages[npages] = page;
+	}
+	if (npages == 0)
+		return -ENOMEM;
 
-		SetPageUptodate(page);
+	/* already cached, or being read by someone else */
+	rc = add_to_page_cache_lru(ra->ra_pages[0], mapping,
+				   hash_x_index(hash, ra->ra_hash64), GFP_NOFS);
+	if (rc != 0)
+		GOTO(out_free, rc);
+
+	req = mdc_getpage_prep(ra->ra_exp, &ra->ra_fid, hash, ra->ra_capa,
+			       ra->ra_pages, npages);
+	if (IS_ERR(req)) {
+		delete_from_page_cache(ra->ra_pages[0]);
+		unlock_page(ra->ra_pages[0]);
+		GOTO(out_free, rc = PTR_ERR(req));
+	}
+
+	CDEBUG(D_CACHE, "read-ahead "DFID" at "LPX64", %d pages, %d RPCs "
+	       "left\n", PFID(&ra->ra_fid), hash, npages, ra->ra_left);
+
+	ra->ra_npages = npages;
+	CLASSERT(sizeof(ra) <= sizeof(req->rq_async_args));
+	*(struct mdc_readahead_args **)ptlrpc_req_async_args(req) = ra;
+	req->rq_interpret_reply = mdc_readahead_interpret;
+	ptlrpcd_add_req(req, PDL_POLICY_LOCAL, -1);
+
+	return 0;
+out_free:
+	while (npages > 0)
+		page_cache_release(ra->ra_pages[--npages]);
+	return rc;
+}
 
+/**
+ * Read ahead op_data->op_ra_rpcs READPAGE RPCs after the page ending at hash
+ * \a hash, skipping the pages already cached. The RPCs are sent one after
+ * the other by ptlrpcd, each chain holding a reference on the UPDATE lock
+ * so that the pages cannot be cached after the lock is cancelled. The chain
+ * stops as soon as the lock is asked back, not to delay the conflicting
+ * modification for the whole chain.
+ */
+static void mdc_readahead_start(struct obd_export *exp,
+				struct md_op_data *op_data,
+				struct lookup_intent *it, __u64 hash,
+				int hash64)
+{
+	struct inode			*dir = op_data->op_data;
+	struct mdc_readahead_args	*ra;
+	struct lu_dirpage		*dp;
+	struct page			*page;
+	int				 i;
+
+	for (i = 0; i < MDC_RA_SKIP_MAX; i++) {
+		if (hash == MDS_DIR_END_OFF)
+			return;
+		page = find_get_page(dir->i_mapping, hash_x_index(hash, hash64));
+		if (page == NULL)
+			break;
+		if (!PageUptodate(page)) {
+			/* being read, by a chain which will go on */
+			page_cache_release(page);
+			return;
+		}
 		dp = kmap(page);
-		hash = le64_to_cpu(dp->ldp_hash_start);
+		hash = le64_to_cpu(dp->ldp_hash_end);
 		kunmap(page);
+		page_cache_release(page);
+	}
+	if (i == MDC_RA_SKIP_MAX)
+		return;
 
-		offset = hash_x_index(hash, rp->rp_hash64);
+	OBD_ALLOC_PTR(ra);
+	if (ra == NULL)
+		return;
 
-		prefetchw(&page->flags);
-		ret = add_to_page_cache_lru(page, inode->i_mapping, offset,
-					    GFP_KERNEL);
-		if (ret == 0)
-			unlock_page(page);
-		else
-			CDEBUG(D_VFSTRACE, "page %lu add to page cache failed:"
-			       " rc = %d\n", offset, ret);
-		page_cache_release(page);
+	OBD_ALLOC(ra->ra_pages, sizeof(ra->ra_pages[0]) * op_data->op_max_pages);
+	if (ra->ra_pages == NULL) {
+		OBD_FREE_PTR(ra);
+		return;
 	}
 
-	if (page_pool != &page0)
-		OBD_FREE(page_pool, sizeof(page_pool[0]) * max_pages);
+	ra->ra_inode = igrab(dir);
+	if (ra->ra_inode == NULL) {
+		OBD_FREE(ra->ra_pages,
+			 sizeof(ra->ra_pages[0]) * op_data->op_max_pages);
+		OBD_FREE_PTR(ra);
+		return;
+	}
+	ra->ra_exp = class_export_get(exp);
+	ra->ra_fid = op_data->op_fid1;
+	ra->ra_capa = capa_get(op_data->op_capa1);
+	ra->ra_lockh.cookie = it->d.lustre.it_lock_handle;
+	ra->ra_lock_mode = it->d.lustre.it_lock_mode;
+	ldlm_lock_addref(&ra->ra_lockh, ra->ra_lock_mode);
+	ra->ra_max_pages = op_data->op_max_pages;
+	ra->ra_hash64 = hash64;
+	ra->ra_left = op_data->op_ra_rpcs - 1;
 
-	RETURN(rc);
+	if (mdc_readahead_lock_busy(ra) || mdc_readahead_send(ra, hash) != 0)
+		mdc_readahead_fini(ra);
 }
 
 /**
@@ -1432,7 +1696,8 @@ static int mdc_read_page_remote(void *data, struct page *page0)
  * \param[in] cb_op	callback required for ldlm lock enqueue during
  *                      read page
  * \param[in] hash_offset the hash offset of the page to be read
- * \param[in] ppage	the page to be read
+ * \param[in] ppage	the page to be read, NULL if op_data->op_cli_flags
+ *                      has CLI_READDIR_ASYNC: the page is only read ahead
  *
  * retval		= 0 get the page successfully
  *                      errno(<0) get the page failed
@@ -1476,8 +1741,21 @@ static int mdc_read_page(struct obd_export *exp, struct md_op_data *op_data,
 
 	rp_param.rp_off = hash_offset;
 	rp_param.rp_hash64 = op_data->op_cli_flags & CLI_HASH64;
+	rp_param.rp_remote = 0;
 	page = mdc_page_locate(mapping, &rp_param.rp_off, &start, &end,
 			       rp_param.rp_hash64);
+	if (op_data->op_cli_flags & CLI_READDIR_ASYNC) {
+		/* only send the READPAGE RPC, the caller reads the page
+		 * later, e.g. LMV reading all the stripes at once */
+		if (page == NULL) {
+			mdc_readahead_start(exp, op_data, &it, hash_offset,
+					    rp_param.rp_hash64);
+		} else if (!IS_ERR(page)) {
+			kunmap(page);
+			mdc_release_page(page, 0);
+		}
+		GOTO(out_unlock, rc = 0);
+	}
 	if (IS_ERR(page)) {
 		CERROR("%s: dir page locate: "DFID" at "LPU64": rc %ld\n",
 		       exp->exp_obd->obd_name, PFID(&op_data->op_fid1),
@@ -1558,6 +1836,21 @@ hash_collision:
 		 */
 		goto fail;
 	}
+
+	if (!rp_param.rp_remote)
+		op_data->op_cli_flags |= CLI_READDIR_HIT;
+	if (op_data->op_ra_rpcs > 0) {
+		/* read ahead after a synchronous read, or when the reader
+		 * reaches the last RPC of a read-ahead chain */
+		if (PageReadahead(page)) {
+			ClearPageReadahead(page);
+			rp_param.rp_remote = 1;
+		}
+		if (rp_param.rp_remote)
+			mdc_readahead_start(exp, op_data, &it,
+					    le64_to_cpu(dp->ldp_hash_end),
+					    rp_param.rp_hash64);
+	}
 	*ppage = page;
 out_unlock:
 	lockh.cookie = it.d.lustre.it_lock_handle;
@@ -1952,7 +2245,7 @@ static struct kuc_hdr *changelog_kuc_hdr(char *buf, size_t len, __u32 flags)
 {
 	struct kuc_hdr *lh = (struct kuc_hdr *)buf;
 
-	LASSERT(len <= KUC_CHANGELOG_MSG_MAXSIZE);
+	LASSERT(len <= KUC_CHANGELOG_BATCH_MAXSIZE);
 
 	lh->kuc_magic = KUC_MAGIC;
 	lh->kuc_transport = KUC_TRANSPORT_CHANGELOG;
@@ -1968,6 +2261,16 @@ struct changelog_show {
 	struct file			*cs_fp;
 	char				*cs_buf;
 	struct obd_device		*cs_obd;
+	/* size of cs_buf, and bytes queued in it with CHANGELOG_FLAG_BATCH */
+	size_t				 cs_buflen;
+	size_t				 cs_len;
+	/* format records are remapped to with CHANGELOG_FLAG_BATCH */
+	enum changelog_rec_flags	 cs_rec_fmt;
+	/* filters, with CHANGELOG_FLAG_FILTER */
+	__u64				 cs_endrec;
+	__u32				 cs_typemask;
+	struct lu_fid			 cs_fid_start;
+	struct lu_fid			 cs_fid_end;
 };
 
 static inline char *cs_obd_name(struct changelog_show *cs)
@@ -1975,6 +2278,82 @@ static inline char *cs_obd_name(struct changelog_show *cs)
 	return cs->cs_obd->obd_name;
 }
 
+/**
+ * Whether \a rec passes the type and target FID filters of \a cs.
+ */
+static bool changelog_show_match(struct changelog_show *cs,
+				 struct changelog_rec *rec)
+{
+	if (!(cs->cs_flags & CHANGELOG_FLAG_FILTER))
+		return true;
+
+	if (cs->cs_typemask != 0 && (rec->cr_type >= 32 ||
+	    !(cs->cs_typemask & (1U << rec->cr_type))))
+		return false;
+
+	/* markers have no target FID */
+	if (rec->cr_type == CL_MARK)
+		return true;
+
+	if (!fid_is_zero(&cs->cs_fid_start) &&
+	    lu_fid_cmp(&rec->cr_tfid, &cs->cs_fid_start) < 0)
+		return false;
+
+	if (!fid_is_zero(&cs->cs_fid_end) &&
+	    lu_fid_cmp(&rec->cr_tfid, &cs->cs_fid_end) > 0)
+		return false;
+
+	return true;
+}
+
+/**
+ * Send the records queued in cs->cs_buf as one CL_RECORDS message.
+ */
+static int changelog_kkuc_flush(struct changelog_show *cs)
+{
+	struct kuc_hdr	*lh;
+	int		 rc;
+
+	if (cs->cs_len <= sizeof(*lh))
+		return 0;
+
+	lh = changelog_kuc_hdr(cs->cs_buf, cs->cs_len, cs->cs_flags);
+	lh->kuc_msgtype = CL_RECORDS;
+
+	rc = libcfs_kkuc_msg_put(cs->cs_fp, lh);
+	CDEBUG(D_HSM, "kucmsg fp %p len %zu rc %d\n", cs->cs_fp, cs->cs_len,
+	       rc);
+	cs->cs_len = sizeof(*lh);
+
+	return rc < 0 ? rc : 0;
+}
+
+/**
+ * Queue \a rec in cs->cs_buf remapped to cs->cs_rec_fmt, so that the reader
+ * can use the records in place, flushing the batch first if it is full.
+ */
+static int changelog_kkuc_batch(struct changelog_show *cs,
+				struct changelog_rec *rec)
+{
+	size_t	srclen = changelog_rec_size(rec) + rec->cr_namelen;
+	size_t	dstlen = changelog_rec_offset(cs->cs_rec_fmt) +
+			 rec->cr_namelen;
+	int	rc;
+
+	if (cs->cs_len + max(srclen, dstlen) > cs->cs_buflen) {
+		rc = changelog_kkuc_flush(cs);
+		if (rc < 0)
+			return rc;
+	}
+
+	memcpy(cs->cs_buf + cs->cs_len, rec, srclen);
+	changelog_remap_rec((struct changelog_rec *)(cs->cs_buf + cs->cs_len),
+			    cs->cs_rec_fmt);
+	cs->cs_len += cfs_size_round(dstlen);
+
+	return 0;
+}
+
 static int changelog_kkuc_cb(const struct lu_env *env, struct llog_handle *llh,
 			     struct llog_rec_hdr *hdr, void *data)
 {
@@ -2000,6 +2379,15 @@ static int changelog_kkuc_cb(const struct lu_env *env, struct llog_handle *llh,
 		RETURN(0);
 	}
 
+	if (cs->cs_flags & CHANGELOG_FLAG_FILTER) {
+		/* records are in index order, nothing more to send */
+		if (cs->cs_endrec != 0 && rec->cr.cr_index > cs->cs_endrec)
+			RETURN(LLOG_PROC_BREAK);
+
+		if (!changelog_show_match(cs, &rec->cr))
+			RETURN(0);
+	}
+
 	CDEBUG(D_HSM, LPU64" %02d%-5s "LPU64" 0x%x t="DFID" p="DFID" %.*s\n",
 	       rec->cr.cr_index, rec->cr.cr_type,
 	       changelog_type2str(rec->cr.cr_type), rec->cr.cr_time,
@@ -2007,6 +2395,9 @@ static int changelog_kkuc_cb(const struct lu_env *env, struct llog_handle *llh,
 	       PFID(&rec->cr.cr_tfid), PFID(&rec->cr.cr_pfid),
 	       rec->cr.cr_namelen, changelog_rec_name(&rec->cr));
 
+	if (cs->cs_flags & CHANGELOG_FLAG_BATCH)
+		RETURN(changelog_kkuc_batch(cs, &rec->cr));
+
 	len = sizeof(*lh) + changelog_rec_size(&rec->cr) + rec->cr.cr_namelen;
 
         /* Set up the message */
@@ -2031,7 +2422,17 @@ static int mdc_changelog_send_thread(void *csdata)
 	CDEBUG(D_HSM, "changelog to fp=%p start "LPU64"\n",
 	       cs->cs_fp, cs->cs_startrec);
 
-	OBD_ALLOC(cs->cs_buf, KUC_CHANGELOG_MSG_MAXSIZE);
+	if (cs->cs_flags & CHANGELOG_FLAG_BATCH) {
+		cs->cs_buflen = KUC_CHANGELOG_BATCH_MAXSIZE;
+		cs->cs_len = sizeof(struct kuc_hdr);
+		cs->cs_rec_fmt = CLF_VERSION | CLF_RENAME;
+		if (cs->cs_flags & CHANGELOG_FLAG_JOBID)
+			cs->cs_rec_fmt |= CLF_JOBID;
+	} else {
+		cs->cs_buflen = KUC_CHANGELOG_MSG_MAXSIZE;
+	}
+
+	OBD_ALLOC_LARGE(cs->cs_buf, cs->cs_buflen);
 	if (cs->cs_buf == NULL)
 		GOTO(out, rc = -ENOMEM);
 
@@ -2057,6 +2458,8 @@ static int mdc_changelog_send_thread(void *csdata)
 	}
 
 	rc = llog_cat_process(NULL, llh, changelog_kkuc_cb, cs, 0, 0);
+	if (rc >= 0 && (cs->cs_flags & CHANGELOG_FLAG_BATCH))
+		rc = changelog_kkuc_flush(cs);
 
         /* Send EOF no matter what our result */
         if ((kuch = changelog_kuc_hdr(cs->cs_buf, sizeof(*kuch),
@@ -2072,7 +2475,7 @@ out:
         if (ctxt)
                 llog_ctxt_put(ctxt);
 	if (cs->cs_buf)
-		OBD_FREE(cs->cs_buf, KUC_CHANGELOG_MSG_MAXSIZE);
+		OBD_FREE_LARGE(cs->cs_buf, cs->cs_buflen);
 	OBD_FREE_PTR(cs);
 	return rc;
 }
@@ -2094,6 +2497,12 @@ static int mdc_ioc_changelog_send(struct obd_device *obd,
 	/* matching fput in mdc_changelog_send_thread */
 	cs->cs_fp = fget(icc->icc_id);
 	cs->cs_flags = icc->icc_flags;
+	if (cs->cs_flags & CHANGELOG_FLAG_FILTER) {
+		cs->cs_endrec = icc->icc_endrec;
+		cs->cs_typemask = icc->icc_typemask;
+		cs->cs_fid_start = icc->icc_fid_start;
+		cs->cs_fid_end = icc->icc_fid_end;
+	}
 
 	/*
 	 * New thread because we should return to user app before
@@ -3138,12 +3547,24 @@ static struct md_ops mdc_md_ops = {
 
 static int __init mdc_init(void)
 {
-	return class_register_type(&mdc_obd_ops, &mdc_md_ops, true, NULL,
-				   LUSTRE_MDC_NAME, NULL);
+	int rc;
+
+	mdc_ra_wq = create_singlethread_workqueue("mdc_ra");
+	if (mdc_ra_wq == NULL)
+		return -ENOMEM;
+
+	rc = class_register_type(&mdc_obd_ops, &mdc_md_ops, true, NULL,
+				 LUSTRE_MDC_NAME, NULL);
+	if (rc != 0)
+		destroy_workqueue(mdc_ra_wq);
+
+	return rc;
 }
 
 static void /*__exit*/ mdc_exit(void)
 {
+	/* waits for the pending releases */
+	destroy_workqueue(mdc_ra_wq);
         class_unregister_type(LUSTRE_MDC_NAME);
 }
 
@@ -107,6 +107,9 @@ struct kmem_cache *mdt_hsm_cdt_kmem;
 /* For HSM request handles */
 struct kmem_cache *mdt_hsm_car_kmem;
 
+/* For open file handles */
+struct kmem_cache *mdt_mfd_kmem;
+
 static struct lu_kmem_descr mdt_caches[] = {
 	{
 		.ckd_cache = &mdt_object_kmem,
@@ -123,6 +126,11 @@ static struct lu_kmem_descr mdt_caches[] = {
 		.ckd_name       = "mdt_cdt_agent_req",
 		.ckd_size       = sizeof(struct cdt_agent_req)
 	},
+	{
+		.ckd_cache      = &mdt_mfd_kmem,
+		.ckd_name       = "mdt_mfd",
+		.ckd_size       = sizeof(struct mdt_file_data)
+	},
 	{
 		.ckd_cache = NULL
 	}
@@ -6033,6 +6041,9 @@ static void __exit mdt_mod_exit(void)
 {
 	class_unregister_type(LUSTRE_MDT_NAME);
 	mds_mod_exit();
+	/* mfds are freed by RCU callbacks, wait for them before destroying
+	 * the slab */
+	rcu_barrier();
 	lu_kmem_fini(mdt_caches);
 }
 
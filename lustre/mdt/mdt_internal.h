@@ -527,6 +527,7 @@ struct cdt_restore_handle {
 	struct mdt_lock_handle	crh_lh;		/**< lock handle */
 };
 extern struct kmem_cache *mdt_hsm_cdt_kmem;	/** restore handle slab cache */
+extern struct kmem_cache *mdt_mfd_kmem;		/** open handle slab cache */
 
 static inline const struct md_device_operations *
 mdt_child_ops(struct mdt_device * m)
@@ -1062,8 +1063,14 @@ enum {
         LPROC_MDT_SAMEDIR_RENAME,
         LPROC_MDT_CROSSDIR_RENAME,
         LPROC_MDT_LAST,
+	/* latency counters, kept in md_stats only */
+	LPROC_MDT_OPEN_TIME = LPROC_MDT_LAST,
+	LPROC_MDT_CLOSE_TIME,
+	LPROC_MDT_MD_LAST,
 };
 void mdt_counter_incr(struct ptlrpc_request *req, int opcode);
+void mdt_counter_time(struct ptlrpc_request *req, int opcode,
+		      struct timeval *start);
 void mdt_stats_counter_init(struct lprocfs_stats *stats);
 int mdt_procfs_init(struct mdt_device *mdt, const char *name);
 void mdt_procfs_fini(struct mdt_device *mdt);
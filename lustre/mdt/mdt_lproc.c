@@ -943,6 +943,21 @@ void mdt_counter_incr(struct ptlrpc_request *req, int opcode)
 				      opcode, 1);
 }
 
+/* Account time elapsed since \a start to latency counter \a opcode */
+void mdt_counter_time(struct ptlrpc_request *req, int opcode,
+		      struct timeval *start)
+{
+	struct obd_export	*exp = req->rq_export;
+	struct timeval		 now;
+
+	if (exp->exp_obd == NULL || exp->exp_obd->obd_md_stats == NULL)
+		return;
+
+	do_gettimeofday(&now);
+	lprocfs_counter_add(exp->exp_obd->obd_md_stats, opcode,
+			    cfs_timeval_sub(&now, start, NULL));
+}
+
 void mdt_stats_counter_init(struct lprocfs_stats *stats)
 {
         lprocfs_counter_init(stats, LPROC_MDT_OPEN, 0, "open", "reqs");
@@ -993,10 +1008,14 @@ int mdt_procfs_init(struct mdt_device *mdt, const char *name)
 	if (obd->obd_proc_exports_entry)
 		lprocfs_add_simple(obd->obd_proc_exports_entry, "clear",
 				   obd, &mdt_nid_stats_clear_fops);
-	rc = lprocfs_alloc_md_stats(obd, LPROC_MDT_LAST);
+	rc = lprocfs_alloc_md_stats(obd, LPROC_MDT_MD_LAST);
 	if (rc)
 		return rc;
 	mdt_stats_counter_init(obd->obd_md_stats);
+	lprocfs_counter_init(obd->obd_md_stats, LPROC_MDT_OPEN_TIME,
+			     LPROCFS_CNTR_AVGMINMAX, "open_time", "usec");
+	lprocfs_counter_init(obd->obd_md_stats, LPROC_MDT_CLOSE_TIME,
+			     LPROCFS_CNTR_AVGMINMAX, "close_time", "usec");
 
 	rc = lprocfs_job_stats_init(obd, LPROC_MDT_LAST,
 				    mdt_stats_counter_init);
@@ -52,9 +52,15 @@ static void mdt_mfd_get(void *mfdp)
 {
 }
 
+static void mdt_mfd_slab_free(void *mfd, int size)
+{
+	LASSERT(size == sizeof(struct mdt_file_data));
+	OBD_SLAB_FREE(mfd, mdt_mfd_kmem, size);
+}
+
 static struct portals_handle_ops mfd_handle_ops = {
 	.hop_addref = mdt_mfd_get,
-	.hop_free   = NULL,
+	.hop_free   = mdt_mfd_slab_free,
 };
 
 /* Create a new mdt_file_data struct, initialize it,
@@ -64,7 +70,7 @@ struct mdt_file_data *mdt_mfd_new(const struct mdt_export_data *med)
 	struct mdt_file_data *mfd;
 	ENTRY;
 
-	OBD_ALLOC_PTR(mfd);
+	OBD_SLAB_ALLOC_PTR_GFP(mfd, mdt_mfd_kmem, GFP_NOFS);
 	if (mfd != NULL) {
 		INIT_LIST_HEAD(&mfd->mfd_handle.h_link);
 		mfd->mfd_handle.h_owner = med;
@@ -1570,7 +1576,8 @@ out:
         RETURN(rc);
 }
 
-int mdt_reint_open(struct mdt_thread_info *info, struct mdt_lock_handle *lhc)
+static int __mdt_reint_open(struct mdt_thread_info *info,
+			    struct mdt_lock_handle *lhc)
 {
         struct mdt_device       *mdt = info->mti_mdt;
         struct ptlrpc_request   *req = mdt_info_req(info);
@@ -1890,6 +1897,18 @@ out:
 	return result;
 }
 
+int mdt_reint_open(struct mdt_thread_info *info, struct mdt_lock_handle *lhc)
+{
+	struct timeval	start;
+	int		rc;
+
+	do_gettimeofday(&start);
+	rc = __mdt_reint_open(info, lhc);
+	mdt_counter_time(mdt_info_req(info), LPROC_MDT_OPEN_TIME, &start);
+
+	return rc;
+}
+
 /**
  * Create an orphan object use local root.
  */
@@ -2257,9 +2276,11 @@ int mdt_close(struct tgt_session_info *tsi)
         struct mdt_object      *o;
         struct md_attr         *ma = &info->mti_attr;
         struct mdt_body        *repbody = NULL;
+	struct timeval		start;
         int rc, ret = 0;
         ENTRY;
 
+	do_gettimeofday(&start);
 	mdt_counter_incr(req, LPROC_MDT_CLOSE);
 	/* Close may come with the Size-on-MDS update. Unpack it. */
 	rc = mdt_close_unpack(info);
@@ -2338,6 +2359,7 @@ int mdt_close(struct tgt_session_info *tsi)
 		tsi->tsi_reply_fail_id = OBD_FAIL_MDS_CLOSE_NET_REP;
 out:
 	mdt_thread_info_fini(info);
+	mdt_counter_time(req, LPROC_MDT_CLOSE_TIME, &start);
 	RETURN(rc ? rc : ret);
 }
 
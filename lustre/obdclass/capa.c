@@ -411,11 +411,13 @@ EXPORT_SYMBOL(_debug_capa);
  * lu_capainfo_key_init, lu_capainfo_key_fini
  */
 LU_KEY_INIT_FINI(lu_capainfo, struct lu_capainfo);
+LU_KEY_RESET(lu_capainfo, struct lu_capainfo);
 
 static struct lu_context_key lu_capainfo_key = {
 	.lct_tags = LCT_SERVER_SESSION,
 	.lct_init = lu_capainfo_key_init,
-	.lct_fini = lu_capainfo_key_fini
+	.lct_fini = lu_capainfo_key_fini,
+	.lct_reset = lu_capainfo_key_reset,
 };
 
 struct lu_capainfo *lu_capainfo_get(const struct lu_env *env)
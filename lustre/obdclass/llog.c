@@ -105,31 +105,58 @@ void llog_handle_put(struct llog_handle *loghandle)
 		llog_free_handle(loghandle);
 }
 
-/* returns negative on error; 0 if success; 1 if success & log destroyed */
-int llog_cancel_rec(const struct lu_env *env, struct llog_handle *loghandle,
-		    int index)
+/**
+ * Cancel several records of a plain llog at once.
+ *
+ * The bits of all the records are cleared and the llog header is written
+ * a single time, instead of once per record. The entries of \a index which
+ * were not set in the bitmap are zeroed.
+ *
+ * \param[in] env	execution environment
+ * \param[in] loghandle	plain llog handle
+ * \param[in] num	number of records to cancel
+ * \param[in,out] index	indices of the records to cancel
+ *
+ * \retval LLOG_DEL_PLAIN	if the llog became empty and was destroyed
+ * \retval 0			on success
+ * \retval negative		negated errno on error, no record is cancelled
+ */
+int llog_cancel_arr_rec(const struct lu_env *env,
+			struct llog_handle *loghandle, int num, int *index)
 {
-        struct llog_log_hdr *llh = loghandle->lgh_hdr;
-        int rc = 0;
-        ENTRY;
+	struct llog_log_hdr	*llh = loghandle->lgh_hdr;
+	int			 cleared = 0;
+	int			 rc = -ENOENT;
+	int			 i;
+	ENTRY;
+
+	spin_lock(&loghandle->lgh_hdr_lock);
+	for (i = 0; i < num; i++) {
+		CDEBUG(D_RPCTRACE, "Canceling %d in log "DOSTID"\n",
+		       index[i], POSTID(&loghandle->lgh_id.lgl_oi));
+
+		if (index[i] == 0) {
+			CERROR("Can't cancel index 0 which is header\n");
+			rc = -EINVAL;
+			continue;
+		}
 
-        CDEBUG(D_RPCTRACE, "Canceling %d in log "DOSTID"\n",
-               index, POSTID(&loghandle->lgh_id.lgl_oi));
+		if (!ext2_clear_bit(index[i], llh->llh_bitmap)) {
+			CDEBUG(D_RPCTRACE, "Catalog index %u already clear?\n",
+			       index[i]);
+			index[i] = 0;
+			continue;
+		}
 
-        if (index == 0) {
-                CERROR("Can't cancel index 0 which is header\n");
-                RETURN(-EINVAL);
-        }
+		llh->llh_count--;
+		cleared++;
+	}
 
-	spin_lock(&loghandle->lgh_hdr_lock);
-	if (!ext2_clear_bit(index, llh->llh_bitmap)) {
+	if (cleared == 0) {
 		spin_unlock(&loghandle->lgh_hdr_lock);
-		CDEBUG(D_RPCTRACE, "Catalog index %u already clear?\n", index);
-		RETURN(-ENOENT);
+		RETURN(rc);
 	}
 
-	llh->llh_count--;
-
 	if ((llh->llh_flags & LLOG_F_ZAP_WHEN_EMPTY) &&
 	    (llh->llh_count == 1) &&
 	    (loghandle->lgh_last_idx == (LLOG_BITMAP_BYTES * 8) - 1)) {
@@ -159,11 +186,23 @@ int llog_cancel_rec(const struct lu_env *env, struct llog_handle *loghandle,
 	RETURN(0);
 out_err:
 	spin_lock(&loghandle->lgh_hdr_lock);
-	ext2_set_bit(index, llh->llh_bitmap);
-	llh->llh_count++;
+	for (i = 0; i < num; i++) {
+		if (index[i] == 0)
+			continue;
+		ext2_set_bit(index[i], llh->llh_bitmap);
+		llh->llh_count++;
+	}
 	spin_unlock(&loghandle->lgh_hdr_lock);
 	return rc;
 }
+EXPORT_SYMBOL(llog_cancel_arr_rec);
+
+/* returns negative on error; 0 if success; 1 if success & log destroyed */
+int llog_cancel_rec(const struct lu_env *env, struct llog_handle *loghandle,
+		    int index)
+{
+	return llog_cancel_arr_rec(env, loghandle, 1, &index);
+}
 EXPORT_SYMBOL(llog_cancel_rec);
 
 static int llog_read_header(const struct lu_env *env,
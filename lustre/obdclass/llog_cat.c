@@ -511,6 +511,52 @@ int llog_cat_cancel_records(const struct lu_env *env,
 }
 EXPORT_SYMBOL(llog_cat_cancel_records);
 
+/**
+ * Cancel several records of the same plain llog of a catalog.
+ *
+ * Unlike llog_cat_cancel_records() the plain llog is looked up and its
+ * header written only once for all the records.
+ *
+ * \param[in] env		execution environment
+ * \param[in] cathandle	catalog handle
+ * \param[in] lgl		id of the plain llog holding the records
+ * \param[in] num		number of records
+ * \param[in,out] index	indices of the records in the plain llog,
+ *				see llog_cancel_arr_rec()
+ *
+ * \retval 0		on success
+ * \retval negative	negated errno on error
+ */
+int llog_cat_cancel_arr_rec(const struct lu_env *env,
+			    struct llog_handle *cathandle,
+			    struct llog_logid *lgl, int num, int *index)
+{
+	struct llog_handle	*loghandle;
+	int			 rc;
+	ENTRY;
+
+	rc = llog_cat_id2handle(env, cathandle, &loghandle, lgl);
+	if (rc) {
+		CERROR("%s: cannot find handle for llog "DOSTID": %d\n",
+		       cathandle->lgh_ctxt->loc_obd->obd_name,
+		       POSTID(&lgl->lgl_oi), rc);
+		RETURN(rc);
+	}
+
+	rc = llog_cancel_arr_rec(env, loghandle, num, index);
+	if (rc == LLOG_DEL_PLAIN) /* log has been destroyed */
+		rc = llog_cat_cleanup(env, cathandle, loghandle,
+				      loghandle->u.phd.phd_cookie.lgc_index);
+	llog_handle_put(loghandle);
+
+	if (rc < 0 && rc != -ENOENT)
+		CERROR("%s: fail to cancel %d llog-records: rc = %d\n",
+		       cathandle->lgh_ctxt->loc_obd->obd_name, num, rc);
+
+	RETURN(rc);
+}
+EXPORT_SYMBOL(llog_cat_cancel_arr_rec);
+
 static int llog_cat_process_cb(const struct lu_env *env,
 			       struct llog_handle *cat_llh,
 			       struct llog_rec_hdr *rec, void *data)
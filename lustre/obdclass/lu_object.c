@@ -152,8 +152,13 @@ void lu_object_put(const struct lu_env *env, struct lu_object *o)
         }
 
         if (!lu_object_is_dying(top)) {
-		LASSERT(list_empty(&top->loh_lru));
-		list_add_tail(&top->loh_lru, &bkt->lsb_lru);
+		/* LRU is lazy, the object could still be on the list if
+		 * lu_site_purge() didn't see it busy, then it's just marked
+		 * as referenced instead of being moved to the tail. */
+		if (list_empty(&top->loh_lru))
+			list_add_tail(&top->loh_lru, &bkt->lsb_lru);
+		else
+			set_bit(LU_OBJECT_LRU_REF, &top->loh_flags);
                 cfs_hash_bd_unlock(site->ls_obj_hash, &bd, 1);
                 return;
         }
@@ -169,6 +174,7 @@ void lu_object_put(const struct lu_env *env, struct lu_object *o)
          * and LRU lock, no race with concurrent object lookup is possible
          * and we can safely destroy object below.
          */
+	list_del_init(&top->loh_lru);
 	if (!test_and_set_bit(LU_OBJECT_UNHASHED, &top->loh_flags))
 		cfs_hash_bd_del_locked(site->ls_obj_hash, &bd, &top->loh_hash);
         cfs_hash_bd_unlock(site->ls_obj_hash, &bd, 1);
@@ -343,6 +349,7 @@ int lu_site_purge(const struct lu_env *env, struct lu_site *s, int nr)
         cfs_hash_bd_t            bd;
         cfs_hash_bd_t            bd2;
 	struct list_head	 dispose;
+	struct list_head	 rotate;
 	int                      did_sth;
 	unsigned int		 start;
         int                      count;
@@ -353,6 +360,7 @@ int lu_site_purge(const struct lu_env *env, struct lu_site *s, int nr)
 		RETURN(0);
 
 	INIT_LIST_HEAD(&dispose);
+	INIT_LIST_HEAD(&rotate);
         /*
          * Under LRU list lock, scan LRU list and move unreferenced objects to
          * the dispose list, removing them from LRU and hash table.
@@ -370,11 +378,29 @@ int lu_site_purge(const struct lu_env *env, struct lu_site *s, int nr)
                 if (i < start)
                         continue;
                 count = bnr;
-                cfs_hash_bd_lock(s->ls_obj_hash, &bd, 1);
                 bkt = cfs_hash_bd_extra_get(s->ls_obj_hash, &bd);
+		/* racy check, don't bother lu_object_put() for nothing */
+		if (list_empty(&bkt->lsb_lru))
+			continue;
 
+                cfs_hash_bd_lock(s->ls_obj_hash, &bd, 1);
 		list_for_each_entry_safe(h, temp, &bkt->lsb_lru, loh_lru) {
-			LASSERT(atomic_read(&h->loh_ref) == 0);
+			/* nobody can take the first reference while we hold
+			 * the bucket lock, busy object will be added back by
+			 * lu_object_put() */
+			if (atomic_read(&h->loh_ref) > 0) {
+				list_del_init(&h->loh_lru);
+				continue;
+			}
+
+			/* a full purge must free everything, the caller is
+			 * going to free the site or the device */
+			if (nr != ~0 &&
+			    test_and_clear_bit(LU_OBJECT_LRU_REF,
+					       &h->loh_flags)) {
+				list_move_tail(&h->loh_lru, &rotate);
+				continue;
+			}
 
                         cfs_hash_bd_get(s->ls_obj_hash, &h->loh_fid, &bd2);
                         LASSERT(bd.bd_bucket == bd2.bd_bucket);
@@ -392,6 +418,8 @@ int lu_site_purge(const struct lu_env *env, struct lu_site *s, int nr)
                                 break;
 
 		}
+		list_splice_tail(&rotate, &bkt->lsb_lru);
+		INIT_LIST_HEAD(&rotate);
 		cfs_hash_bd_unlock(s->ls_obj_hash, &bd, 1);
 		cond_resched();
 		/*
@@ -593,9 +621,9 @@ static struct lu_object *htable_lookup(struct lu_site *s,
 
         h = container_of0(hnode, struct lu_object_header, loh_hash);
         if (likely(!lu_object_is_dying(h))) {
+		/* LRU isn't touched, see lu_site_purge() */
 		cfs_hash_get(s->ls_obj_hash, hnode);
                 lprocfs_counter_incr(s->ls_stats, LU_SS_CACHE_HIT);
-		list_del_init(&h->loh_lru);
                 return lu_object_top(h);
         }
 
@@ -636,7 +664,6 @@ static struct lu_object *htable_lookup_nowait(struct lu_site *s,
 
 	cfs_hash_get(s->ls_obj_hash, hnode);
 	lprocfs_counter_incr(s->ls_stats, LU_SS_CACHE_HIT);
-	list_del_init(&h->loh_lru);
 	return lu_object_top(h);
 }
 
@@ -703,6 +730,52 @@ static struct lu_object *lu_object_new(const struct lu_env *env,
         return o;
 }
 
+/**
+ * Lock the bucket for object lookup, and count it if the lock is busy.
+ */
+static inline void lu_site_bd_lock(struct lu_site *s, cfs_hash_bd_t *bd)
+{
+	/* ls_obj_hash is created with CFS_HASH_SPIN_BKTLOCK */
+	if (likely(spin_trylock(&bd->bd_bucket->hsb_lock.spin)))
+		return;
+
+	lprocfs_counter_incr(s->ls_stats, LU_SS_LOOKUP_CONTENDED);
+	cfs_hash_bd_lock(s->ls_obj_hash, bd, 1);
+}
+
+#ifdef __KERNEL__
+static DEFINE_PER_CPU(unsigned int, lu_site_lookup_seq);
+
+/**
+ * Whether to time this lookup. Only one of LU_SITE_LOOKUP_SAMPLE lookups
+ * on a CPU is, to keep the clock off the hot path.
+ */
+static inline bool lu_site_lookup_sampled(void)
+{
+	unsigned int seq;
+
+	seq = ++get_cpu_var(lu_site_lookup_seq);
+	put_cpu_var(lu_site_lookup_seq);
+
+	return seq % LU_SITE_LOOKUP_SAMPLE == 0;
+}
+
+static inline __u64 lu_site_lookup_clock(void)
+{
+	return ktime_to_us(ktime_get());
+}
+#else
+static inline bool lu_site_lookup_sampled(void)
+{
+	return false;
+}
+
+static inline __u64 lu_site_lookup_clock(void)
+{
+	return 0;
+}
+#endif
+
 /**
  * Core logic of lu_object_find*() functions.
  */
@@ -744,7 +817,8 @@ static struct lu_object *lu_object_find_try(const struct lu_env *env,
 
         s  = dev->ld_site;
         hs = s->ls_obj_hash;
-        cfs_hash_bd_get_and_lock(hs, (void *)f, &bd, 1);
+	cfs_hash_bd_get(hs, (void *)f, &bd);
+	lu_site_bd_lock(s, &bd);
         o = htable_lookup(s, &bd, f, waiter, &version);
         cfs_hash_bd_unlock(hs, &bd, 1);
 	if (!IS_ERR(o) || PTR_ERR(o) != -ENOENT)
@@ -795,14 +869,20 @@ struct lu_object *lu_object_find_at(const struct lu_env *env,
 	struct lu_site_bkt_data *bkt;
 	struct lu_object        *obj;
 	wait_queue_t           wait;
+	__u64			 start = 0;
 
-	if (conf != NULL && conf->loc_flags & LOC_F_NOWAIT)
-		return lu_object_find_try(env, dev, f, conf, NULL);
+	if (unlikely(lu_site_lookup_sampled()))
+		start = lu_site_lookup_clock();
+
+	if (conf != NULL && conf->loc_flags & LOC_F_NOWAIT) {
+		obj = lu_object_find_try(env, dev, f, conf, NULL);
+		goto out;
+	}
 
 	while (1) {
 		obj = lu_object_find_try(env, dev, f, conf, &wait);
 		if (obj != ERR_PTR(-EAGAIN))
-			return obj;
+			break;
 		/*
 		 * lu_object_find_try() already added waiter into the
 		 * wait queue.
@@ -811,6 +891,11 @@ struct lu_object *lu_object_find_at(const struct lu_env *env,
 		bkt = lu_site_bkt_from_fid(dev->ld_site, (void *)f);
 		remove_wait_queue(&bkt->lsb_marche_funebre, &wait);
 	}
+out:
+	if (unlikely(start != 0))
+		lprocfs_counter_add(dev->ld_site->ls_stats, LU_SS_LOOKUP_TIME,
+				    lu_site_lookup_clock() - start);
+	return obj;
 }
 EXPORT_SYMBOL(lu_object_find_at);
 
@@ -1152,6 +1237,10 @@ int lu_site_init(struct lu_site *s, struct lu_device *top)
                              0, "cache_death_race", "cache_death_race");
         lprocfs_counter_init(s->ls_stats, LU_SS_LRU_PURGED,
                              0, "lru_purged", "lru_purged");
+	lprocfs_counter_init(s->ls_stats, LU_SS_LOOKUP_TIME,
+			     LPROCFS_CNTR_AVGMINMAX, "lookup_time", "usec");
+	lprocfs_counter_init(s->ls_stats, LU_SS_LOOKUP_CONTENDED,
+			     0, "lookup_contended", "lookup_contended");
 
 	INIT_LIST_HEAD(&s->ls_linkage);
         s->ls_top_dev = top;
@@ -1607,6 +1696,13 @@ EXPORT_SYMBOL(lu_context_key_get);
  */
 static struct list_head lu_context_remembered;
 
+/**
+ * List of lu_context_pool's, protected by lu_keys_guard.
+ */
+static struct list_head lu_context_pools;
+
+static void lu_context_pool_key_fini(struct lu_context_pool *pool, int index);
+
 /**
  * Destroy \a key in all remembered contexts. This is used to destroy key
  * values in "shared" contexts (like service threads), when a module owning
@@ -1615,6 +1711,7 @@ static struct list_head lu_context_remembered;
 void lu_context_key_quiesce(struct lu_context_key *key)
 {
         struct lu_context *ctx;
+        struct lu_context_pool *pool;
         extern unsigned cl_env_cache_purge(unsigned nr);
 
         if (!(key->lct_tags & LCT_QUIESCENT)) {
@@ -1630,6 +1727,8 @@ void lu_context_key_quiesce(struct lu_context_key *key)
 		list_for_each_entry(ctx, &lu_context_remembered,
 				    lc_remember)
 			key_fini(ctx, key->lct_index);
+		list_for_each_entry(pool, &lu_context_pools, lcp_linkage)
+			lu_context_pool_key_fini(pool, key->lct_index);
 		spin_unlock(&lu_keys_guard);
 		++key_set_version;
 	}
@@ -1803,6 +1902,207 @@ int lu_context_refill(struct lu_context *ctx)
 }
 EXPORT_SYMBOL(lu_context_refill);
 
+/**
+ * Move references of all values in \a values from context \a from to
+ * context \a to.
+ */
+static void lu_context_values_move(void **values, const struct lu_context *from,
+				   const struct lu_context *to)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(lu_keys); ++i) {
+		if (values[i] == NULL)
+			continue;
+		lu_ref_del(&lu_keys[i]->lct_reference, "ctx", from);
+		lu_ref_add_atomic(&lu_keys[i]->lct_reference, "ctx", to);
+	}
+}
+
+/**
+ * Destroy values of the key with index \a index in all arrays cached in \a
+ * pool. Called under lu_keys_guard.
+ */
+static void lu_context_pool_key_fini(struct lu_context_pool *pool, int index)
+{
+	unsigned int i;
+
+	spin_lock(&pool->lcp_lock);
+	for (i = 0; i < pool->lcp_count; i++) {
+		pool->lcp_ctx.lc_value = pool->lcp_cache[i];
+		key_fini(&pool->lcp_ctx, index);
+	}
+	pool->lcp_ctx.lc_value = NULL;
+	spin_unlock(&pool->lcp_lock);
+}
+
+/**
+ * Initialize a pool caching up to \a max value arrays of contexts with
+ * \a tags.
+ */
+int lu_context_pool_init(struct lu_context_pool *pool, __u32 tags,
+			 unsigned int max)
+{
+	LASSERT((tags & LCT_REMEMBER) == 0);
+	LASSERT(max > 0);
+
+	memset(pool, 0, sizeof(*pool));
+	OBD_ALLOC(pool->lcp_cache, max * sizeof(pool->lcp_cache[0]));
+	if (pool->lcp_cache == NULL)
+		return -ENOMEM;
+
+	spin_lock_init(&pool->lcp_lock);
+	pool->lcp_tags = tags;
+	pool->lcp_max = max;
+	pool->lcp_ctx.lc_tags = tags;
+	pool->lcp_ctx.lc_state = LCS_LEFT;
+	INIT_LIST_HEAD(&pool->lcp_ctx.lc_remember);
+
+	spin_lock(&lu_keys_guard);
+	list_add(&pool->lcp_linkage, &lu_context_pools);
+	spin_unlock(&lu_keys_guard);
+	return 0;
+}
+EXPORT_SYMBOL(lu_context_pool_init);
+
+/**
+ * Destroy all cached values and the pool itself. Safe to call for a zeroed
+ * pool, which was never initialized.
+ */
+void lu_context_pool_fini(struct lu_context_pool *pool)
+{
+	unsigned int i;
+
+	if (pool->lcp_cache == NULL)
+		return;
+
+	spin_lock(&lu_keys_guard);
+	list_del_init(&pool->lcp_linkage);
+	for (i = 0; i < pool->lcp_count; i++) {
+		pool->lcp_ctx.lc_value = pool->lcp_cache[i];
+		keys_fini(&pool->lcp_ctx);
+	}
+	spin_unlock(&lu_keys_guard);
+
+	pool->lcp_count = 0;
+	OBD_FREE(pool->lcp_cache, pool->lcp_max * sizeof(pool->lcp_cache[0]));
+	pool->lcp_cache = NULL;
+}
+EXPORT_SYMBOL(lu_context_pool_fini);
+
+/**
+ * Initialize \a ctx with tags of \a pool, re-using cached key values if
+ * possible. Values for the keys missing in the cached array are created.
+ */
+int lu_context_pool_get(struct lu_context_pool *pool, struct lu_context *ctx)
+{
+	void		**values = NULL;
+	unsigned int	  reused = 0;
+	unsigned int	  total = 0;
+	unsigned int	  i;
+	int		  rc;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->lc_state = LCS_INITIALIZED;
+	ctx->lc_tags = pool->lcp_tags;
+	INIT_LIST_HEAD(&ctx->lc_remember);
+
+	spin_lock(&pool->lcp_lock);
+	if (pool->lcp_count > 0) {
+		values = pool->lcp_cache[--pool->lcp_count];
+		lu_context_values_move(values, &pool->lcp_ctx, ctx);
+	}
+	spin_unlock(&pool->lcp_lock);
+
+	if (values != NULL) {
+		ctx->lc_value = values;
+		for (i = 0; i < ARRAY_SIZE(lu_keys); ++i) {
+			if (values[i] == NULL)
+				continue;
+			reused++;
+			if (lu_keys[i]->lct_exit != NULL)
+				ctx->lc_tags |= LCT_HAS_EXIT;
+		}
+		rc = keys_fill(ctx);
+	} else {
+		rc = keys_init(ctx);
+	}
+	if (rc != 0) {
+		lu_context_fini(ctx);
+		return rc;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(lu_keys); ++i)
+		if (ctx->lc_value[i] != NULL)
+			total++;
+
+	spin_lock(&pool->lcp_lock);
+	pool->lcp_reused += reused;
+	pool->lcp_allocated += total - reused;
+	spin_unlock(&pool->lcp_lock);
+	return 0;
+}
+EXPORT_SYMBOL(lu_context_pool_get);
+
+/**
+ * Finalize \a ctx, obtained from lu_context_pool_get(). Values of the keys
+ * having lu_context_key::lct_reset() are reset and cached in \a pool, the
+ * rest is destroyed.
+ */
+void lu_context_pool_put(struct lu_context_pool *pool, struct lu_context *ctx)
+{
+	void		**values = ctx->lc_value;
+	unsigned int	  freed = 0;
+	unsigned int	  kept = 0;
+	unsigned int	  i;
+
+	LINVRNT(ctx->lc_state == LCS_INITIALIZED || ctx->lc_state == LCS_LEFT);
+	LASSERT((ctx->lc_tags & ~LCT_HAS_EXIT) == pool->lcp_tags);
+
+	if (values == NULL)
+		goto out;
+
+	for (i = 0; i < ARRAY_SIZE(lu_keys); ++i) {
+		struct lu_context_key *key = lu_keys[i];
+
+		if (values[i] == NULL)
+			continue;
+
+		LASSERT(key != NULL);
+		if (key->lct_reset == NULL || key->lct_tags & LCT_QUIESCENT) {
+			key_fini(ctx, i);
+			freed++;
+		} else {
+			key->lct_reset(ctx, key, values[i]);
+			kept++;
+		}
+	}
+
+	spin_lock(&pool->lcp_lock);
+	pool->lcp_freed += freed;
+	if (kept == 0 || pool->lcp_count >= pool->lcp_max)
+		goto out_unlock;
+	/*
+	 * Recheck under the pool lock: lu_context_key_quiesce() marks the key
+	 * quiescent before walking the pools, so a value of such key must not
+	 * be cached once the walk could have been missed.
+	 */
+	for (i = 0; i < ARRAY_SIZE(lu_keys); ++i)
+		if (values[i] != NULL && lu_keys[i]->lct_tags & LCT_QUIESCENT)
+			goto out_unlock;
+
+	lu_context_values_move(values, ctx, &pool->lcp_ctx);
+	pool->lcp_cache[pool->lcp_count++] = values;
+	ctx->lc_value = NULL;
+out_unlock:
+	if (ctx->lc_value != NULL)
+		pool->lcp_freed += kept;
+	spin_unlock(&pool->lcp_lock);
+out:
+	lu_context_fini(ctx);
+}
+EXPORT_SYMBOL(lu_context_pool_put);
+
 /**
  * lu_ctx_tags/lu_ses_tags will be updated if there are new types of
  * obd being added. Currently, this is only used on client side, specifically
@@ -1927,15 +2227,19 @@ static void lu_site_stats_get(cfs_hash_t *hs,
                 struct lu_site_bkt_data *bkt = cfs_hash_bd_extra_get(hs, &bd);
 		struct hlist_head	*hhead;
 
+		if (!populated) {
+			/* the shrinker only needs an estimate, don't
+			 * contend bucket locks with lu_object_put() */
+			stats->lss_busy  += bkt->lsb_busy;
+			stats->lss_total += cfs_hash_bd_count_get(&bd);
+			continue;
+		}
+
                 cfs_hash_bd_lock(hs, &bd, 1);
                 stats->lss_busy  += bkt->lsb_busy;
                 stats->lss_total += cfs_hash_bd_count_get(&bd);
                 stats->lss_max_search = max((int)stats->lss_max_search,
                                             cfs_hash_bd_depmax_get(&bd));
-                if (!populated) {
-                        cfs_hash_bd_unlock(hs, &bd, 1);
-                        continue;
-                }
 
                 cfs_hash_bd_for_each_hlist(hs, &bd, hhead) {
 			if (!hlist_empty(hhead))
@@ -2113,6 +2417,7 @@ int lu_global_init(void)
 
 	INIT_LIST_HEAD(&lu_device_types);
 	INIT_LIST_HEAD(&lu_context_remembered);
+	INIT_LIST_HEAD(&lu_context_pools);
 	INIT_LIST_HEAD(&lu_sites);
 
         result = lu_ref_global_init();
@@ -2182,6 +2487,24 @@ static __u32 ls_stats_read(struct lprocfs_stats *stats, int idx)
 #endif
 }
 
+static __u32 ls_stats_avg(struct lprocfs_stats *stats, int idx)
+{
+#ifdef CONFIG_PROC_FS
+	struct lprocfs_counter ret;
+	__u64		       sum;
+
+	lprocfs_stats_collect(stats, idx, &ret);
+	if (ret.lc_count == 0)
+		return 0;
+
+	sum = ret.lc_sum;
+	do_div(sum, ret.lc_count);
+	return (__u32)sum;
+#else
+	return 0;
+#endif
+}
+
 /**
  * Output site statistical counters into a buffer. Suitable for
  * lprocfs_rd_*()-style functions.
@@ -2193,7 +2516,7 @@ int lu_site_stats_seq_print(const struct lu_site *s, struct seq_file *m)
 	memset(&stats, 0, sizeof(stats));
 	lu_site_stats_get(s->ls_obj_hash, &stats, 1);
 
-	return seq_printf(m, "%d/%d %d/%d %d %d %d %d %d %d %d\n",
+	return seq_printf(m, "%d/%d %d/%d %d %d %d %d %d %d %d %d %d\n",
 			  stats.lss_busy,
 			  stats.lss_total,
 			  stats.lss_populated,
@@ -2204,7 +2527,9 @@ int lu_site_stats_seq_print(const struct lu_site *s, struct seq_file *m)
 			  ls_stats_read(s->ls_stats, LU_SS_CACHE_MISS),
 			  ls_stats_read(s->ls_stats, LU_SS_CACHE_RACE),
 			  ls_stats_read(s->ls_stats, LU_SS_CACHE_DEATH_RACE),
-			  ls_stats_read(s->ls_stats, LU_SS_LRU_PURGED));
+			  ls_stats_read(s->ls_stats, LU_SS_LRU_PURGED),
+			  ls_stats_avg(s->ls_stats, LU_SS_LOOKUP_TIME),
+			  ls_stats_read(s->ls_stats, LU_SS_LOOKUP_CONTENDED));
 }
 EXPORT_SYMBOL(lu_site_stats_seq_print);
 
@@ -2215,7 +2540,7 @@ int lu_site_stats_print(const struct lu_site *s, char *page, int count)
         memset(&stats, 0, sizeof(stats));
         lu_site_stats_get(s->ls_obj_hash, &stats, 1);
 
-        return snprintf(page, count, "%d/%d %d/%d %d %d %d %d %d %d %d\n",
+        return snprintf(page, count, "%d/%d %d/%d %d %d %d %d %d %d %d %d %d\n",
                         stats.lss_busy,
                         stats.lss_total,
                         stats.lss_populated,
@@ -2226,7 +2551,9 @@ int lu_site_stats_print(const struct lu_site *s, char *page, int count)
                         ls_stats_read(s->ls_stats, LU_SS_CACHE_MISS),
                         ls_stats_read(s->ls_stats, LU_SS_CACHE_RACE),
                         ls_stats_read(s->ls_stats, LU_SS_CACHE_DEATH_RACE),
-                        ls_stats_read(s->ls_stats, LU_SS_LRU_PURGED));
+                        ls_stats_read(s->ls_stats, LU_SS_LRU_PURGED),
+			ls_stats_avg(s->ls_stats, LU_SS_LOOKUP_TIME),
+			ls_stats_read(s->ls_stats, LU_SS_LOOKUP_CONTENDED));
 }
 EXPORT_SYMBOL(lu_site_stats_print);
 
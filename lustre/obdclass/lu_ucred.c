@@ -51,11 +51,13 @@
 
 /* context key constructor/destructor: lu_ucred_key_init, lu_ucred_key_fini */
 LU_KEY_INIT_FINI(lu_ucred, struct lu_ucred);
+LU_KEY_RESET(lu_ucred, struct lu_ucred);
 
 static struct lu_context_key lu_ucred_key = {
 	.lct_tags = LCT_SERVER_SESSION,
 	.lct_init = lu_ucred_key_init,
-	.lct_fini = lu_ucred_key_fini
+	.lct_fini = lu_ucred_key_fini,
+	.lct_reset = lu_ucred_key_reset,
 };
 
 /**
@@ -30,6 +30,7 @@
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/sched.h>
+#include <linux/hash.h>
 
 #include <libcfs/libcfs.h>
 
@@ -41,6 +42,12 @@
 #define DYNLOCK_HANDLE_DEAD	0xd1956ee
 #define DYNLOCK_LIST_MAGIC	0x11ee91e6
 
+static inline struct dynlock_bucket *dynlock_bucket(struct dynlock *dl,
+						     unsigned long value)
+{
+	return &dl->dl_buckets[hash_long(value, DYNLOCK_HASH_BITS)];
+}
+
 /*
  * dynlock_init
  *
@@ -49,8 +56,15 @@
  */
 void dynlock_init(struct dynlock *dl)
 {
-	spin_lock_init(&dl->dl_list_lock);
-	INIT_LIST_HEAD(&dl->dl_list);
+	int i;
+
+	for (i = 0; i < DYNLOCK_HASH_SIZE; i++) {
+		spin_lock_init(&dl->dl_buckets[i].db_lock);
+		INIT_LIST_HEAD(&dl->dl_buckets[i].db_list);
+		dl->dl_buckets[i].db_shared = 0;
+		dl->dl_buckets[i].db_exclusive = 0;
+		dl->dl_buckets[i].db_waits = 0;
+	}
 	dl->dl_magic = DYNLOCK_LIST_MAGIC;
 }
 
@@ -63,22 +77,29 @@ void dynlock_init(struct dynlock *dl)
  * routine returns pointer to lock. this pointer is intended to
  * be passed to dynlock_unlock
  *
+ * new readers queue behind waiting writers, so that a steady stream of
+ * lookups cannot starve an insert into the same block. the holder of
+ * an exclusive lock may take it again in either mode.
+ *
  */
 struct dynlock_handle *dynlock_lock(struct dynlock *dl, unsigned long value,
 				    enum dynlock_type lt, gfp_t gfp)
 {
+	struct dynlock_bucket *db;
 	struct dynlock_handle *nhl = NULL;
 	struct dynlock_handle *hl;
+	int waited = 0;
 
 	BUG_ON(dl == NULL);
 	BUG_ON(dl->dl_magic != DYNLOCK_LIST_MAGIC);
 
+	db = dynlock_bucket(dl, value);
 repeat:
 	/* find requested lock in lockspace */
-	spin_lock(&dl->dl_list_lock);
-	BUG_ON(dl->dl_list.next == NULL);
-	BUG_ON(dl->dl_list.prev == NULL);
-	list_for_each_entry(hl, &dl->dl_list, dh_list) {
+	spin_lock(&db->db_lock);
+	BUG_ON(db->db_list.next == NULL);
+	BUG_ON(db->db_list.prev == NULL);
+	list_for_each_entry(hl, &db->db_list, dh_list) {
 		BUG_ON(hl->dh_list.next == NULL);
 		BUG_ON(hl->dh_list.prev == NULL);
 		BUG_ON(hl->dh_magic != DYNLOCK_HANDLE_MAGIC);
@@ -100,10 +121,10 @@ repeat:
 		/* we already have allocated lock. use it */
 		hl = nhl;
 		nhl = NULL;
-		list_add(&hl->dh_list, &dl->dl_list);
+		list_add(&hl->dh_list, &db->db_list);
 		goto found;
 	}
-	spin_unlock(&dl->dl_list_lock);
+	spin_unlock(&db->db_lock);
 
 	/* lock not found and we haven't allocated lock yet. allocate it */
 	OBD_SLAB_ALLOC_GFP(nhl, dynlock_cachep, sizeof(*nhl), gfp);
@@ -113,6 +134,7 @@ repeat:
 	nhl->dh_value = value;
 	nhl->dh_readers = 0;
 	nhl->dh_writers = 0;
+	nhl->dh_writers_waiting = 0;
 	nhl->dh_magic = DYNLOCK_HANDLE_MAGIC;
 	init_waitqueue_head(&nhl->dh_wait);
 
@@ -122,29 +144,42 @@ repeat:
 	goto repeat;
 
 found:
-	if (lt == DLT_WRITE) {
-		/* exclusive lock: user don't want to share lock at all
-		 * NOTE: one process may take the same lock several times
-		 * this functionaly is useful for rename operations */
-		while ((hl->dh_writers && hl->dh_pid != current->pid) ||
-				hl->dh_readers) {
-			spin_unlock(&dl->dl_list_lock);
+	if (hl->dh_writers && hl->dh_pid == current->pid) {
+		/* NOTE: one process may take the same lock several times
+		 * this functionaly is useful for rename operations. the
+		 * nested lock is exclusive whatever mode was asked for, so
+		 * that dynlock_unlock() releases it as such */
+		hl->dh_writers++;
+		db->db_exclusive++;
+	} else if (lt == DLT_WRITE) {
+		/* exclusive lock: user don't want to share lock at all */
+		hl->dh_writers_waiting++;
+		while (hl->dh_writers || hl->dh_readers) {
+			waited = 1;
+			spin_unlock(&db->db_lock);
 			wait_event(hl->dh_wait,
 				hl->dh_writers == 0 && hl->dh_readers == 0);
-			spin_lock(&dl->dl_list_lock);
+			spin_lock(&db->db_lock);
 		}
+		hl->dh_writers_waiting--;
 		hl->dh_writers++;
+		db->db_exclusive++;
 	} else {
-		/* shared lock: user do not want to share lock with writer */
-		while (hl->dh_writers) {
-			spin_unlock(&dl->dl_list_lock);
-			wait_event(hl->dh_wait, hl->dh_writers == 0);
-			spin_lock(&dl->dl_list_lock);
+		/* shared lock: user do not want to share lock with writer,
+		 * nor to overtake a writer which is already waiting */
+		while (hl->dh_writers || hl->dh_writers_waiting) {
+			waited = 1;
+			spin_unlock(&db->db_lock);
+			wait_event(hl->dh_wait, hl->dh_writers == 0 &&
+					       hl->dh_writers_waiting == 0);
+			spin_lock(&db->db_lock);
 		}
 		hl->dh_readers++;
+		db->db_shared++;
 	}
+	db->db_waits += waited;
 	hl->dh_pid = current->pid;
-	spin_unlock(&dl->dl_list_lock);
+	spin_unlock(&db->db_lock);
 
 	return hl;
 }
@@ -158,6 +193,7 @@ found:
  */
 void dynlock_unlock(struct dynlock *dl, struct dynlock_handle *hl)
 {
+	struct dynlock_bucket *db;
 	int wakeup = 0;
 
 	BUG_ON(dl == NULL);
@@ -170,7 +206,8 @@ void dynlock_unlock(struct dynlock *dl, struct dynlock_handle *hl)
 	BUG_ON(hl->dh_magic != DYNLOCK_HANDLE_MAGIC);
 	BUG_ON(hl->dh_writers != 0 && current->pid != hl->dh_pid);
 
-	spin_lock(&dl->dl_list_lock);
+	db = dynlock_bucket(dl, hl->dh_value);
+	spin_lock(&db->db_lock);
 	if (hl->dh_writers) {
 		BUG_ON(hl->dh_readers != 0);
 		hl->dh_writers--;
@@ -192,28 +229,74 @@ void dynlock_unlock(struct dynlock *dl, struct dynlock_handle *hl)
 		list_del(&hl->dh_list);
 		OBD_SLAB_FREE(hl, dynlock_cachep, sizeof(*hl));
 	}
-	spin_unlock(&dl->dl_list_lock);
+	spin_unlock(&db->db_lock);
 }
 
+/*
+ * dynlock_is_locked
+ *
+ * returns 1 if the lock for @value is held exclusively by the current
+ * process, or shared by anyone: readers are not tracked individually
+ *
+ */
 int dynlock_is_locked(struct dynlock *dl, unsigned long value)
 {
+	struct dynlock_bucket *db = dynlock_bucket(dl, value);
 	struct dynlock_handle *hl;
 	int result = 0;
 
 	/* find requested lock in lockspace */
-	spin_lock(&dl->dl_list_lock);
-	BUG_ON(dl->dl_list.next == NULL);
-	BUG_ON(dl->dl_list.prev == NULL);
-	list_for_each_entry(hl, &dl->dl_list, dh_list) {
+	spin_lock(&db->db_lock);
+	BUG_ON(db->db_list.next == NULL);
+	BUG_ON(db->db_list.prev == NULL);
+	list_for_each_entry(hl, &db->db_list, dh_list) {
 		BUG_ON(hl->dh_list.next == NULL);
 		BUG_ON(hl->dh_list.prev == NULL);
 		BUG_ON(hl->dh_magic != DYNLOCK_HANDLE_MAGIC);
-		if (hl->dh_value == value && hl->dh_pid == current->pid) {
+		if (hl->dh_value == value &&
+		    (hl->dh_readers != 0 || hl->dh_pid == current->pid)) {
 			/* lock is found */
 			result = 1;
 			break;
 		}
 	}
-	spin_unlock(&dl->dl_list_lock);
+	spin_unlock(&db->db_lock);
 	return result;
 }
+
+/*
+ * dynlock_stats_add
+ *
+ * adds the number of locks granted in the lockspace, shared and
+ * exclusive, and how many of them had to wait, to @ds
+ *
+ */
+void dynlock_stats_add(struct dynlock *dl, struct dynlock_stats *ds)
+{
+	struct dynlock_bucket *db;
+	int i;
+
+	for (i = 0; i < DYNLOCK_HASH_SIZE; i++) {
+		db = &dl->dl_buckets[i];
+		spin_lock(&db->db_lock);
+		ds->ds_shared += db->db_shared;
+		ds->ds_exclusive += db->db_exclusive;
+		ds->ds_waits += db->db_waits;
+		spin_unlock(&db->db_lock);
+	}
+}
+
+void dynlock_stats_reset(struct dynlock *dl)
+{
+	struct dynlock_bucket *db;
+	int i;
+
+	for (i = 0; i < DYNLOCK_HASH_SIZE; i++) {
+		db = &dl->dl_buckets[i];
+		spin_lock(&db->db_lock);
+		db->db_shared = 0;
+		db->db_exclusive = 0;
+		db->db_waits = 0;
+		spin_unlock(&db->db_lock);
+	}
+}
@@ -4,15 +4,30 @@
 #include <linux/list.h>
 #include <linux/wait.h>
 
+/*
+ * locks of a namespace are hashed by value into buckets, each with its
+ * own spinlock, so that operations on different values (e.g. different
+ * leaves of an IAM container) do not serialize on a single list lock
+ */
+#define DYNLOCK_HASH_BITS	5
+#define DYNLOCK_HASH_SIZE	(1 << DYNLOCK_HASH_BITS)
+
+struct dynlock_bucket {
+	spinlock_t		db_lock;
+	struct list_head	db_list;
+	/* locks granted, and how many of them had to wait, under db_lock */
+	unsigned long		db_shared;
+	unsigned long		db_exclusive;
+	unsigned long		db_waits;
+};
+
 /*
  * lock's namespace:
- *   - list of locks
- *   - lock to protect this list
+ *   - hash of lock lists
  */
 struct dynlock {
 	unsigned		dl_magic;
-	struct list_head	dl_list;
-	spinlock_t		dl_list_lock;
+	struct dynlock_bucket	dl_buckets[DYNLOCK_HASH_SIZE];
 };
 
 enum dynlock_type {
@@ -27,14 +42,23 @@ struct dynlock_handle {
 	int			dh_refcount;	/* number of users */
 	int			dh_readers;
 	int			dh_writers;
+	int			dh_writers_waiting;
 	int			dh_pid;		/* holder of the lock */
 	wait_queue_head_t	dh_wait;
 };
 
+struct dynlock_stats {
+	__u64			ds_shared;
+	__u64			ds_exclusive;
+	__u64			ds_waits;
+};
+
 void dynlock_init(struct dynlock *dl);
 struct dynlock_handle *dynlock_lock(struct dynlock *dl, unsigned long value,
 				    enum dynlock_type lt, gfp_t gfp);
 void dynlock_unlock(struct dynlock *dl, struct dynlock_handle *lock);
 int dynlock_is_locked(struct dynlock *dl, unsigned long value);
+void dynlock_stats_add(struct dynlock *dl, struct dynlock_stats *ds);
+void dynlock_stats_reset(struct dynlock *dl);
 
 #endif
@@ -85,6 +85,7 @@ CFS_MODULE_PARM(ldiskfs_track_declares_assert, "i", int, 0644,
 
 /* Slab to allocate dynlocks */
 struct kmem_cache *dynlock_cachep;
+struct kmem_cache *osd_oi_cache_kmem;
 
 static struct lu_kmem_descr ldiskfs_caches[] = {
 	{
@@ -92,6 +93,11 @@ static struct lu_kmem_descr ldiskfs_caches[] = {
 		.ckd_name  = "dynlock_cache",
 		.ckd_size  = sizeof(struct dynlock_handle)
 	},
+	{
+		.ckd_cache = &osd_oi_cache_kmem,
+		.ckd_name  = "osd_oi_cache_kmem",
+		.ckd_size  = sizeof(struct osd_oi_cache_entry)
+	},
 	{
 		.ckd_cache = NULL
 	}
@@ -638,6 +644,8 @@ iget:
 		if (result == -ENOENT || result == -ESTALE) {
 			if (!in_oi)
 				fid_zero(&oic->oic_fid);
+			else
+				osd_oi_cache_delete(dev, fid);
 
 			GOTO(out, result = -ENOENT);
 		} else if (result == -EREMCHG) {
@@ -645,6 +653,8 @@ iget:
 trigger:
 			if (!in_oi)
 				fid_zero(&oic->oic_fid);
+			else
+				osd_oi_cache_delete(dev, fid);
 
 			if (unlikely(triggered))
 				GOTO(out, result = saved);
@@ -787,6 +797,8 @@ static void osd_object_free(const struct lu_env *env, struct lu_object *l)
 
         LINVRNT(osd_invariant(obj));
 
+	osd_ra_fini(osd_obj2dev(obj), obj);
+	lu_buf_free(&obj->oo_lov_cache);
         dt_object_fini(&obj->oo_dt);
         if (obj->oo_hl_head != NULL)
                 ldiskfs_htree_lock_head_free(obj->oo_hl_head);
@@ -1115,6 +1127,149 @@ static int osd_seq_exists(const struct lu_env *env,
 	RETURN(ss->ss_node_id == range->lsr_index);
 }
 
+/*
+ * Journal commit coordinator.
+ *
+ * Every sync transaction and every dt_sync() used to force a journal commit
+ * of its own. Instead, sync requests are gathered in groups: the first one
+ * becomes the leader, the others join its group until the leader gets to
+ * force the commit, once the commit of the previous group is done, and
+ * after waiting a bounded window for more requests. All the waiters of the
+ * group are woken when the commit is done, that is after the commit
+ * callbacks of their transactions, osd_trans_commit_cb(), were called.
+ *
+ * The leader only waits the window when the previous commit served more
+ * than one request, and no longer than an average commit, so that a lone
+ * syncer does not pay for it.
+ */
+static void osd_sync_coord_init(struct osd_sync_coord *osc)
+{
+	spin_lock_init(&osc->osc_lock);
+	init_waitqueue_head(&osc->osc_waitq);
+	mutex_init(&osc->osc_mutex);
+	osc->osc_window_us = OSD_SYNC_WINDOW_DEFAULT;
+	do_gettimeofday(&osc->osc_stats_start);
+}
+
+static bool osd_sync_done(struct osd_sync_coord *osc, __u64 gen)
+{
+	bool done;
+
+	spin_lock(&osc->osc_lock);
+	done = osc->osc_done >= gen;
+	spin_unlock(&osc->osc_lock);
+
+	return done;
+}
+
+/**
+ * Wait for a journal commit.
+ *
+ * \param[in] osd	osd device
+ * \param[in] tid	transaction to be committed, or 0 to commit all
+ *			the transactions stopped so far
+ * \param[in] full	\a tid is not set
+ *
+ * \retval		0 once committed
+ * \retval		negative error code if the journal was aborted
+ */
+static int osd_sync_wait(struct osd_device *osd, tid_t tid, bool full)
+{
+	struct osd_sync_coord	*osc = &osd->od_sync;
+	journal_t		*journal = osd_journal(osd);
+	struct timeval		 start;
+	struct timeval		 end;
+	__u64			 gen;
+	long			 window = 0;
+	int			 waiters;
+	int			 rc;
+
+	/* racy, the commit is forced anyway if it looks not done yet */
+	if (!full && tid_geq(journal->j_commit_sequence, tid))
+		return 0;
+
+	spin_lock(&osc->osc_lock);
+	if (osc->osc_gathering) {
+		/* join the group gathered by the next leader */
+		if (full)
+			osc->osc_full = 1;
+		else if (tid_gt(tid, osc->osc_tid))
+			osc->osc_tid = tid;
+		osc->osc_waiters++;
+		gen = osc->osc_gen;
+		spin_unlock(&osc->osc_lock);
+
+		wait_event(osc->osc_waitq, osd_sync_done(osc, gen));
+
+		/* a later group may be done already, its commit covers this
+		 * group as jbd2 commits in order, and failures (journal
+		 * abort) are permanent */
+		spin_lock(&osc->osc_lock);
+		rc = osc->osc_rc;
+		spin_unlock(&osc->osc_lock);
+
+		return rc;
+	}
+
+	osc->osc_gathering = 1;
+	osc->osc_full = full;
+	osc->osc_tid = tid;
+	osc->osc_waiters = 1;
+	gen = ++osc->osc_gen;
+	spin_unlock(&osc->osc_lock);
+
+	if (mutex_trylock(&osc->osc_mutex)) {
+		/* no commit in progress to gather requests during */
+		if (osc->osc_last_waiters > 1)
+			window = min_t(__u64, osc->osc_window_us,
+				       osc->osc_avg_commit_us);
+	} else {
+		mutex_lock(&osc->osc_mutex);
+	}
+
+	if (window > 0) {
+		ktime_t expires = ktime_set(0, window * NSEC_PER_USEC);
+
+		set_current_state(TASK_UNINTERRUPTIBLE);
+		schedule_hrtimeout(&expires, HRTIMER_MODE_REL);
+	}
+
+	spin_lock(&osc->osc_lock);
+	osc->osc_gathering = 0;
+	full = osc->osc_full;
+	tid = osc->osc_tid;
+	waiters = osc->osc_waiters;
+	spin_unlock(&osc->osc_lock);
+
+	do_gettimeofday(&start);
+	if (full) {
+		rc = ldiskfs_force_commit(osd_sb(osd));
+	} else {
+		jbd2_log_start_commit(journal, tid);
+		rc = jbd2_log_wait_commit(journal, tid);
+	}
+	do_gettimeofday(&end);
+
+	spin_lock(&osc->osc_lock);
+	osc->osc_done = gen;
+	osc->osc_rc = rc;
+	osc->osc_last_waiters = waiters;
+	osc->osc_avg_commit_us = (osc->osc_avg_commit_us * 3 +
+				  cfs_timeval_sub(&end, &start, NULL)) / 4;
+	osc->osc_commits++;
+	osc->osc_total_waiters += waiters;
+	spin_unlock(&osc->osc_lock);
+	mutex_unlock(&osc->osc_mutex);
+
+	wake_up_all(&osc->osc_waitq);
+
+	CDEBUG(D_CACHE, "%s: sync group "LPU64" of %d requests committed%s: "
+	       "rc = %d\n", osd_name(osd), gen, waiters, full ? " all" : "",
+	       rc);
+
+	return rc;
+}
+
 /*
  * Concurrency: shouldn't matter.
  */
@@ -1127,6 +1282,8 @@ static int osd_trans_stop(const struct lu_env *env, struct dt_device *dt,
 	struct osd_iobuf       *iobuf = &oti->oti_iobuf;
 	struct qsd_instance    *qsd = oti->oti_dev->od_quota_slave;
 	struct lquota_trans    *qtrans;
+	bool			sync_wait = false;
+	tid_t			tid = 0;
 	ENTRY;
 
 	oh = container_of0(th, struct osd_thandle, ot_super);
@@ -1153,12 +1310,21 @@ static int osd_trans_stop(const struct lu_env *env, struct dt_device *dt,
 
 		/* hook functions might modify th_sync */
 		hdl->h_sync = th->th_sync;
+		/* rather than forcing its own commit, a sync transaction
+		 * waits for the commit of its group, see osd_sync_wait() */
+		if (hdl->h_sync && hdl->h_transaction != NULL) {
+			tid = hdl->h_transaction->t_tid;
+			hdl->h_sync = 0;
+			sync_wait = true;
+		}
 
                 oh->ot_handle = NULL;
                 OSD_CHECK_SLOW_TH(oh, oti->oti_dev,
                                   rc = ldiskfs_journal_stop(hdl));
                 if (rc != 0)
                         CERROR("Failure to stop transaction: %d\n", rc);
+		else if (sync_wait)
+			rc = osd_sync_wait(osd_dt_dev(dt), tid, false);
         } else {
 		thandle_put(&oh->ot_super);
         }
@@ -1196,6 +1362,50 @@ static int osd_trans_cb_add(struct thandle *th, struct dt_txn_commit_cb *dcb)
 	return 0;
 }
 
+struct osd_iput_work {
+	struct work_struct	 oiw_work;
+	struct inode		*oiw_inode;
+};
+
+static void osd_iput_work_fn(struct work_struct *work)
+{
+	struct osd_iput_work *oiw;
+
+	oiw = container_of(work, struct osd_iput_work, oiw_work);
+	iput(oiw->oiw_inode);
+	OBD_FREE_PTR(oiw);
+}
+
+/*
+ * The last iput() of an unlinked file truncates it, which for a large OST
+ * object means many journal handles and bitmap updates. Hand it over to
+ * od_iput_wq so that the thread serving the destroy does not wait for the
+ * blocks to be freed. Quota granted for those blocks is released by the
+ * next adjustment of the ID, as the usage only drops once the work ran.
+ *
+ * \retval true		the reference is dropped by the work queue
+ * \retval false	the caller must drop the reference
+ */
+static bool osd_iput_defer(struct osd_device *osd, struct inode *inode)
+{
+	struct osd_iput_work *oiw;
+
+	if (osd->od_iput_wq == NULL || !S_ISREG(inode->i_mode) ||
+	    inode->i_nlink != 0 || inode->i_blocks < OSD_IPUT_DEFER_BLOCKS ||
+	    atomic_read(&inode->i_count) > 1)
+		return false;
+
+	OBD_ALLOC_PTR(oiw);
+	if (oiw == NULL)
+		return false;
+
+	INIT_WORK(&oiw->oiw_work, osd_iput_work_fn);
+	oiw->oiw_inode = inode;
+	queue_work(osd->od_iput_wq, &oiw->oiw_work);
+
+	return true;
+}
+
 /*
  * Called just before object is freed. Releases all resources except for
  * object itself (that is released by osd_object_free()).
@@ -1220,7 +1430,8 @@ static void osd_object_delete(const struct lu_env *env, struct lu_object *l)
 		qid_t			 uid = i_uid_read(inode);
 		qid_t			 gid = i_gid_read(inode);
 
-                iput(inode);
+		if (!osd_iput_defer(osd_obj2dev(obj), inode))
+			iput(inode);
                 obj->oo_inode = NULL;
 
 		if (qsd != NULL) {
@@ -1384,7 +1595,7 @@ static int osd_sync(const struct lu_env *env, struct dt_device *d)
 
 	CDEBUG(D_CACHE, "syncing OSD %s\n", LUSTRE_OSD_LDISKFS_NAME);
 
-	rc = ldiskfs_force_commit(osd_sb(osd_dt_dev(d)));
+	rc = osd_sync_wait(osd_dt_dev(d), 0, true);
 
 	CDEBUG(D_CACHE, "synced OSD %s: rc = %d\n",
 	       LUSTRE_OSD_LDISKFS_NAME, rc);
@@ -1407,9 +1618,23 @@ static int osd_sync(const struct lu_env *env, struct dt_device *d)
 static int osd_commit_async(const struct lu_env *env,
                             struct dt_device *d)
 {
-        struct super_block *s = osd_sb(osd_dt_dev(d));
+	struct osd_device	*osd = osd_dt_dev(d);
+	struct osd_sync_coord	*osc = &osd->od_sync;
+        struct super_block *s = osd_sb(osd);
+	bool			 joined;
         ENTRY;
 
+	/* a sync group about to force a commit covers this request */
+	spin_lock(&osc->osc_lock);
+	joined = osc->osc_gathering;
+	if (joined) {
+		osc->osc_full = 1;
+		osc->osc_async_joined++;
+	}
+	spin_unlock(&osc->osc_lock);
+	if (joined)
+		RETURN(0);
+
 	CDEBUG(D_HA, "async commit OSD %s\n", LUSTRE_OSD_LDISKFS_NAME);
         RETURN(s->s_op->sync_fs(s, 0));
 }
@@ -2029,6 +2254,7 @@ static int osd_attr_set(const struct lu_env *env,
 		rc = iam_update(oh->ot_handle, bag, (const struct iam_key *)fid1,
 				(const struct iam_rec *)id, ipd);
 		osd_ipd_put(env, bag, ipd);
+		osd_oi_cache_delete(osd_dev(dt->do_lu.lo_dev), fid0);
 		return(rc > 0 ? 0 : rc);
 	}
 
@@ -2956,6 +3182,93 @@ static int osd_object_version_get(const struct lu_env *env,
         return 0;
 }
 
+/**
+ * Get the LOV EA of a regular file from the object cache.
+ *
+ * The layout is fetched on every open, and it is changed through this OSD
+ * only, whoever the caller is (MDD, LFSCK, OUT), so it can be served from
+ * memory as long as every change goes through osd_lov_cache_invalidate().
+ *
+ * \param[in] obj	OSD object
+ * \param[in] buf	buffer for the EA, or empty buffer for size query
+ * \param[out] gen	generation of the cache, if nothing is cached
+ *
+ * \retval		0 if nothing is cached
+ * \retval		-ERANGE if \a buf is too small
+ * \retval		EA size otherwise
+ */
+static int osd_lov_cache_get(struct osd_object *obj, struct lu_buf *buf,
+			     __u32 *gen)
+{
+	int rc = 0;
+
+	spin_lock(&obj->oo_guard);
+	if (obj->oo_lov_cache.lb_buf != NULL) {
+		rc = obj->oo_lov_cache.lb_len;
+		if (buf->lb_buf == NULL || buf->lb_len == 0)
+			; /* size query */
+		else if (buf->lb_len < rc)
+			rc = -ERANGE;
+		else
+			memcpy(buf->lb_buf, obj->oo_lov_cache.lb_buf, rc);
+	}
+	*gen = obj->oo_lov_gen;
+	spin_unlock(&obj->oo_guard);
+
+	return rc;
+}
+
+/**
+ * Remember the LOV EA just read from disk.
+ *
+ * The EA is cached only if it wasn't changed since \a gen was sampled
+ * by osd_lov_cache_get() before the read, otherwise the copy could be
+ * older than the one on disk.
+ *
+ * \param[in] obj	OSD object
+ * \param[in] buf	buffer holding the EA
+ * \param[in] size	EA size
+ * \param[in] gen	generation sampled before the EA was read
+ */
+static void osd_lov_cache_set(struct osd_object *obj, const struct lu_buf *buf,
+			      int size, __u32 gen)
+{
+	struct lu_buf cache = { NULL, 0 };
+
+	lu_buf_alloc(&cache, size);
+	if (cache.lb_buf == NULL)
+		return;
+	memcpy(cache.lb_buf, buf->lb_buf, size);
+
+	spin_lock(&obj->oo_guard);
+	if (obj->oo_lov_gen == gen && obj->oo_lov_cache.lb_buf == NULL) {
+		obj->oo_lov_cache = cache;
+		cache.lb_buf = NULL;
+	}
+	spin_unlock(&obj->oo_guard);
+
+	lu_buf_free(&cache);
+}
+
+/**
+ * Drop the cached LOV EA, called once the EA is changed on disk.
+ *
+ * \param[in] obj	OSD object
+ */
+static void osd_lov_cache_invalidate(struct osd_object *obj)
+{
+	struct lu_buf buf;
+
+	spin_lock(&obj->oo_guard);
+	buf = obj->oo_lov_cache;
+	obj->oo_lov_cache.lb_buf = NULL;
+	obj->oo_lov_cache.lb_len = 0;
+	obj->oo_lov_gen++;
+	spin_unlock(&obj->oo_guard);
+
+	lu_buf_free(&buf);
+}
+
 /*
  * Concurrency: @dt is read locked.
  */
@@ -2993,6 +3306,22 @@ static int osd_xattr_get(const struct lu_env *env, struct dt_object *dt,
 	if (osd_object_auth(env, dt, capa, CAPA_OPC_META_READ))
 		return -EACCES;
 
+	if (S_ISREG(inode->i_mode) && strcmp(name, XATTR_NAME_LOV) == 0) {
+		__u32 gen;
+		int   rc;
+
+		rc = osd_lov_cache_get(obj, buf, &gen);
+		if (rc != 0)
+			return rc;
+
+		rc = __osd_xattr_get(inode, dentry, name, buf->lb_buf,
+				     buf->lb_len);
+		if (rc > 0 && rc <= OSD_LOV_CACHE_MAX && buf->lb_buf != NULL &&
+		    buf->lb_len != 0)
+			osd_lov_cache_set(obj, buf, rc, gen);
+		return rc;
+	}
+
 	return __osd_xattr_get(inode, dentry, name, buf->lb_buf, buf->lb_len);
 }
 
@@ -3112,6 +3441,15 @@ static int osd_xattr_set(const struct lu_env *env, struct dt_object *dt,
 	    strcmp(name, XATTR_NAME_LINK) == 0)
 		return -ENOSPC;
 
+	if (strcmp(name, XATTR_NAME_LOV) == 0) {
+		int rc;
+
+		rc = __osd_xattr_set(info, inode, name, buf->lb_buf,
+				     buf->lb_len, fs_flags);
+		osd_lov_cache_invalidate(obj);
+		RETURN(rc);
+	}
+
 	return __osd_xattr_set(info, inode, name, buf->lb_buf, buf->lb_len,
 			       fs_flags);
 }
@@ -3196,6 +3534,8 @@ static int osd_xattr_del(const struct lu_env *env, struct dt_object *dt,
 	dentry->d_inode = inode;
 	dentry->d_sb = inode->i_sb;
 	rc = inode->i_op->removexattr(dentry, name);
+	if (strcmp(name, XATTR_NAME_LOV) == 0)
+		osd_lov_cache_invalidate(obj);
 	return rc;
 }
 
@@ -3307,7 +3647,12 @@ static int osd_object_sync(const struct lu_env *env, struct dt_object *dt,
 	file->f_op = inode->i_fop;
 	set_file_inode(file, inode);
 
-	rc = ll_vfs_fsync_range(file, start, end, 0);
+	/* force the commit of the inode changes along with the other sync
+	 * requests, the fsync then finds it done and only flushes data */
+	rc = osd_sync_wait(osd_obj2dev(obj), LDISKFS_I(inode)->i_sync_tid,
+			   false);
+	if (rc == 0)
+		rc = ll_vfs_fsync_range(file, start, end, 0);
 
 	RETURN(rc);
 }
@@ -5937,6 +6282,12 @@ static void osd_umount(const struct lu_env *env, struct osd_device *o)
 {
 	ENTRY;
 
+	if (o->od_iput_wq != NULL) {
+		/* waits for the pending releases */
+		destroy_workqueue(o->od_iput_wq);
+		o->od_iput_wq = NULL;
+	}
+
 	if (o->od_mnt != NULL) {
 		shrink_dcache_sb(osd_sb(o));
 		osd_sync(env, &o->od_dt_dev);
@@ -6095,6 +6446,7 @@ static int osd_device_init0(const struct lu_env *env,
 
 	spin_lock_init(&o->od_osfs_lock);
 	mutex_init(&o->od_otable_mutex);
+	osd_sync_coord_init(&o->od_sync);
 
 	o->od_capa_hash = init_capa_hash();
 	if (o->od_capa_hash == NULL)
@@ -6103,6 +6455,8 @@ static int osd_device_init0(const struct lu_env *env,
 	o->od_read_cache = 1;
 	o->od_writethrough_cache = 1;
 	o->od_readcache_max_filesize = OSD_MAX_CACHE_SIZE;
+	spin_lock_init(&o->od_ra_budget.orb_lock);
+	o->od_ra_max_pages = OSD_RA_BUDGET_DEFAULT;
 
 	cplen = strlcpy(o->od_svname, lustre_cfg_string(cfg, 4),
 			sizeof(o->od_svname));
@@ -6120,6 +6474,10 @@ static int osd_device_init0(const struct lu_env *env,
 	if (rc != 0)
 		GOTO(out_capa, rc);
 
+	o->od_iput_wq = create_singlethread_workqueue("osd_iput");
+	if (o->od_iput_wq == NULL)
+		GOTO(out_mnt, rc = -ENOMEM);
+
 	rc = osd_obj_map_init(env, o);
 	if (rc != 0)
 		GOTO(out_mnt, rc);
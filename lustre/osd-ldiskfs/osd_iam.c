@@ -476,6 +476,7 @@ static int iam_leaf_load(struct iam_path *path)
 		       path->ip_frames[2].bh);
 	}
 	err = descr->id_ops->id_node_read(c, block, NULL, &bh);
+	path->ip_reads++;
 	if (err == 0) {
 		leaf->il_bh = bh;
 		leaf->il_curidx = block;
@@ -750,6 +751,19 @@ static struct dynlock_handle *iam_lock_htree(struct iam_container *ic,
 	return dynlock_lock(&ic->ic_tree_lock, value, lt, GFP_NOFS);
 }
 
+/*
+ * Mode of the leaf lock held by an iterator. Point lookups (neither
+ * IAM_IT_MOVE nor IAM_IT_WRITE) share the leaf, so that lookups of the
+ * OI, say, run in parallel. Iterators which may move stay exclusive:
+ * their user may modify the container from the same thread while the
+ * iterator is attached, which dynlocks allow for the write holder only.
+ */
+static inline enum dynlock_type iam_it_lock_type(const struct iam_iterator *it)
+{
+	return it->ii_flags & (IAM_IT_MOVE | IAM_IT_WRITE) ?
+	       DLT_WRITE : DLT_READ;
+}
+
 static int iam_index_lock(struct iam_path *path, struct dynlock_handle **lh)
 {
         struct iam_frame *f;
@@ -906,6 +920,7 @@ static int iam_lookup_try(struct iam_path *path)
              ++frame, ++i) {
                 err = param->id_ops->id_node_read(c, (iam_ptr_t)ptr, NULL,
                                                   &frame->bh);
+                path->ip_reads++;
                 do_corr(schedule());
 
                 iam_lock_bh(frame->bh);
@@ -1068,7 +1083,8 @@ static int iam_lookup_lock(struct iam_path *path,
  * Performs tree top-to-bottom traversal starting from root, and loads leaf
  * node.
  */
-static int iam_path_lookup(struct iam_path *path, int index)
+static int iam_path_lookup(struct iam_path *path, int index,
+			   enum dynlock_type lt)
 {
         struct iam_container *c;
         struct iam_leaf  *leaf;
@@ -1076,7 +1092,7 @@ static int iam_path_lookup(struct iam_path *path, int index)
 
         c = path->ip_container;
         leaf = &path->ip_leaf;
-        result = iam_lookup_lock(path, &leaf->il_lock, DLT_WRITE);
+	result = iam_lookup_lock(path, &leaf->il_lock, lt);
         assert_inv(iam_path_check(path));
         do_corr(schedule());
         if (result == 0) {
@@ -1106,7 +1122,7 @@ static int __iam_it_get(struct iam_iterator *it, int index)
         int result;
         assert_corr(it_state(it) == IAM_IT_DETACHED);
 
-        result = iam_path_lookup(&it->ii_path, index);
+	result = iam_path_lookup(&it->ii_path, index, iam_it_lock_type(it));
         if (result >= 0) {
                 int collision;
 
@@ -1368,6 +1384,7 @@ static int iam_htree_advance(struct inode *dir, __u32 hash,
                 iam_unlock_bh(p->bh);
                 err = iam_path_descr(path)->id_ops->
                         id_node_read(path->ip_container, idx, NULL, &bh);
+                path->ip_reads++;
                 if (err != 0)
                         return err; /* Failure */
                 ++p;
@@ -1530,7 +1547,7 @@ int iam_it_next(struct iam_iterator *it)
 				struct dynlock_handle *lh;
 				lh = iam_lock_htree(iam_it_container(it),
 						    path->ip_frame->leaf,
-						    DLT_WRITE);
+						    iam_it_lock_type(it));
                                 if (lh != NULL) {
                                         iam_leaf_fini(leaf);
                                         leaf->il_lock = lh;
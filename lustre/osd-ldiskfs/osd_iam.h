@@ -538,6 +538,10 @@ struct iam_path {
          * Description-specific data.
          */
         struct iam_path_descr *ip_data;
+        /*
+         * Number of nodes read by the lookups of this path.
+         */
+        unsigned int           ip_reads;
 };
 
 struct ldiskfs_dx_hash_info;
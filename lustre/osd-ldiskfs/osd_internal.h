@@ -52,6 +52,8 @@
 #include <linux/dcache.h>
 /* struct dirent64 */
 #include <linux/dirent.h>
+/* struct workqueue_struct */
+#include <linux/workqueue.h>
 #include <linux/statfs.h>
 #include <ldiskfs/ldiskfs.h>
 #include <ldiskfs/ldiskfs_jbd2.h>
@@ -107,6 +109,39 @@ struct osd_oi {
 
 extern const int osd_dto_credits_noquota[];
 
+/* sequential read streams tracked per object, see osd_read_prefetch() */
+#define OSD_RA_STREAMS		4
+/* largest prefetch window of a stream */
+#define OSD_RA_WINDOW_MAX	((4 << 20) >> PAGE_CACHE_SHIFT)
+/* default budget of prefetched pages not read yet, per device */
+#define OSD_RA_BUDGET_DEFAULT	((256 << 20) >> PAGE_CACHE_SHIFT)
+/* prefetched pages are charged to the budget in periods of
+ * OSD_RA_PERIOD seconds, pages not read within OSD_RA_PERIODS periods
+ * are considered abandoned or evicted and no longer count */
+#define OSD_RA_PERIOD		5
+#define OSD_RA_PERIODS		4
+
+struct osd_ra_stream {
+	pgoff_t		ras_next;	/* first page of the next read */
+	pgoff_t		ras_start;	/* pages prefetched */
+	pgoff_t		ras_end;
+	unsigned long	ras_pending;	/* of them, not read yet */
+	unsigned long	ras_period;	/* period ras_pending is charged to */
+	unsigned int	ras_length;	/* sequential reads so far */
+};
+
+/* per-device budget of prefetched pages, see osd_ra_charge() */
+struct osd_ra_budget {
+	spinlock_t	orb_lock;
+	unsigned long	orb_period[OSD_RA_PERIODS];
+	unsigned long	orb_pages[OSD_RA_PERIODS];
+};
+
+struct osd_ra {
+	unsigned int		ora_victim;
+	struct osd_ra_stream	ora_streams[OSD_RA_STREAMS];
+};
+
 struct osd_object {
         struct dt_object        oo_dt;
         /**
@@ -126,6 +161,13 @@ struct osd_object {
 	struct osd_directory	*oo_dir;
 	/** protects inode attributes. */
 	spinlock_t		oo_guard;
+	/** read streams, allocated on first read, protected by oo_guard */
+	struct osd_ra		*oo_ra;
+	/** copy of the LOV EA of a regular file, protected by oo_guard,
+	 * see osd_lov_cache_set() */
+	struct lu_buf		oo_lov_cache;
+	/** bumped by every change of the LOV EA, protected by oo_guard */
+	__u32			oo_lov_gen;
         /**
          * Following two members are used to indicate the presence of dot and
          * dotdot in the given directory. This is required for interop mode
@@ -216,6 +258,48 @@ struct osd_otable_it {
 				 ooi_waiting:1; /* it::next is waiting. */
 };
 
+/* max size of the LOV EA cached in osd_object::oo_lov_cache */
+#define OSD_LOV_CACHE_MAX		512
+
+/* unlinked files with more blocks than this (in 512-byte units) are
+ * released by od_iput_wq instead of the thread destroying them */
+#define OSD_IPUT_DEFER_BLOCKS		((1 << 20) >> 9)
+
+/* default bound of the wait of a sync group leader for more requests */
+#define OSD_SYNC_WINDOW_DEFAULT		2000	/* usec */
+
+/*
+ * journal commit coordinator: groups concurrent sync requests into one
+ * forced commit, see osd_sync_wait()
+ */
+struct osd_sync_coord {
+	spinlock_t		osc_lock;
+	wait_queue_head_t	osc_waitq;
+	/* serializes the forced commits of the groups */
+	struct mutex		osc_mutex;
+	/* a group is gathering sync requests */
+	unsigned int		osc_gathering:1,
+	/* a request of that group wants all stopped transactions committed */
+				osc_full:1;
+	/* highest transaction requested by the gathering group */
+	tid_t			osc_tid;
+	int			osc_waiters;
+	/* last group formed and last group committed */
+	__u64			osc_gen;
+	__u64			osc_done;
+	/* result of the commit of group osc_done, returned to its waiters */
+	int			osc_rc;
+	/* longest a leader waits for more requests, in usec */
+	unsigned int		osc_window_us;
+	/* statistics */
+	int			osc_last_waiters;
+	__u64			osc_avg_commit_us;
+	__u64			osc_commits;
+	__u64			osc_total_waiters;
+	__u64			osc_async_joined;
+	struct timeval		osc_stats_start;
+};
+
 /*
  * osd device.
  */
@@ -228,6 +312,8 @@ struct osd_device {
         struct osd_oi           **od_oi_table;
         /* total number of OI containers */
         int                       od_oi_count;
+	/* FID to inode cache in front of the OI, NULL if disabled */
+	struct osd_oi_cache	 *od_oi_cache;
         /*
          * Fid Capability
          */
@@ -260,6 +346,15 @@ struct osd_device {
 	int			od_read_cache;
 	int			od_writethrough_cache;
 
+	struct osd_sync_coord	od_sync;
+
+	/* pages prefetched and not read yet, and their limit */
+	struct osd_ra_budget	od_ra_budget;
+	unsigned long		od_ra_max_pages;
+
+	/* frees the blocks of large destroyed objects in the background */
+	struct workqueue_struct	*od_iput_wq;
+
 	struct brw_stats	od_brw_stats;
 	atomic_t		od_r_in_flight;
 	atomic_t		od_w_in_flight;
@@ -384,6 +479,8 @@ enum {
         LPROC_OSD_CACHE_ACCESS  = 4,
         LPROC_OSD_CACHE_HIT     = 5,
         LPROC_OSD_CACHE_MISS    = 6,
+	LPROC_OSD_PREFETCH	= 7,
+	LPROC_OSD_PREFETCH_HIT	= 8,
 
 #if OSD_THANDLE_STATS
         LPROC_OSD_THANDLE_STARTING,
@@ -1143,5 +1240,6 @@ void ldiskfs_inc_count(handle_t *handle, struct inode *inode);
 void ldiskfs_dec_count(handle_t *handle, struct inode *inode);
 
 void osd_fini_iobuf(struct osd_device *d, struct osd_iobuf *iobuf);
+void osd_ra_fini(struct osd_device *osd, struct osd_object *obj);
 
 #endif /* _OSD_INTERNAL_H */
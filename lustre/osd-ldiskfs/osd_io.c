@@ -238,13 +238,32 @@ static void record_start_io(struct osd_iobuf *iobuf, int size)
 	}
 }
 
+/*
+ * Writes are not writeback: the service thread waits for them in
+ * osd_trans_stop() before it replies, so tell the block layer they are
+ * synchronous rather than let them queue behind background writes.
+ *
+ * Kernels with request_queue->unplug_fn have no on-stack plug, and their
+ * WRITE_SYNC unplugs the queue after every bio, which defeats the merging
+ * of the bios of an RPC, so use WRITE_SYNC_PLUG there.
+ */
+#ifdef HAVE_REQUEST_QUEUE_UNPLUG_FN
+# ifdef WRITE_SYNC_PLUG
+#  define OSD_WRITE_SYNC	WRITE_SYNC_PLUG
+# else
+#  define OSD_WRITE_SYNC	WRITE
+# endif
+#else
+# define OSD_WRITE_SYNC		WRITE_SYNC
+#endif
+
 static void osd_submit_bio(int rw, struct bio *bio)
 {
         LASSERTF(rw == 0 || rw == 1, "%x\n", rw);
         if (rw == 0)
                 submit_bio(READ, bio);
         else
-                submit_bio(WRITE, bio);
+		submit_bio(OSD_WRITE_SYNC, bio);
 }
 
 static int can_be_merged(struct bio *bio, sector_t sector)
@@ -266,6 +285,9 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
         int            sector_bits = inode->i_sb->s_blocksize_bits - 9;
         unsigned int   blocksize = inode->i_sb->s_blocksize;
         struct bio    *bio = NULL;
+#ifndef HAVE_REQUEST_QUEUE_UNPLUG_FN
+	struct blk_plug plug;
+#endif
         struct page   *page;
         unsigned int   page_offset;
         sector_t       sector;
@@ -281,6 +303,12 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
         osd_brw_stats_update(osd, iobuf);
         iobuf->dr_start_time = cfs_time_current();
 
+#ifndef HAVE_REQUEST_QUEUE_UNPLUG_FN
+	/* hold the bios of the whole RPC in the plug, so that they are
+	 * merged and dispatched to the device queues in one batch */
+	blk_start_plug(&plug);
+#endif
+
         for (page_idx = 0, block_idx = 0;
              page_idx < npages;
              page_idx++, block_idx += blocks_per_page) {
@@ -367,6 +395,10 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
 	}
 
 out:
+#ifndef HAVE_REQUEST_QUEUE_UNPLUG_FN
+	blk_finish_plug(&plug);
+#endif
+
 	/* in order to achieve better IO throughput, we don't wait for writes
 	 * completion here. instead we proceed with transaction commit in
 	 * parallel and wait for IO completion once transaction is stopped
@@ -571,10 +603,14 @@ static long ldiskfs_ext_find_goal(struct inode *inode,
 			return path[depth].p_bh->b_blocknr;
 	}
 
-	/* OK. use inode's group */
+	/* OK. use inode's group. objects of a group are placed in
+	 * different parts of it by inode number, not by writing thread:
+	 * a service thread writes to many objects in turn, and placing
+	 * them all from the same point interleaves their extents, while
+	 * each object should have room to grow contiguously */
 	bg_start = (ei->i_block_group * LDISKFS_BLOCKS_PER_GROUP(inode->i_sb)) +
 		le32_to_cpu(LDISKFS_SB(inode->i_sb)->s_es->s_first_data_block);
-	colour = (current->pid % 16) *
+	colour = (inode->i_ino % 16) *
 		(LDISKFS_BLOCKS_PER_GROUP(inode->i_sb) / 16);
 	return bg_start + colour + block;
 }
@@ -950,6 +986,121 @@ cleanup:
 }
 #endif /* HAVE_LDISKFS_MAP_BLOCKS */
 
+/*
+ * Read prefetch.
+ *
+ * Reads of an object are matched against its last OSD_RA_STREAMS read
+ * streams: a read starting where one of them stopped continues it, any
+ * other read replaces the oldest stream. Once a stream is sequential, the
+ * pages following the read are read into the page cache asynchronously,
+ * in a window doubling with the length of the stream up to
+ * OSD_RA_WINDOW_MAX, so that the next reads of the stream find them there.
+ * Pages prefetched but not read yet are accounted against the per-device
+ * budget od_ra_max_pages, a window is only prefetched if it fits. The
+ * pages are charged to the current period of OSD_RA_PERIOD seconds, and
+ * only the last OSD_RA_PERIODS periods count, so that the pages of streams
+ * which stop in the middle of a window, or which are evicted before they
+ * are read, don't hold the budget while their objects stay cached.
+ */
+static inline unsigned long osd_ra_period(void)
+{
+	return cfs_time_current_sec() / OSD_RA_PERIOD;
+}
+
+/* release @nr pages charged to @period, called with orb_lock held */
+static void osd_ra_uncharge_locked(struct osd_ra_budget *orb,
+				   unsigned long period, unsigned long nr)
+{
+	int slot = period % OSD_RA_PERIODS;
+
+	/* nothing to do if the period is too old to count anymore */
+	if (orb->orb_period[slot] == period)
+		orb->orb_pages[slot] -= min(nr, orb->orb_pages[slot]);
+}
+
+/**
+ * Charge \a nr more prefetched pages of stream \a ras to the budget of
+ * \a osd. The pages already pending in the stream are moved to the current
+ * period with them, as the stream is still alive.
+ *
+ * \retval		true if the pages fit in the budget
+ */
+static bool osd_ra_charge(struct osd_device *osd, struct osd_ra_stream *ras,
+			  unsigned long nr)
+{
+	struct osd_ra_budget	*orb = &osd->od_ra_budget;
+	unsigned long		 period = osd_ra_period();
+	unsigned long		 total = 0;
+	int			 slot = period % OSD_RA_PERIODS;
+	int			 i;
+	bool			 fits;
+
+	spin_lock(&orb->orb_lock);
+	if (orb->orb_period[slot] != period) {
+		orb->orb_period[slot] = period;
+		orb->orb_pages[slot] = 0;
+	}
+	for (i = 0; i < OSD_RA_PERIODS; i++) {
+		if (period - orb->orb_period[i] < OSD_RA_PERIODS)
+			total += orb->orb_pages[i];
+	}
+
+	fits = total + nr <= osd->od_ra_max_pages;
+	if (fits) {
+		if (ras->ras_pending > 0 && ras->ras_period != period) {
+			osd_ra_uncharge_locked(orb, ras->ras_period,
+					       ras->ras_pending);
+			orb->orb_pages[slot] += ras->ras_pending;
+		}
+		orb->orb_pages[slot] += nr;
+		ras->ras_period = period;
+	}
+	spin_unlock(&orb->orb_lock);
+
+	return fits;
+}
+
+/* release @nr pending pages of @ras */
+static void osd_ra_uncharge(struct osd_device *osd, struct osd_ra_stream *ras,
+			    unsigned long nr)
+{
+	if (nr == 0)
+		return;
+
+	spin_lock(&osd->od_ra_budget.orb_lock);
+	osd_ra_uncharge_locked(&osd->od_ra_budget, ras->ras_period, nr);
+	spin_unlock(&osd->od_ra_budget.orb_lock);
+}
+
+static void osd_ra_stream_drop(struct osd_device *osd,
+			       struct osd_ra_stream *ras)
+{
+	osd_ra_uncharge(osd, ras, ras->ras_pending);
+	memset(ras, 0, sizeof(*ras));
+}
+
+/* drop all the read streams of @obj */
+static void osd_ra_drop(struct osd_device *osd, struct osd_object *obj)
+{
+	int i;
+
+	if (obj->oo_ra == NULL)
+		return;
+
+	for (i = 0; i < OSD_RA_STREAMS; i++)
+		osd_ra_stream_drop(osd, &obj->oo_ra->ora_streams[i]);
+}
+
+void osd_ra_fini(struct osd_device *osd, struct osd_object *obj)
+{
+	if (obj->oo_ra == NULL)
+		return;
+
+	osd_ra_drop(osd, obj);
+	OBD_FREE_PTR(obj->oo_ra);
+	obj->oo_ra = NULL;
+}
+
 static int osd_write_prep(const struct lu_env *env, struct dt_object *dt,
                           struct niobuf_local *lnb, int npages)
 {
@@ -980,6 +1131,14 @@ static int osd_write_prep(const struct lu_env *env, struct dt_object *dt,
         if (isize > osd->od_readcache_max_filesize)
                 cache = 0;
 
+	/* the pages written are dropped from the cache, and so may be
+	 * pages prefetched for the read streams of the object */
+	if (cache == 0 && osd_dt_obj(dt)->oo_ra != NULL) {
+		spin_lock(&osd_dt_obj(dt)->oo_guard);
+		osd_ra_drop(osd, osd_dt_obj(dt));
+		spin_unlock(&osd_dt_obj(dt)->oo_guard);
+	}
+
 	do_gettimeofday(&start);
 	for (i = 0; i < npages; i++) {
 
@@ -1258,6 +1417,113 @@ static int osd_write_commit(const struct lu_env *env, struct dt_object *dt,
 	RETURN(rc);
 }
 
+/**
+ * Account the read of pages [start, end] of \a obj in its read streams
+ * and prefetch the pages following them if the read continues a stream.
+ *
+ * \param[in] osd	osd device
+ * \param[in] obj	object read
+ * \param[in] start	first page read
+ * \param[in] end	last page read
+ * \param[in] hits	pages of the read found in the page cache
+ */
+static void osd_read_prefetch(struct osd_device *osd, struct osd_object *obj,
+			      pgoff_t start, pgoff_t end, int hits)
+{
+	struct inode		*inode = obj->oo_inode;
+	struct osd_ra_stream	*ras = NULL;
+	struct file_ra_state	 ra;
+	unsigned long		 npages = end - start + 1;
+	unsigned long		 consumed = 0;
+	unsigned long		 nr = 0;
+	loff_t			 isize = i_size_read(inode);
+	pgoff_t			 index = 0;
+	int			 i;
+
+	if (obj->oo_ra == NULL) {
+		struct osd_ra *ora;
+
+		OBD_ALLOC_PTR(ora);
+		if (ora == NULL)
+			return;
+		spin_lock(&obj->oo_guard);
+		if (obj->oo_ra == NULL) {
+			obj->oo_ra = ora;
+			ora = NULL;
+		}
+		spin_unlock(&obj->oo_guard);
+		if (ora != NULL)
+			OBD_FREE_PTR(ora);
+	}
+
+	spin_lock(&obj->oo_guard);
+	for (i = 0; i < OSD_RA_STREAMS; i++) {
+		if (obj->oo_ra->ora_streams[i].ras_length > 0 &&
+		    obj->oo_ra->ora_streams[i].ras_next == start) {
+			ras = &obj->oo_ra->ora_streams[i];
+			break;
+		}
+	}
+
+	if (ras == NULL) {
+		/* a new stream replaces the oldest one */
+		i = obj->oo_ra->ora_victim++ % OSD_RA_STREAMS;
+		ras = &obj->oo_ra->ora_streams[i];
+		osd_ra_stream_drop(osd, ras);
+	} else if (ras->ras_end > start && ras->ras_start <= end) {
+		/* pages of the prefetched window read now */
+		consumed = min_t(unsigned long, ras->ras_pending,
+				 min(end + 1, ras->ras_end) -
+				 max(start, ras->ras_start));
+		osd_ra_uncharge(osd, ras, consumed);
+		ras->ras_pending -= consumed;
+	}
+	ras->ras_length++;
+	ras->ras_next = end + 1;
+
+	/* prefetch when the stream gets within one read of the end of the
+	 * window, and only into a page cache that keeps the pages */
+	if (ras->ras_length > 1 && osd->od_read_cache &&
+	    isize <= osd->od_readcache_max_filesize && isize > 0 &&
+	    ras->ras_end <= end + npages) {
+		pgoff_t eof = (isize - 1) >> PAGE_CACHE_SHIFT;
+
+		index = max(end + 1, ras->ras_end);
+		if (index <= eof) {
+			nr = npages << min(ras->ras_length - 1, 4U);
+			nr = min_t(unsigned long, nr, OSD_RA_WINDOW_MAX);
+			nr = min_t(unsigned long, nr, eof - index + 1);
+		}
+		if (nr > 0 && ras->ras_end < index) {
+			/* the pages prefetched before are all read */
+			osd_ra_uncharge(osd, ras, ras->ras_pending);
+			ras->ras_pending = 0;
+		}
+		if (nr > 0 && !osd_ra_charge(osd, ras, nr))
+			nr = 0;
+		if (nr > 0) {
+			if (ras->ras_end < index)
+				ras->ras_start = index;
+			ras->ras_end = index + nr;
+			ras->ras_pending += nr;
+		}
+	}
+	spin_unlock(&obj->oo_guard);
+
+	if (consumed > 0 && hits > 0)
+		lprocfs_counter_add(osd->od_stats, LPROC_OSD_PREFETCH_HIT,
+				    min_t(unsigned long, consumed, hits));
+
+	if (nr > 0) {
+		file_ra_state_init(&ra, inode->i_mapping);
+		ra.ra_pages = nr;
+		/* only starts the reads of the pages not cached yet */
+		page_cache_sync_readahead(inode->i_mapping, &ra, NULL,
+					  index, nr);
+		lprocfs_counter_add(osd->od_stats, LPROC_OSD_PREFETCH, nr);
+	}
+}
+
 static int osd_read_prep(const struct lu_env *env, struct dt_object *dt,
                          struct niobuf_local *lnb, int npages)
 {
@@ -1330,6 +1596,13 @@ static int osd_read_prep(const struct lu_env *env, struct dt_object *dt,
                 /* IO stats will be done in osd_bufs_put() */
         }
 
+	/* prefetch while the pages read are sent to the client */
+	if (rc == 0 && i > 0)
+		osd_read_prefetch(osd, osd_dt_obj(dt),
+				  lnb[0].lnb_file_offset >> PAGE_CACHE_SHIFT,
+				  lnb[i - 1].lnb_file_offset >> PAGE_CACHE_SHIFT,
+				  cache_hits);
+
         RETURN(rc);
 }
 
@@ -59,6 +59,7 @@ void osd_brw_stats_update(struct osd_device *osd, struct osd_iobuf *iobuf)
         int               i, nr_pages = iobuf->dr_npages;
         int               blocks_per_page;
         int               rw = iobuf->dr_rw;
+	__u64		  extents_mb;
 
         if (unlikely(nr_pages == 0))
                 return;
@@ -81,6 +82,12 @@ void osd_brw_stats_update(struct osd_device *osd, struct osd_iobuf *iobuf)
 
         lprocfs_oh_tally(&s->hist[BRW_R_DISCONT_PAGES+rw], discont_pages);
         lprocfs_oh_tally(&s->hist[BRW_R_DISCONT_BLOCKS+rw], discont_blocks);
+
+	/* on-disk fragmentation: extents of the object met per MB of the
+	 * RPC, a contiguous RPC counts one whatever its size */
+	extents_mb = (__u64)discont_blocks << 20;
+	do_div(extents_mb, (__u32)iobuf->dr_npages << PAGE_CACHE_SHIFT);
+	lprocfs_oh_tally_log2(&s->hist[BRW_R_EXTENTS_MB+rw], 1 + extents_mb);
 }
 
 #define pct(a, b) (b ? a * 100 / b : 0)
@@ -160,6 +167,10 @@ static void brw_stats_show(struct seq_file *seq, struct brw_stats *brw_stats)
         display_brw_stats(seq, "disk I/O size", "ios",
                           &brw_stats->hist[BRW_R_DISK_IOSIZE],
                           &brw_stats->hist[BRW_W_DISK_IOSIZE], 1);
+
+	display_brw_stats(seq, "extents per MB", "rpcs",
+			  &brw_stats->hist[BRW_R_EXTENTS_MB],
+			  &brw_stats->hist[BRW_W_EXTENTS_MB], 1);
 }
 
 #undef pct
@@ -218,6 +229,12 @@ static int osd_stats_init(struct osd_device *osd)
                 lprocfs_counter_init(osd->od_stats, LPROC_OSD_CACHE_MISS,
                                      LPROCFS_CNTR_AVGMINMAX,
                                      "cache_miss", "pages");
+		lprocfs_counter_init(osd->od_stats, LPROC_OSD_PREFETCH,
+				     LPROCFS_CNTR_AVGMINMAX,
+				     "prefetch", "pages");
+		lprocfs_counter_init(osd->od_stats, LPROC_OSD_PREFETCH_HIT,
+				     LPROCFS_CNTR_AVGMINMAX,
+				     "prefetch_hit", "pages");
 #if OSD_THANDLE_STATS
                 lprocfs_counter_init(osd->od_stats, LPROC_OSD_THANDLE_STARTING,
                                      LPROCFS_CNTR_AVGMINMAX,
@@ -514,6 +531,146 @@ static int ldiskfs_osd_oi_scrub_seq_show(struct seq_file *m, void *data)
 }
 LPROC_SEQ_FOPS_RO(ldiskfs_osd_oi_scrub);
 
+static int ldiskfs_osd_oi_stats_seq_show(struct seq_file *m, void *data)
+{
+	struct osd_device *dev = osd_dt_dev((struct dt_device *)m->private);
+
+	LASSERT(dev != NULL);
+	if (unlikely(dev->od_mnt == NULL))
+		return -EINPROGRESS;
+
+	return osd_oi_cache_dump(m, dev);
+}
+
+/* writing anything resets the statistics */
+static ssize_t
+ldiskfs_osd_oi_stats_seq_write(struct file *file, const char *buffer,
+			       size_t count, loff_t *off)
+{
+	struct seq_file	  *m = file->private_data;
+	struct osd_device *dev = osd_dt_dev((struct dt_device *)m->private);
+
+	LASSERT(dev != NULL);
+	if (unlikely(dev->od_mnt == NULL))
+		return -EINPROGRESS;
+
+	osd_oi_cache_stats_reset(dev);
+
+	return count;
+}
+LPROC_SEQ_FOPS(ldiskfs_osd_oi_stats);
+
+static int ldiskfs_osd_sync_stats_seq_show(struct seq_file *m, void *data)
+{
+	struct osd_device	*dev = osd_dt_dev((struct dt_device *)m->private);
+	struct osd_sync_coord	*osc;
+	struct timeval		 now;
+	__u64			 commits;
+	__u64			 waiters;
+	__u64			 async;
+	__u64			 avg;
+	__u64			 per_commit;
+	__u64			 rate;
+	unsigned int		 hundredths;
+	long			 secs;
+
+	LASSERT(dev != NULL);
+	if (unlikely(dev->od_mnt == NULL))
+		return -EINPROGRESS;
+
+	osc = &dev->od_sync;
+	do_gettimeofday(&now);
+	spin_lock(&osc->osc_lock);
+	commits = osc->osc_commits;
+	waiters = osc->osc_total_waiters;
+	async = osc->osc_async_joined;
+	avg = osc->osc_avg_commit_us;
+	secs = now.tv_sec - osc->osc_stats_start.tv_sec;
+	spin_unlock(&osc->osc_lock);
+
+	/* hundredths of waiters per commit */
+	per_commit = waiters * 100;
+	if (commits > 0)
+		do_div(per_commit, commits);
+	else
+		per_commit = 0;
+	hundredths = do_div(per_commit, 100);
+	rate = commits;
+	do_div(rate, secs > 0 ? secs : 1);
+
+	seq_printf(m, "snapshot_time:         %lu.%lu (secs.usecs)\n"
+		   "commits:               "LPU64"\n"
+		   "commits_per_second:    "LPU64"\n"
+		   "sync_waiters:          "LPU64"\n"
+		   "waiters_per_commit:    "LPU64".%02u\n"
+		   "async_joined:          "LPU64"\n"
+		   "avg_commit_time:       "LPU64" usecs\n",
+		   now.tv_sec, now.tv_usec, commits, rate, waiters,
+		   per_commit, hundredths, async, avg);
+
+	return 0;
+}
+
+/* writing anything resets the statistics */
+static ssize_t
+ldiskfs_osd_sync_stats_seq_write(struct file *file, const char *buffer,
+				 size_t count, loff_t *off)
+{
+	struct seq_file		*m = file->private_data;
+	struct osd_device	*dev = osd_dt_dev((struct dt_device *)m->private);
+	struct osd_sync_coord	*osc;
+
+	LASSERT(dev != NULL);
+	if (unlikely(dev->od_mnt == NULL))
+		return -EINPROGRESS;
+
+	osc = &dev->od_sync;
+	spin_lock(&osc->osc_lock);
+	osc->osc_commits = 0;
+	osc->osc_total_waiters = 0;
+	osc->osc_async_joined = 0;
+	do_gettimeofday(&osc->osc_stats_start);
+	spin_unlock(&osc->osc_lock);
+
+	return count;
+}
+LPROC_SEQ_FOPS(ldiskfs_osd_sync_stats);
+
+static int ldiskfs_osd_sync_window_seq_show(struct seq_file *m, void *data)
+{
+	struct osd_device *dev = osd_dt_dev((struct dt_device *)m->private);
+
+	LASSERT(dev != NULL);
+	if (unlikely(dev->od_mnt == NULL))
+		return -EINPROGRESS;
+
+	return seq_printf(m, "%u\n", dev->od_sync.osc_window_us);
+}
+
+static ssize_t
+ldiskfs_osd_sync_window_seq_write(struct file *file, const char *buffer,
+				  size_t count, loff_t *off)
+{
+	struct seq_file	  *m = file->private_data;
+	struct dt_device  *dt = m->private;
+	struct osd_device *dev = osd_dt_dev(dt);
+	int		   val, rc;
+
+	LASSERT(dev != NULL);
+	if (unlikely(dev->od_mnt == NULL))
+		return -EINPROGRESS;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+	if (val < 0 || val > USEC_PER_SEC)
+		return -EINVAL;
+
+	dev->od_sync.osc_window_us = val;
+	return count;
+}
+LPROC_SEQ_FOPS(ldiskfs_osd_sync_window);
+
 static int ldiskfs_osd_readcache_seq_show(struct seq_file *m, void *data)
 {
 	struct osd_device *osd = osd_dt_dev((struct dt_device *)m->private);
@@ -549,6 +706,44 @@ ldiskfs_osd_readcache_seq_write(struct file *file, const char *buffer,
 }
 LPROC_SEQ_FOPS(ldiskfs_osd_readcache);
 
+static int ldiskfs_osd_read_prefetch_seq_show(struct seq_file *m, void *data)
+{
+	struct osd_device *osd = osd_dt_dev((struct dt_device *)m->private);
+
+	LASSERT(osd != NULL);
+	if (unlikely(osd->od_mnt == NULL))
+		return -EINPROGRESS;
+
+	return seq_printf(m, "%lu\n",
+			  osd->od_ra_max_pages >> (20 - PAGE_CACHE_SHIFT));
+}
+
+/* budget of prefetched pages not read yet, in MB, 0 disables prefetch */
+static ssize_t
+ldiskfs_osd_read_prefetch_seq_write(struct file *file, const char *buffer,
+				    size_t count, loff_t *off)
+{
+	struct seq_file	  *m = file->private_data;
+	struct dt_device  *dt = m->private;
+	struct osd_device *osd = osd_dt_dev(dt);
+	__u64		   val;
+	int		   rc;
+
+	LASSERT(osd != NULL);
+	if (unlikely(osd->od_mnt == NULL))
+		return -EINPROGRESS;
+
+	rc = lprocfs_write_u64_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+	if (val > (totalram_pages >> (20 - PAGE_CACHE_SHIFT)) / 2)
+		return -ERANGE;
+
+	osd->od_ra_max_pages = val << (20 - PAGE_CACHE_SHIFT);
+	return count;
+}
+LPROC_SEQ_FOPS(ldiskfs_osd_read_prefetch);
+
 static int ldiskfs_osd_lma_self_repair_seq_show(struct seq_file *m, void *data)
 {
 	struct osd_device *dev = osd_dt_dev((struct dt_device *)m->private);
@@ -619,12 +814,20 @@ struct lprocfs_vars lprocfs_osd_obd_vars[] = {
 	  .fops	=	&ldiskfs_osd_full_scrub_threshold_rate_fops	},
 	{ .name	=	"oi_scrub",
 	  .fops	=	&ldiskfs_osd_oi_scrub_fops	},
+	{ .name	=	"oi_stats",
+	  .fops	=	&ldiskfs_osd_oi_stats_fops	},
+	{ .name	=	"sync_stats",
+	  .fops	=	&ldiskfs_osd_sync_stats_fops	},
+	{ .name	=	"sync_window_us",
+	  .fops	=	&ldiskfs_osd_sync_window_fops	},
 	{ .name	=	"read_cache_enable",
 	  .fops	=	&ldiskfs_osd_cache_fops		},
 	{ .name	=	"writethrough_cache_enable",
 	  .fops	=	&ldiskfs_osd_wcache_fops	},
 	{ .name	=	"readcache_max_filesize",
 	  .fops	=	&ldiskfs_osd_readcache_fops	},
+	{ .name	=	"read_prefetch_max_mb",
+	  .fops	=	&ldiskfs_osd_read_prefetch_fops	},
 	{ .name	=	"lma_self_repair",
 	  .fops	=	&ldiskfs_osd_lma_self_repair_fops	},
 	{ NULL }
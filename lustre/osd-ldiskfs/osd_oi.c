@@ -79,6 +79,328 @@ static struct dt_index_features oi_feat = {
 
 #define OSD_OI_NAME_BASE        "oi.16"
 
+/*
+ * FID to inode cache
+ *
+ * A bounded LRU cache of FID to (ino, generation) mappings in front of the
+ * OI files and the OST object map, so that looking up an object which fell
+ * out of the lu_site cache does not walk the index on disk again. It is
+ * filled by the lookups, the inserts and the OI scrub, and kept coherent by
+ * osd_oi_insert(), osd_oi_update() and osd_oi_delete(). It is split over the
+ * CPU partitions by FID hash, each part with its own lock and LRU list.
+ */
+static unsigned int osd_oi_cache_max = 1 << 18;
+CFS_MODULE_PARM(osd_oi_cache_max, "i", int, 0444,
+		"Maximum FID to inode mappings cached by each OSD, "
+		"0 to disable the cache.");
+
+static struct osd_oi_cache_part *
+osd_oi_cache_part(struct osd_oi_cache *cache, const struct lu_fid *fid,
+		  struct hlist_head **head)
+{
+	struct osd_oi_cache_part	*part;
+	__u32				 hash = fid_hash(fid, 32);
+	int				 ncpt = cfs_cpt_number(cfs_cpt_table);
+
+	part = cache->occ_parts[hash % ncpt];
+	*head = &part->ocp_hash[(hash / ncpt) &
+				((1 << cache->occ_hash_bits) - 1)];
+
+	return part;
+}
+
+static struct osd_oi_cache_entry *
+osd_oi_cache_find(struct hlist_head *head, const struct lu_fid *fid)
+{
+	struct osd_oi_cache_entry	*oce;
+	struct hlist_node		*node;
+
+	cfs_hlist_for_each_entry(oce, node, head, oce_hash) {
+		if (lu_fid_eq(&oce->oce_fid, fid))
+			return oce;
+	}
+
+	return NULL;
+}
+
+static void osd_oi_cache_entry_free(struct osd_oi_cache_part *part,
+				    struct osd_oi_cache_entry *oce)
+{
+	hlist_del(&oce->oce_hash);
+	list_del(&oce->oce_lru);
+	part->ocp_count--;
+	OBD_SLAB_FREE_PTR(oce, osd_oi_cache_kmem);
+}
+
+/* Return true and the mapping of \a fid if it is cached */
+static bool osd_oi_cache_lookup(struct osd_device *osd,
+				const struct lu_fid *fid,
+				struct osd_inode_id *id)
+{
+	struct osd_oi_cache		*cache = osd->od_oi_cache;
+	struct osd_oi_cache_part	*part;
+	struct osd_oi_cache_entry	*oce;
+	struct hlist_head		*head;
+
+	if (cache == NULL)
+		return false;
+
+	part = osd_oi_cache_part(cache, fid, &head);
+	spin_lock(&part->ocp_lock);
+	part->ocp_lookups++;
+	oce = osd_oi_cache_find(head, fid);
+	if (oce != NULL) {
+		part->ocp_hits++;
+		*id = oce->oce_id;
+		list_move(&oce->oce_lru, &part->ocp_lru);
+	}
+	spin_unlock(&part->ocp_lock);
+
+	return oce != NULL;
+}
+
+void osd_oi_cache_insert(struct osd_device *osd, const struct lu_fid *fid,
+			 const struct osd_inode_id *id)
+{
+	struct osd_oi_cache		*cache = osd->od_oi_cache;
+	struct osd_oi_cache_part	*part;
+	struct osd_oi_cache_entry	*oce;
+	struct osd_oi_cache_entry	*new;
+	struct hlist_head		*head;
+
+	if (cache == NULL)
+		return;
+
+	part = osd_oi_cache_part(cache, fid, &head);
+	spin_lock(&part->ocp_lock);
+	oce = osd_oi_cache_find(head, fid);
+	if (oce != NULL) {
+		oce->oce_id = *id;
+		list_move(&oce->oce_lru, &part->ocp_lru);
+		spin_unlock(&part->ocp_lock);
+		return;
+	}
+
+	/* reuse the least recently used entry once the part is full */
+	if (part->ocp_count >= part->ocp_max) {
+		oce = list_entry(part->ocp_lru.prev, struct osd_oi_cache_entry,
+				 oce_lru);
+		hlist_del(&oce->oce_hash);
+		list_del(&oce->oce_lru);
+		part->ocp_count--;
+	}
+	spin_unlock(&part->ocp_lock);
+
+	if (oce == NULL) {
+		OBD_SLAB_ALLOC_PTR_GFP(oce, osd_oi_cache_kmem, GFP_NOFS);
+		if (oce == NULL)
+			return;
+	}
+	oce->oce_fid = *fid;
+	oce->oce_id = *id;
+
+	spin_lock(&part->ocp_lock);
+	/* raced with another insert */
+	new = osd_oi_cache_find(head, fid);
+	if (new != NULL) {
+		new->oce_id = *id;
+		spin_unlock(&part->ocp_lock);
+		OBD_SLAB_FREE_PTR(oce, osd_oi_cache_kmem);
+		return;
+	}
+	hlist_add_head(&oce->oce_hash, head);
+	list_add(&oce->oce_lru, &part->ocp_lru);
+	part->ocp_count++;
+	spin_unlock(&part->ocp_lock);
+}
+
+void osd_oi_cache_delete(struct osd_device *osd, const struct lu_fid *fid)
+{
+	struct osd_oi_cache		*cache = osd->od_oi_cache;
+	struct osd_oi_cache_part	*part;
+	struct osd_oi_cache_entry	*oce;
+	struct hlist_head		*head;
+
+	if (cache == NULL)
+		return;
+
+	part = osd_oi_cache_part(cache, fid, &head);
+	spin_lock(&part->ocp_lock);
+	oce = osd_oi_cache_find(head, fid);
+	if (oce != NULL)
+		osd_oi_cache_entry_free(part, oce);
+	spin_unlock(&part->ocp_lock);
+}
+
+/* Account an IAM lookup of \a fid which read \a blocks index nodes */
+static void osd_oi_cache_iam_account(struct osd_device *osd,
+				     const struct lu_fid *fid,
+				     unsigned int blocks)
+{
+	struct osd_oi_cache_part	*part;
+	struct hlist_head		*head;
+
+	if (osd->od_oi_cache == NULL)
+		return;
+
+	part = osd_oi_cache_part(osd->od_oi_cache, fid, &head);
+	spin_lock(&part->ocp_lock);
+	part->ocp_iam_lookups++;
+	part->ocp_iam_blocks += blocks;
+	spin_unlock(&part->ocp_lock);
+}
+
+static void osd_oi_cache_fini(struct osd_device *osd)
+{
+	struct osd_oi_cache		*cache = osd->od_oi_cache;
+	struct osd_oi_cache_part	*part;
+	struct osd_oi_cache_entry	*oce;
+	struct osd_oi_cache_entry	*tmp;
+	int				 i;
+
+	if (cache == NULL)
+		return;
+
+	osd->od_oi_cache = NULL;
+	cfs_percpt_for_each(part, i, cache->occ_parts) {
+		if (part->ocp_hash == NULL)
+			continue;
+
+		list_for_each_entry_safe(oce, tmp, &part->ocp_lru, oce_lru)
+			osd_oi_cache_entry_free(part, oce);
+		OBD_FREE_LARGE(part->ocp_hash,
+			       sizeof(*part->ocp_hash) <<
+			       cache->occ_hash_bits);
+	}
+	cfs_percpt_free(cache->occ_parts);
+	OBD_FREE_PTR(cache);
+}
+
+static int osd_oi_cache_init(struct osd_device *osd)
+{
+	struct osd_oi_cache		*cache;
+	struct osd_oi_cache_part	*part;
+	int				 ncpt = cfs_cpt_number(cfs_cpt_table);
+	unsigned int			 max;
+	int				 i;
+	int				 j;
+
+	if (osd_oi_cache_max == 0)
+		return 0;
+
+	OBD_ALLOC_PTR(cache);
+	if (cache == NULL)
+		return -ENOMEM;
+
+	cache->occ_parts = cfs_percpt_alloc(cfs_cpt_table, sizeof(*part));
+	if (cache->occ_parts == NULL) {
+		OBD_FREE_PTR(cache);
+		return -ENOMEM;
+	}
+
+	/* about 4 entries per hash chain once full */
+	max = max_t(unsigned int, osd_oi_cache_max / ncpt, 1);
+	cache->occ_hash_bits = max_t(int, ilog2(max) - 2, 4);
+	osd->od_oi_cache = cache;
+
+	cfs_percpt_for_each(part, i, cache->occ_parts) {
+		spin_lock_init(&part->ocp_lock);
+		INIT_LIST_HEAD(&part->ocp_lru);
+		part->ocp_max = max;
+		OBD_CPT_ALLOC_LARGE(part->ocp_hash, cfs_cpt_table, i,
+				    sizeof(*part->ocp_hash) <<
+				    cache->occ_hash_bits);
+		if (part->ocp_hash == NULL) {
+			osd_oi_cache_fini(osd);
+			return -ENOMEM;
+		}
+		for (j = 0; j < 1 << cache->occ_hash_bits; j++)
+			INIT_HLIST_HEAD(&part->ocp_hash[j]);
+	}
+
+	return 0;
+}
+
+int osd_oi_cache_dump(struct seq_file *m, struct osd_device *osd)
+{
+	struct osd_oi_cache		*cache = osd->od_oi_cache;
+	struct osd_oi_cache_part	*part;
+	__u64				 lookups = 0;
+	__u64				 hits = 0;
+	__u64				 iam_lookups = 0;
+	__u64				 iam_blocks = 0;
+	__u64				 count = 0;
+	__u64				 max = 0;
+	struct dynlock_stats		 locks = { 0 };
+	int				 i;
+
+	if (cache != NULL) {
+		cfs_percpt_for_each(part, i, cache->occ_parts) {
+			spin_lock(&part->ocp_lock);
+			lookups += part->ocp_lookups;
+			hits += part->ocp_hits;
+			iam_lookups += part->ocp_iam_lookups;
+			iam_blocks += part->ocp_iam_blocks;
+			count += part->ocp_count;
+			max += part->ocp_max;
+			spin_unlock(&part->ocp_lock);
+		}
+	}
+
+	seq_printf(m, "cache_entries: "LPU64"\n"
+		   "cache_max: "LPU64"\n"
+		   "lookups: "LPU64"\n"
+		   "cache_hits: "LPU64"\n"
+		   "hit_rate: "LPU64"%%\n"
+		   "iam_lookups: "LPU64"\n"
+		   "iam_blocks: "LPU64"\n"
+		   "iam_blocks_per_lookup: "LPU64".%02u\n",
+		   count, max, lookups, hits,
+		   lookups != 0 ? div64_u64(hits * 100, lookups) : 0,
+		   iam_lookups, iam_blocks,
+		   iam_lookups != 0 ? div64_u64(iam_blocks, iam_lookups) : 0,
+		   iam_lookups != 0 ?
+		   (unsigned int)div64_u64(iam_blocks * 100, iam_lookups) % 100 :
+		   0);
+
+	/* tree locks of the OI containers: lookups take leaves shared */
+	for (i = 0; osd->od_oi_table != NULL && i < osd->od_oi_count; i++)
+		if (osd->od_oi_table[i] != NULL)
+			dynlock_stats_add(&osd->od_oi_table[i]->oi_dir.
+					  od_container.ic_tree_lock, &locks);
+
+	seq_printf(m, "iam_locks_shared: "LPU64"\n"
+		   "iam_locks_exclusive: "LPU64"\n"
+		   "iam_lock_waits: "LPU64"\n",
+		   locks.ds_shared, locks.ds_exclusive, locks.ds_waits);
+
+	return 0;
+}
+
+void osd_oi_cache_stats_reset(struct osd_device *osd)
+{
+	struct osd_oi_cache		*cache = osd->od_oi_cache;
+	struct osd_oi_cache_part	*part;
+	int				 i;
+
+	for (i = 0; osd->od_oi_table != NULL && i < osd->od_oi_count; i++)
+		if (osd->od_oi_table[i] != NULL)
+			dynlock_stats_reset(&osd->od_oi_table[i]->oi_dir.
+					    od_container.ic_tree_lock);
+
+	if (cache == NULL)
+		return;
+
+	cfs_percpt_for_each(part, i, cache->occ_parts) {
+		spin_lock(&part->ocp_lock);
+		part->ocp_lookups = 0;
+		part->ocp_hits = 0;
+		part->ocp_iam_lookups = 0;
+		part->ocp_iam_blocks = 0;
+		spin_unlock(&part->ocp_lock);
+	}
+}
+
 static void osd_oi_table_put(struct osd_thread_info *info,
 			     struct osd_oi **oi_table, unsigned oi_count)
 {
@@ -422,10 +744,14 @@ out:
 		LASSERT((rc & (rc - 1)) == 0);
 		osd->od_oi_table = oi;
 		osd->od_oi_count = rc;
+		if (osd_oi_cache_init(osd) != 0)
+			CWARN("%s: cannot allocate the FID to inode cache, "
+			      "running without it\n", osd_name(osd));
 		if (sf->sf_oi_count != rc) {
 			sf->sf_oi_count = rc;
 			rc = osd_scrub_file_store(scrub);
 			if (rc < 0) {
+				osd_oi_cache_fini(osd);
 				osd_oi_table_put(info, oi, sf->sf_oi_count);
 				OBD_FREE(oi, sizeof(*oi) * OSD_OI_FID_NR_MAX);
 			}
@@ -443,6 +769,7 @@ void osd_oi_fini(struct osd_thread_info *info, struct osd_device *osd)
 	if (unlikely(osd->od_oi_table == NULL))
 		return;
 
+	osd_oi_cache_fini(osd);
         osd_oi_table_put(info, osd->od_oi_table, osd->od_oi_count);
 
         OBD_FREE(osd->od_oi_table,
@@ -459,7 +786,7 @@ static inline int fid_is_fs_root(const struct lu_fid *fid)
 
 static int osd_oi_iam_lookup(struct osd_thread_info *oti,
                              struct osd_oi *oi, struct dt_rec *rec,
-                             const struct dt_key *key)
+                             const struct dt_key *key, unsigned int *blocks)
 {
         struct iam_container  *bag;
         struct iam_iterator   *it = &oti->oti_idx_it;
@@ -481,6 +808,7 @@ static int osd_oi_iam_lookup(struct osd_thread_info *oti,
         rc = iam_it_get(it, (struct iam_key *)key);
 	if (rc > 0)
 		iam_reccpy(&it->ii_path.ip_leaf, (struct iam_rec *)rec);
+	*blocks = it->ii_path.ip_reads;
         iam_it_put(it);
         iam_it_fini(it);
         osd_ipd_put(oti->oti_env, bag, ipd);
@@ -529,11 +857,13 @@ static int __osd_oi_lookup(struct osd_thread_info *info, struct osd_device *osd,
 			   const struct lu_fid *fid, struct osd_inode_id *id)
 {
 	struct lu_fid *oi_fid = &info->oti_fid2;
+	unsigned int   blocks = 0;
 	int	       rc;
 
 	fid_cpu_to_be(oi_fid, fid);
 	rc = osd_oi_iam_lookup(info, osd_fid2oi(osd, fid), (struct dt_rec *)id,
-			       (const struct dt_key *)oi_fid);
+			       (const struct dt_key *)oi_fid, &blocks);
+	osd_oi_cache_iam_account(osd, fid, blocks);
 	if (rc > 0) {
 		osd_id_unpack(id, id);
 		rc = 0;
@@ -547,15 +877,24 @@ int osd_oi_lookup(struct osd_thread_info *info, struct osd_device *osd,
 		  const struct lu_fid *fid, struct osd_inode_id *id,
 		  enum oi_check_flags flags)
 {
+	int rc;
+
 	if (unlikely(fid_is_last_id(fid)))
 		return osd_obj_spec_lookup(info, osd, fid, id);
 
-	if (fid_is_on_ost(info, osd, fid, flags) || fid_is_llog(fid))
-		return osd_obj_map_lookup(info, osd, fid, id);
+	if (fid_is_on_ost(info, osd, fid, flags) || fid_is_llog(fid)) {
+		if (!(flags & OI_NO_CACHE) &&
+		    osd_oi_cache_lookup(osd, fid, id))
+			return 0;
 
+		rc = osd_obj_map_lookup(info, osd, fid, id);
+		if (rc == 0)
+			osd_oi_cache_insert(osd, fid, id);
+		return rc;
+	}
 
+	/* local files are not cached, they fall back to other lookups */
 	if (unlikely(fid_seq(fid) == FID_SEQ_LOCAL_FILE)) {
-		int rc;
 		if (fid_is_fs_root(fid)) {
 			osd_id_gen(id, osd_sb(osd)->s_root->d_inode->i_ino,
 				   osd_sb(osd)->s_root->d_inode->i_generation);
@@ -576,7 +915,14 @@ int osd_oi_lookup(struct osd_thread_info *info, struct osd_device *osd,
 		return 0;
 	}
 
-	return __osd_oi_lookup(info, osd, fid, id);
+	if (!(flags & OI_NO_CACHE) && osd_oi_cache_lookup(osd, fid, id))
+		return 0;
+
+	rc = __osd_oi_lookup(info, osd, fid, id);
+	if (rc == 0)
+		osd_oi_cache_insert(osd, fid, id);
+
+	return rc;
 }
 
 static int osd_oi_iam_refresh(struct osd_thread_info *oti, struct osd_oi *oi,
@@ -621,8 +967,12 @@ int osd_oi_insert(struct osd_thread_info *info, struct osd_device *osd,
 	if (unlikely(fid_is_last_id(fid)))
 		return osd_obj_spec_insert(info, osd, fid, id, th);
 
-	if (fid_is_on_ost(info, osd, fid, flags) || fid_is_llog(fid))
-		return osd_obj_map_insert(info, osd, fid, id, th);
+	if (fid_is_on_ost(info, osd, fid, flags) || fid_is_llog(fid)) {
+		rc = osd_obj_map_insert(info, osd, fid, id, th);
+		if (rc == 0)
+			osd_oi_cache_insert(osd, fid, id);
+		return rc;
+	}
 
 	fid_cpu_to_be(oi_fid, fid);
 	osd_id_pack(oi_id, id);
@@ -636,7 +986,7 @@ int osd_oi_insert(struct osd_thread_info *info, struct osd_device *osd,
 		if (rc != -EEXIST)
 			return rc;
 
-		rc = osd_oi_lookup(info, osd, fid, oi_id, 0);
+		rc = osd_oi_lookup(info, osd, fid, oi_id, OI_NO_CACHE);
 		if (rc != 0)
 			return rc;
 
@@ -681,6 +1031,8 @@ update:
 
 	if (unlikely(fid_seq(fid) == FID_SEQ_LOCAL_FILE))
 		rc = osd_obj_spec_insert(info, osd, fid, id, th);
+	else
+		osd_oi_cache_insert(osd, fid, id);
 	return rc;
 }
 
@@ -719,6 +1071,7 @@ int osd_oi_delete(struct osd_thread_info *info,
 	/* clear idmap cache */
 	if (lu_fid_eq(fid, &info->oti_cache.oic_fid))
 		fid_zero(&info->oti_cache.oic_fid);
+	osd_oi_cache_delete(osd, fid);
 
 	if (fid_is_last_id(fid))
 		return 0;
@@ -742,6 +1095,9 @@ int osd_oi_update(struct osd_thread_info *info, struct osd_device *osd,
 	if (unlikely(fid_is_last_id(fid)))
 		return osd_obj_spec_update(info, osd, fid, id, th);
 
+	/* the mapping changes, drop it even if the update fails */
+	osd_oi_cache_delete(osd, fid);
+
 	if (fid_is_on_ost(info, osd, fid, flags) || fid_is_llog(fid))
 		return osd_obj_map_update(info, osd, fid, id, th);
 
@@ -69,6 +69,7 @@ struct lu_site;
 struct dt_device;
 struct osd_device;
 struct osd_oi;
+struct seq_file;
 
 /*
  * Storage cookie. Datum uniquely identifying inode on the underlying file
@@ -89,6 +90,35 @@ struct osd_idmap_cache {
 	struct osd_device	*oic_dev;
 };
 
+/* entry of the FID to inode cache of an OSD, see osd_oi_cache_lookup() */
+struct osd_oi_cache_entry {
+	struct hlist_node	oce_hash;
+	struct list_head	oce_lru;
+	struct lu_fid		oce_fid;
+	struct osd_inode_id	oce_id;
+};
+
+/* the cache is split over the CPU partitions by FID hash */
+struct osd_oi_cache_part {
+	spinlock_t		 ocp_lock;
+	struct hlist_head	*ocp_hash;
+	struct list_head	 ocp_lru;	/* most recently used first */
+	unsigned int		 ocp_count;
+	unsigned int		 ocp_max;
+	/* statistics, protected by ocp_lock */
+	__u64			 ocp_lookups;
+	__u64			 ocp_hits;
+	__u64			 ocp_iam_lookups;
+	__u64			 ocp_iam_blocks;
+};
+
+struct osd_oi_cache {
+	struct osd_oi_cache_part **occ_parts;	/* per-CPT */
+	unsigned int		   occ_hash_bits;
+};
+
+extern struct kmem_cache *osd_oi_cache_kmem;
+
 static inline void osd_id_pack(struct osd_inode_id *tgt,
 			       const struct osd_inode_id *src)
 {
@@ -134,6 +164,8 @@ static inline int osd_id_eq_strict(const struct osd_inode_id *id0,
 enum oi_check_flags {
 	OI_CHECK_FLD	= 0x00000001,
 	OI_KNOWN_ON_OST	= 0x00000002,
+	/* look the mapping up on disk, skipping the FID to inode cache */
+	OI_NO_CACHE	= 0x00000004,
 };
 
 int osd_oi_mod_init(void);
@@ -154,4 +186,10 @@ int  osd_oi_update(struct osd_thread_info *info, struct osd_device *osd,
 
 int fid_is_on_ost(struct osd_thread_info *info, struct osd_device *osd,
 		  const struct lu_fid *fid, enum oi_check_flags flags);
+
+void osd_oi_cache_insert(struct osd_device *osd, const struct lu_fid *fid,
+			 const struct osd_inode_id *id);
+void osd_oi_cache_delete(struct osd_device *osd, const struct lu_fid *fid);
+int osd_oi_cache_dump(struct seq_file *m, struct osd_device *osd);
+void osd_oi_cache_stats_reset(struct osd_device *osd);
 #endif /* _OSD_OI_H */
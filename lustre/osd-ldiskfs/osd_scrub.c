@@ -502,9 +502,9 @@ osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
 	if ((oii != NULL && oii->oii_insert) || (val == SCRUB_NEXT_NOLMA))
 		goto iget;
 
-	rc = osd_oi_lookup(info, dev, fid, lid2,
-		(val == SCRUB_NEXT_OSTOBJ ||
-		 val == SCRUB_NEXT_OSTOBJ_OLD) ? OI_KNOWN_ON_OST : 0);
+	rc = osd_oi_lookup(info, dev, fid, lid2, OI_NO_CACHE |
+		((val == SCRUB_NEXT_OSTOBJ ||
+		  val == SCRUB_NEXT_OSTOBJ_OLD) ? OI_KNOWN_ON_OST : 0));
 	if (rc != 0) {
 		if (rc != -ENOENT && rc != -ESTALE)
 			GOTO(out, rc);
@@ -552,6 +552,8 @@ iget:
 		if (converted)
 			sf->sf_items_updated++;
 
+		/* warm the FID to inode cache with the verified mapping */
+		osd_oi_cache_insert(dev, fid, lid);
 		GOTO(out, rc = 0);
 	} else {
 		if (!scrub->os_partial_scan)
@@ -1746,7 +1748,7 @@ osd_ios_scan_one(struct osd_thread_info *info, struct osd_device *dev,
 		tfid = lma->lma_self_fid;
 	}
 
-	rc = osd_oi_lookup(info, dev, &tfid, id2, 0);
+	rc = osd_oi_lookup(info, dev, &tfid, id2, OI_NO_CACHE);
 	if (rc != 0) {
 		if (rc != -ENOENT)
 			RETURN(rc);
@@ -137,6 +137,29 @@ static int osp_syn_in_prog_seq_show(struct seq_file *m, void *data)
 }
 LPROC_SEQ_FOPS_RO(osp_syn_in_prog);
 
+/**
+ * Show number of object destroys committed by the target since setup
+ *
+ * Sampled periodically it gives the destroy rate, while destroys_in_flight
+ * shows the backlog.
+ *
+ * \param[in] m		seq_file handle
+ * \param[in] data	unused for single entry
+ * \retval		0 on success
+ * \retval		negative number on error
+ */
+static int osp_syn_destroys_seq_show(struct seq_file *m, void *data)
+{
+	struct obd_device	*dev = m->private;
+	struct osp_device	*osp = lu2osp_dev(dev->obd_lu_dev);
+
+	if (osp == NULL)
+		return -EINVAL;
+
+	return seq_printf(m, "%lu\n", osp->opd_syn_destroys);
+}
+LPROC_SEQ_FOPS_RO(osp_syn_destroys);
+
 /**
  * Show number of changes to sync
  *
@@ -355,7 +378,7 @@ osp_create_count_seq_write(struct file *file, const char *buffer,
 
 	for (i = 1; (i << 1) <= val; i <<= 1)
 		;
-	osp->opd_pre_grow_count = i;
+	osp->opd_pre_grow_count = max(i, osp->opd_pre_min_grow_count);
 
 	return count;
 }
@@ -411,6 +434,11 @@ osp_max_create_count_seq_write(struct file *file, const char *buffer,
 	if (val > OST_MAX_PRECREATE)
 		return -ERANGE;
 
+	/* 0 disables precreation, otherwise the window must keep the
+	 * reserved minimum, min_create_count is to be lowered first */
+	if (val != 0 && osp->opd_pre_min_grow_count > val / 2)
+		return -ERANGE;
+
 	if (osp->opd_pre_grow_count > val)
 		osp->opd_pre_grow_count = val;
 
@@ -420,6 +448,74 @@ osp_max_create_count_seq_write(struct file *file, const char *buffer,
 }
 LPROC_SEQ_FOPS(osp_max_create_count);
 
+/**
+ * Show minimum number of objects to precreate
+ *
+ * \param[in] m		seq_file handle
+ * \param[in] data	unused for single entry
+ * \retval		0 on success
+ * \retval		negative number on error
+ */
+static int osp_min_create_count_seq_show(struct seq_file *m, void *data)
+{
+	struct obd_device *obd = m->private;
+	struct osp_device *osp = lu2osp_dev(obd->obd_lu_dev);
+
+	if (osp == NULL || osp->opd_pre == NULL)
+		return 0;
+
+	return seq_printf(m, "%d\n", osp->opd_pre_min_grow_count);
+}
+
+/**
+ * Change minimum number of objects to precreate
+ *
+ * The precreate window is never shrunk below this number, and the
+ * precreate thread refills the pool as soon as less than half of it is
+ * left. A large value makes the MDT keep a large range of objects ready
+ * on the OST, so bursts of file creates don't wait for precreate RPCs.
+ * It can't exceed half of max_create_count because a precreate RPC never
+ * asks for more than that.
+ *
+ * \param[in] file	proc file
+ * \param[in] buffer	string which represents minimum number
+ * \param[in] count	\a buffer length
+ * \param[in] off	unused for single entry
+ * \retval		\a count on success
+ * \retval		negative number on error
+ */
+static ssize_t
+osp_min_create_count_seq_write(struct file *file, const char *buffer,
+			       size_t count, loff_t *off)
+{
+	struct seq_file		*m = file->private_data;
+	struct obd_device	*obd = m->private;
+	struct osp_device	*osp = lu2osp_dev(obd->obd_lu_dev);
+	int			 val, rc;
+
+	if (osp == NULL || osp->opd_pre == NULL)
+		return 0;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < OST_MIN_PRECREATE || val > osp->opd_pre_max_grow_count / 2)
+		return -ERANGE;
+
+	spin_lock(&osp->opd_pre_lock);
+	osp->opd_pre_min_grow_count = val;
+	if (osp->opd_pre_grow_count < val)
+		osp->opd_pre_grow_count = val;
+	spin_unlock(&osp->opd_pre_lock);
+
+	/* let the precreate thread fill the new window */
+	wake_up(&osp->opd_pre_waitq);
+
+	return count;
+}
+LPROC_SEQ_FOPS(osp_min_create_count);
+
 /**
  * Show last id to assign in creation
  *
@@ -640,10 +736,68 @@ static int osp_old_sync_processed_seq_show(struct seq_file *m, void *data)
 	if (osp == NULL)
 		return -EINVAL;
 
-	return seq_printf(m, "%d\n", osp->opd_syn_prev_done);
+	return seq_printf(m, "%d\n", osp->opd_syn_prev_done &&
+			  !osp->opd_syn_prev_failed &&
+			  osp_sync_helpers_busy(osp) == 0);
 }
 LPROC_SEQ_FOPS_RO(osp_old_sync_processed);
 
+/**
+ * Show number of threads sending changes, the sync thread included
+ *
+ * \param[in] m		seq_file handle
+ * \param[in] data	unused for single entry
+ * \retval		0 on success
+ * \retval		negative number on error
+ */
+static int osp_syn_threads_seq_show(struct seq_file *m, void *data)
+{
+	struct obd_device	*dev = m->private;
+	struct osp_device	*osp = lu2osp_dev(dev->obd_lu_dev);
+
+	if (osp == NULL)
+		return -EINVAL;
+
+	return seq_printf(m, "%d\n", osp->opd_syn_threads);
+}
+
+/**
+ * Change number of threads sending changes, the sync thread included
+ *
+ * \param[in] file	proc file
+ * \param[in] buffer	string which represents number of threads
+ * \param[in] count	\a buffer length
+ * \param[in] off	unused for single entry
+ * \retval		\a count on success
+ * \retval		negative number on error
+ */
+static ssize_t
+osp_syn_threads_seq_write(struct file *file, const char *buffer,
+			  size_t count, loff_t *off)
+{
+	struct seq_file		*m = file->private_data;
+	struct obd_device	*dev = m->private;
+	struct osp_device	*osp = lu2osp_dev(dev->obd_lu_dev);
+	int			 val, rc;
+
+	if (osp == NULL)
+		return -EINVAL;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < 1 || val > OSP_SYNC_THREADS_MAX)
+		return -ERANGE;
+
+	rc = osp_sync_threads_set(osp, val);
+	if (rc)
+		return rc;
+
+	return count;
+}
+LPROC_SEQ_FOPS(osp_syn_threads);
+
 /**
  * Show maximum number of RPCs in flight
  *
@@ -739,6 +893,8 @@ static struct lprocfs_vars lprocfs_osp_obd_vars[] = {
 	  .fops =	&osp_create_count_fops		},
 	{ .name =	"max_create_count",
 	  .fops =	&osp_max_create_count_fops	},
+	{ .name =	"min_create_count",
+	  .fops =	&osp_min_create_count_fops	},
 	{ .name =	"prealloc_next_id",
 	  .fops =	&osp_prealloc_next_id_fops	},
 	{ .name =	"prealloc_next_seq",
@@ -765,6 +921,10 @@ static struct lprocfs_vars lprocfs_osp_obd_vars[] = {
 	  .fops =	&osp_syn_in_flight_fops		},
 	{ .name =	"sync_in_progress",
 	  .fops =	&osp_syn_in_prog_fops		},
+	{ .name =	"sync_destroys",
+	  .fops =	&osp_syn_destroys_fops		},
+	{ .name =	"sync_threads",
+	  .fops =	&osp_syn_threads_fops		},
 	{ .name =	"old_sync_processed",
 	  .fops =	&osp_old_sync_processed_fops	},
 
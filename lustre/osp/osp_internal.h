@@ -85,6 +85,8 @@ struct osp_precreate {
 	int				 osp_pre_status;
 	/* how many to precreate next time */
 	int				 osp_pre_grow_count;
+	/* the window is never shrunk below this, so a burst of creates
+	 * finds objects already precreated instead of waiting for the OST */
 	int				 osp_pre_min_grow_count;
 	int				 osp_pre_max_grow_count;
 	/* whether to grow precreation window next time or not */
@@ -93,6 +95,47 @@ struct osp_precreate {
 	int				 osp_pre_recovering;
 };
 
+/* max number of llog records of a plain llog cancelled with one update of
+ * its header, see osp_sync_process_committed() */
+#define OSP_SYN_CANCEL_BATCH	64
+
+/* max number of threads sending the changes, the sync thread included */
+#define OSP_SYNC_THREADS_MAX	16
+
+/*
+ * Helper of the sync thread: an additional cursor sending its share of the
+ * changes of a plain llog written before the current boot, or of the changes
+ * of this boot the sync thread queues to it
+ */
+struct osp_sync_helper {
+	struct osp_device	*osh_dev;
+	/* plain llog to process, NULL if idle */
+	struct llog_handle	*osh_llh;
+	/* plain llog it failed to process, its share is left to the sync
+	 * thread */
+	struct llog_handle	*osh_failed_llh;
+	int			 osh_index;
+	/* share of the changes of osh_llh it sends */
+	int			 osh_cursor;
+	/* index of the last record of its share sent */
+	int			 osh_last_idx;
+	/* changes of this boot queued by the sync thread, and the share of
+	 * them it sends, see osp_sync_dispatch() */
+	struct list_head	 osh_queue;
+	int			 osh_live_cursor;
+	/* ready to take a llog */
+	unsigned int		 osh_ready:1,
+	/* thread started, and not done yet */
+				 osh_started:1;
+};
+
+/* change of this boot queued to a helper, with a copy of its record */
+struct osp_sync_qrec {
+	struct list_head	 oqr_list;
+	struct llog_handle	*oqr_llh;
+	struct llog_rec_hdr	 oqr_rec;
+};
+
 struct osp_device {
 	struct dt_device		 opd_dt_dev;
 	/* corresponded OST index */
@@ -177,6 +220,32 @@ struct osp_device {
 	/* stop processing new requests until barrier=0 */
 	atomic_t			 opd_syn_barrier;
 	wait_queue_head_t		 opd_syn_barrier_waitq;
+	/* helpers sending the changes in parallel with the sync thread */
+	struct osp_sync_helper		*opd_syn_helpers;
+	int				 opd_syn_helper_count;
+	atomic_t			 opd_syn_helpers_running;
+	/* threads sending the changes, the sync thread included */
+	int				 opd_syn_threads;
+	/* bumped when a helper becomes ready or leaves, or
+	 * opd_syn_threads changes */
+	int				 opd_syn_helpers_gen;
+	/* opd_syn_helpers_gen the changes of this boot are spread for,
+	 * and number of cursors they are spread among */
+	int				 opd_syn_live_gen;
+	int				 opd_syn_live_cursors;
+	/* helper whose share the sync thread is sending */
+	struct osp_sync_helper		*opd_syn_takeover;
+	/* changes of the previous boots were left in the llog */
+	int				 opd_syn_prev_failed;
+	/* plain llog holding the generation record of this boot */
+	struct llog_logid		 opd_syn_gen_lgl;
+	/* plain llog processed by the sync thread and number of cursors */
+	struct llog_logid		 opd_syn_cur_lgl;
+	int				 opd_syn_cursors;
+	/* llog indices of committed changes, cancelled together */
+	int				 opd_syn_cancel_idx[OSP_SYN_CANCEL_BATCH];
+	/* number of destroys committed by the target */
+	unsigned long			 opd_syn_destroys;
 
 	/*
 	 * statfs related fields: OSP maintains it on its own
@@ -596,6 +665,8 @@ int osp_sync_add(const struct lu_env *env, struct osp_object *o,
 		 const struct lu_attr *attr);
 int osp_sync_init(const struct lu_env *env, struct osp_device *d);
 int osp_sync_fini(struct osp_device *d);
+int osp_sync_helpers_busy(struct osp_device *d);
+int osp_sync_threads_set(struct osp_device *d, int threads);
 void __osp_sync_check_for_work(struct osp_device *d);
 
 /* lwp_dev.c */
@@ -633,7 +633,8 @@ static int osp_precreate_send(const struct lu_env *env, struct osp_device *d)
 	if (diff < grow) {
 		/* the OST has not managed to create all the
 		 * objects we asked for */
-		d->opd_pre_grow_count = max(diff, OST_MIN_PRECREATE);
+		d->opd_pre_grow_count = max(diff,
+					    d->opd_pre_min_grow_count);
 		d->opd_pre_grow_slow = 1;
 	} else {
 		/* the OST is able to keep up with the work,
@@ -861,10 +862,10 @@ static int osp_precreate_cleanup_orphans(struct lu_env *env,
 	spin_lock(&d->opd_pre_lock);
 	diff = osp_fid_diff(&d->opd_last_used_fid, last_fid);
 	if (diff > 0) {
-		d->opd_pre_grow_count = OST_MIN_PRECREATE + diff;
+		d->opd_pre_grow_count = d->opd_pre_min_grow_count + diff;
 		d->opd_pre_last_created_fid = d->opd_last_used_fid;
 	} else {
-		d->opd_pre_grow_count = OST_MIN_PRECREATE;
+		d->opd_pre_grow_count = d->opd_pre_min_grow_count;
 		d->opd_pre_last_created_fid = *last_fid;
 	}
 	/*
@@ -971,7 +972,7 @@ void osp_pre_update_status(struct osp_device *d, int rc)
 			d->opd_pre_status = 0;
 			spin_lock(&d->opd_pre_lock);
 			d->opd_pre_grow_slow = 0;
-			d->opd_pre_grow_count = OST_MIN_PRECREATE;
+			d->opd_pre_grow_count = d->opd_pre_min_grow_count;
 			spin_unlock(&d->opd_pre_lock);
 			wake_up(&d->opd_pre_waitq);
 			CDEBUG(D_INFO, "%s: no space: "LPU64" blocks, "LPU64
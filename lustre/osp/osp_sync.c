@@ -83,6 +83,16 @@ static void osp_sync_remove_from_tracker(struct osp_device *d);
  *
  * opd_syn_rpc_in_flight is a number of RPC in flight.
  * we control this with OSP_MAX_IN_FLIGHT
+ *
+ * the changes are sent by up to opd_syn_threads cursors, each one sending
+ * the changes of its share of the objects, so that the changes of an object
+ * are still sent in order. the sync thread and its helpers read the same
+ * plain llog written before the current boot, see osp_sync_handoff(). the
+ * changes of this boot are read by the sync thread alone as they commit,
+ * which queues the shares of the helpers to them, see osp_sync_dispatch().
+ * all the cursors share the limits above; only the sync thread cancels llog
+ * records. a helper which fails on an old llog leaves the rest of its share
+ * to the sync thread, see osp_sync_helpers_takeover().
  */
 
 /* XXX: do math to learn reasonable threshold
@@ -94,6 +104,16 @@ static void osp_sync_remove_from_tracker(struct osp_device *d);
 
 #define OSP_JOB_MAGIC		0x26112005
 
+static int osp_sync_threads = 4;
+CFS_MODULE_PARM(osp_sync_threads, "i", int, 0444,
+		"default number of threads sending the changes to each "
+		"target (at most 16), see osp.*.sync_threads");
+
+static int osp_sync_process_queues(const struct lu_env *env,
+				   struct llog_handle *llh,
+				   struct llog_rec_hdr *rec,
+				   void *data);
+
 struct osp_job_req_args {
 	/** bytes reserved for ptlrpc_replay_req() */
 	struct ptlrpc_replay_async_args	jra_raa;
@@ -844,6 +864,104 @@ static int osp_sync_new_unlink64_job(const struct lu_env *env,
 	RETURN(1);
 }
 
+/**
+ * Reserve room for the RPC of a change.
+ *
+ * The counters are incremented before the RPC is sent, to be consistent in
+ * the RPC interpret callback which may happen very quickly. Helpers may have
+ * taken the room seen by the caller.
+ *
+ * \param[in] d		OSP device
+ *
+ * \retval 0		on success
+ * \retval -EAGAIN	no room for another RPC, try again later
+ */
+static int osp_sync_reserve(struct osp_device *d)
+{
+	spin_lock(&d->opd_syn_lock);
+	if (!osp_sync_low_in_flight(d) || !osp_sync_low_in_progress(d)) {
+		spin_unlock(&d->opd_syn_lock);
+		return -EAGAIN;
+	}
+	d->opd_syn_rpc_in_flight++;
+	d->opd_syn_rpc_in_progress++;
+	spin_unlock(&d->opd_syn_lock);
+
+	return 0;
+}
+
+static void osp_sync_unreserve(struct osp_device *d)
+{
+	spin_lock(&d->opd_syn_lock);
+	d->opd_syn_rpc_in_flight--;
+	d->opd_syn_rpc_in_progress--;
+	spin_unlock(&d->opd_syn_lock);
+}
+
+/**
+ * Account a change of this boot taken from the llog.
+ *
+ * Called with opd_syn_lock held.
+ *
+ * \param[in] d		OSP device
+ * \param[in] rec	llog record of the change
+ */
+static void osp_sync_processed_locked(struct osp_device *d,
+				      struct llog_rec_hdr *rec)
+{
+	LASSERT(d->opd_syn_changes > 0);
+	LASSERT(rec->lrh_id <= d->opd_syn_last_committed_id);
+	/*
+	 * NOTE: it's possible to meet same id if
+	 * OST stores few stripes of same file
+	 */
+	if (rec->lrh_id > d->opd_syn_last_processed_id) {
+		d->opd_syn_last_processed_id = rec->lrh_id;
+		wake_up(&d->opd_syn_barrier_waitq);
+	}
+
+	d->opd_syn_changes--;
+}
+
+/**
+ * Send the RPC of a change, the room for it being reserved.
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] d		OSP device
+ * \param[in] llh	llog handle where the record is stored
+ * \param[in] rec	llog record
+ *
+ * \retval 1		the RPC is sent
+ * \retval 0		the record is skipped
+ * \retval negative	negated errno on error
+ */
+static int osp_sync_send_record(const struct lu_env *env,
+				struct osp_device *d,
+				struct llog_handle *llh,
+				struct llog_rec_hdr *rec)
+{
+	int rc = 0;
+
+	switch (rec->lrh_type) {
+	/* case MDS_UNLINK_REC is kept for compatibility */
+	case MDS_UNLINK_REC:
+		rc = osp_sync_new_unlink_job(d, llh, rec);
+		break;
+	case MDS_UNLINK64_REC:
+		rc = osp_sync_new_unlink64_job(env, d, llh, rec);
+		break;
+	case MDS_SETATTR64_REC:
+		rc = osp_sync_new_setattr_job(d, llh, rec);
+		break;
+	default:
+		CERROR("%s: unknown record type: %x\n", d->opd_obd->obd_name,
+		       rec->lrh_type);
+		/* we should continue processing */
+	}
+
+	return rc;
+}
+
 /**
  * Process llog records.
  *
@@ -861,6 +979,7 @@ static int osp_sync_new_unlink64_job(const struct lu_env *env,
  * \param[in] rec	llog record
  *
  * \retval 0		on success
+ * \retval -EAGAIN	no room for another RPC, try again later
  * \retval negative	negated errno on error
  */
 static int osp_sync_process_record(const struct lu_env *env,
@@ -884,6 +1003,8 @@ static int osp_sync_process_record(const struct lu_env *env,
 			    sizeof(gen->lgr_gen))) {
 			CDEBUG(D_HA, "processed all old entries\n");
 			d->opd_syn_prev_done = 1;
+			/* the helpers only get queued changes from now on */
+			wake_up(&d->opd_syn_waitq);
 		}
 
 		/* cancel any generation record */
@@ -897,58 +1018,24 @@ static int osp_sync_process_record(const struct lu_env *env,
 	 * now we prepare and fill requests to OST, put them on the queue
 	 * and fire after next commit callback
 	 */
+	rc = osp_sync_reserve(d);
+	if (rc != 0)
+		return rc;
 
-	/* notice we increment counters before sending RPC, to be consistent
-	 * in RPC interpret callback which may happen very quickly */
-	spin_lock(&d->opd_syn_lock);
-	d->opd_syn_rpc_in_flight++;
-	d->opd_syn_rpc_in_progress++;
-	spin_unlock(&d->opd_syn_lock);
-
-	switch (rec->lrh_type) {
-	/* case MDS_UNLINK_REC is kept for compatibility */
-	case MDS_UNLINK_REC:
-		rc = osp_sync_new_unlink_job(d, llh, rec);
-		break;
-	case MDS_UNLINK64_REC:
-		rc = osp_sync_new_unlink64_job(env, d, llh, rec);
-		break;
-	case MDS_SETATTR64_REC:
-		rc = osp_sync_new_setattr_job(d, llh, rec);
-		break;
-	default:
-		CERROR("%s: unknown record type: %x\n", d->opd_obd->obd_name,
-		       rec->lrh_type);
-		/* we should continue processing */
-	}
+	rc = osp_sync_send_record(env, d, llh, rec);
 
 	/* rc > 0 means sync RPC being added to the queue */
 	if (likely(rc > 0)) {
 		spin_lock(&d->opd_syn_lock);
-		if (d->opd_syn_prev_done) {
-			LASSERT(d->opd_syn_changes > 0);
-			LASSERT(rec->lrh_id <= d->opd_syn_last_committed_id);
-			/*
-			 * NOTE: it's possible to meet same id if
-			 * OST stores few stripes of same file
-			 */
-			if (rec->lrh_id > d->opd_syn_last_processed_id) {
-				d->opd_syn_last_processed_id = rec->lrh_id;
-				wake_up(&d->opd_syn_barrier_waitq);
-			}
-
-			d->opd_syn_changes--;
-		}
+		if (d->opd_syn_prev_done)
+			osp_sync_processed_locked(d, rec);
 		CDEBUG(D_OTHER, "%s: %d in flight, %d in progress\n",
 		       d->opd_obd->obd_name, d->opd_syn_rpc_in_flight,
 		       d->opd_syn_rpc_in_progress);
 		spin_unlock(&d->opd_syn_lock);
 		rc = 0;
 	} else {
-		spin_lock(&d->opd_syn_lock);
-		d->opd_syn_rpc_in_flight--;
-		d->opd_syn_rpc_in_progress--;
-		spin_unlock(&d->opd_syn_lock);
+		osp_sync_unreserve(d);
 	}
 
 	CDEBUG(D_HA, "found record %x, %d, idx %u, id %u: %d\n",
@@ -956,12 +1043,36 @@ static int osp_sync_process_record(const struct lu_env *env,
 	return rc;
 }
 
+/**
+ * Cancel a batch of llog records of the same plain llog.
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] d		OSP device
+ * \param[in] llh	catalog handle
+ * \param[in] lgid	plain llog holding the records
+ * \param[in] nr	number of records in d->opd_syn_cancel_idx
+ */
+static void osp_sync_cancel_batch(const struct lu_env *env,
+				  struct osp_device *d,
+				  struct llog_handle *llh,
+				  struct llog_logid *lgid, int nr)
+{
+	int rc;
+
+	rc = llog_cat_cancel_arr_rec(env, llh, lgid, nr,
+				     d->opd_syn_cancel_idx);
+	if (rc < 0 && rc != -ENOENT)
+		CERROR("%s: can't cancel %d records: rc = %d\n",
+		       d->opd_obd->obd_name, nr, rc);
+}
+
 /**
  * Cancel llog records for the committed changes.
  *
  * The function walks through the list of the committed RPCs and cancels
  * corresponding llog records. see osp_sync_request_commit_cb() for the
- * details.
+ * details. The records are cancelled in batches per plain llog, so that its
+ * header is written once for up to OSP_SYN_CANCEL_BATCH of them.
  *
  * \param[in] env	LU environment provided by the caller
  * \param[in] d		OSP device
@@ -975,8 +1086,9 @@ static void osp_sync_process_committed(const struct lu_env *env,
 	struct ptlrpc_request	*req;
 	struct llog_ctxt	*ctxt;
 	struct llog_handle	*llh;
+	struct llog_logid	 lgid;
 	struct list_head	 list;
-	int			 rc, done = 0;
+	int			 done = 0, destroys = 0, nr = 0;
 
 	ENTRY;
 
@@ -995,8 +1107,6 @@ static void osp_sync_process_committed(const struct lu_env *env,
 
 	/*
 	 * now cancel them all
-	 * XXX: can we improve this using some batching?
-	 *      with batch RPC that'll happen automatically?
 	 * XXX: can we store ctxt in lod_device and save few cycles ?
 	 */
 	ctxt = llog_get_context(obd, LLOG_MDS_OST_ORIG_CTXT);
@@ -1005,6 +1115,7 @@ static void osp_sync_process_committed(const struct lu_env *env,
 	llh = ctxt->loc_handle;
 	LASSERT(llh);
 
+	memset(&lgid, 0, sizeof(lgid));
 	INIT_LIST_HEAD(&list);
 	spin_lock(&d->opd_syn_lock);
 	list_splice(&d->opd_syn_committed_there, &list);
@@ -1045,10 +1156,19 @@ static void osp_sync_process_committed(const struct lu_env *env,
 		/* import can be closing, thus all commit cb's are
 		 * called we can check committness directly */
 		if (req->rq_transno <= imp->imp_peer_committed_transno) {
-			rc = llog_cat_cancel_records(env, llh, 1, lcookie);
-			if (rc)
-				CERROR("%s: can't cancel record: %d\n",
-				       obd->obd_name, rc);
+			if (nr > 0 && (nr == OSP_SYN_CANCEL_BATCH ||
+				       memcmp(&lgid, &lcookie->lgc_lgl,
+					      sizeof(lgid)) != 0)) {
+				osp_sync_cancel_batch(env, d, llh, &lgid, nr);
+				nr = 0;
+			}
+			if (nr == 0)
+				lgid = lcookie->lgc_lgl;
+			d->opd_syn_cancel_idx[nr++] = lcookie->lgc_index;
+
+			if (d->opd_connect_mdt ||
+			    lustre_msg_get_opc(req->rq_reqmsg) == OST_DESTROY)
+				destroys++;
 		} else {
 			DEBUG_REQ(D_HA, req, "not committed");
 		}
@@ -1057,11 +1177,15 @@ static void osp_sync_process_committed(const struct lu_env *env,
 		done++;
 	}
 
+	if (nr > 0)
+		osp_sync_cancel_batch(env, d, llh, &lgid, nr);
+
 	llog_ctxt_put(ctxt);
 
 	LASSERT(d->opd_syn_rpc_in_progress >= done);
 	spin_lock(&d->opd_syn_lock);
 	d->opd_syn_rpc_in_progress -= done;
+	d->opd_syn_destroys += destroys;
 	spin_unlock(&d->opd_syn_lock);
 	CDEBUG(D_OTHER, "%s: %d in flight, %d in progress\n",
 	       d->opd_obd->obd_name, d->opd_syn_rpc_in_flight,
@@ -1077,6 +1201,617 @@ static void osp_sync_process_committed(const struct lu_env *env,
 	EXIT;
 }
 
+/**
+ * Check whether a helper is over the number of threads asked for.
+ *
+ * Such a helper takes no more work, and stops once it sent what it has.
+ *
+ * \param[in] h		helper
+ *
+ * \retval true		the helper should stop
+ * \retval false	the helper is in use
+ */
+static inline bool osp_sync_helper_stopping(struct osp_sync_helper *h)
+{
+	return h->osh_index >= h->osh_dev->opd_syn_threads - 1;
+}
+
+/**
+ * Count the helpers processing a plain llog.
+ *
+ * \param[in] d		OSP device
+ *
+ * \retval		number of busy helpers
+ */
+int osp_sync_helpers_busy(struct osp_device *d)
+{
+	int i, busy = 0;
+
+	spin_lock(&d->opd_syn_lock);
+	for (i = 0; i < d->opd_syn_helper_count; i++)
+		if (d->opd_syn_helpers[i].osh_llh != NULL)
+			busy++;
+	spin_unlock(&d->opd_syn_lock);
+
+	return busy;
+}
+
+/**
+ * Find the cursor sending a change.
+ *
+ * The changes are spread among the cursors by object, records other than
+ * changes go to the sync thread.
+ *
+ * \param[in] rec	llog record
+ * \param[in] cursors	number of cursors processing the plain llog
+ *
+ * \retval		cursor index, 0 for the sync thread
+ */
+static int osp_sync_rec_cursor(struct llog_rec_hdr *rec, int cursors)
+{
+	struct ost_id	oi;
+	__u32		key;
+
+	switch (rec->lrh_type) {
+	case MDS_UNLINK_REC:
+		key = ((struct llog_unlink_rec *)rec)->lur_oid;
+		break;
+	case MDS_UNLINK64_REC:
+		if (fid_to_ostid(&((struct llog_unlink64_rec *)rec)->lur_fid,
+				 &oi) < 0)
+			return 0;
+		key = ostid_id(&oi);
+		break;
+	case MDS_SETATTR64_REC:
+		key = ostid_id(&((struct llog_setattr64_rec *)rec)->lsr_oi);
+		break;
+	default:
+		return 0;
+	}
+
+	return key % cursors;
+}
+
+/**
+ * Wait until the helpers are done with the current plain llog.
+ *
+ * The RPCs they send are committed meanwhile, to make room for them.
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] d		OSP device
+ */
+static void osp_sync_helpers_wait(const struct lu_env *env,
+				  struct osp_device *d)
+{
+	struct l_wait_info lwi = { 0 };
+
+	while (osp_sync_helpers_busy(d) > 0 && osp_sync_running(d)) {
+		osp_sync_process_committed(env, d);
+		l_wait_event(d->opd_syn_waitq,
+			     !osp_sync_running(d) ||
+			     osp_sync_helpers_busy(d) == 0 ||
+			     !list_empty(&d->opd_syn_committed_there),
+			     &lwi);
+	}
+}
+
+/**
+ * Send a change of the share of a failed helper.
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] llh	llog handle we're processing
+ * \param[in] rec	current llog record
+ * \param[in] data	the failed helper
+ *
+ * \retval 0			to ask the caller (llog_process()) to continue
+ * \retval LLOG_PROC_BREAK	to ask the caller to break
+ */
+static int osp_sync_takeover_process(const struct lu_env *env,
+				     struct llog_handle *llh,
+				     struct llog_rec_hdr *rec,
+				     void *data)
+{
+	struct osp_sync_helper	*h = data;
+	struct osp_device	*d = h->osh_dev;
+
+	if (osp_sync_rec_cursor(rec, d->opd_syn_cursors) != h->osh_cursor)
+		return 0;
+
+	return osp_sync_process_queues(env, llh, rec, d);
+}
+
+/**
+ * Send the changes the failed helpers left in the current plain llog.
+ *
+ * Called by the sync thread once the helpers are done with the llog, so
+ * that all the changes of the llog are sent before the ones of the next
+ * llog. A failed helper stops at the first change it can't send, the sync
+ * thread resumes its share after the last change the helper sent. If the
+ * sync thread fails too, the changes stay in the llog for the next boot.
+ * When the sync thread stops, the llogs are just released.
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] d		OSP device
+ */
+static void osp_sync_helpers_takeover(const struct lu_env *env,
+				      struct osp_device *d)
+{
+	struct llog_process_cat_data	 cd = { 0 };
+	struct osp_sync_helper		*h;
+	struct llog_handle		*llh;
+	int				 count, i, rc;
+
+	spin_lock(&d->opd_syn_lock);
+	count = d->opd_syn_helper_count;
+	spin_unlock(&d->opd_syn_lock);
+
+	for (i = 0; i < count; i++) {
+		h = &d->opd_syn_helpers[i];
+		spin_lock(&d->opd_syn_lock);
+		llh = h->osh_failed_llh;
+		h->osh_failed_llh = NULL;
+		spin_unlock(&d->opd_syn_lock);
+		if (llh == NULL)
+			continue;
+
+		if (osp_sync_running(d)) {
+			CDEBUG(D_HA, "%s: sending the share of helper %d of "
+			       "llog "DOSTID" from index %d\n",
+			       d->opd_obd->obd_name, h->osh_index,
+			       POSTID(&llh->lgh_id.lgl_oi), h->osh_last_idx);
+
+			cd.lpcd_first_idx = h->osh_last_idx;
+			cd.lpcd_last_idx = 0;
+			d->opd_syn_takeover = h;
+			rc = llog_process_or_fork(env, llh,
+						  osp_sync_takeover_process,
+						  h, &cd, false);
+			d->opd_syn_takeover = NULL;
+			if (rc < 0) {
+				CERROR("%s: can't send the share of helper %d "
+				       "of llog "DOSTID": rc = %d\n",
+				       d->opd_obd->obd_name, h->osh_index,
+				       POSTID(&llh->lgh_id.lgl_oi), rc);
+				d->opd_syn_prev_failed = 1;
+			}
+		}
+		llog_handle_put(llh);
+	}
+}
+
+/**
+ * Share the records of a plain llog of the previous boots with the helpers.
+ *
+ * Called by the sync thread for each record read. On the first record of a
+ * plain llog written before the generation record of this boot, the idle
+ * helpers start to process the same llog as additional cursors. Each cursor
+ * sends the changes of its share of the objects, so the changes of an object
+ * are sent in order. The sync thread starts on the next llog once the
+ * helpers are done, and does the llog of this boot alone.
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] d		OSP device
+ * \param[in] llh	plain llog of the record
+ * \param[in] rec	llog record
+ *
+ * \retval true		the record is sent by a helper
+ * \retval false	the record is sent by the sync thread
+ */
+static bool osp_sync_handoff(const struct lu_env *env, struct osp_device *d,
+			     struct llog_handle *llh, struct llog_rec_hdr *rec)
+{
+	struct osp_sync_helper	*h;
+	int			 count, i;
+
+	/* the share of a failed helper is sent by the sync thread */
+	if (d->opd_syn_prev_done || d->opd_syn_takeover != NULL)
+		return false;
+
+	spin_lock(&d->opd_syn_lock);
+	count = d->opd_syn_helper_count;
+	spin_unlock(&d->opd_syn_lock);
+	if (count == 0)
+		return false;
+
+	if (memcmp(&llh->lgh_id, &d->opd_syn_cur_lgl, sizeof(llh->lgh_id))) {
+		/* the helpers must be done with the previous llog */
+		osp_sync_helpers_wait(env, d);
+		osp_sync_helpers_takeover(env, d);
+		if (!osp_sync_running(d))
+			return false;
+
+		d->opd_syn_cur_lgl = llh->lgh_id;
+		d->opd_syn_cursors = 1;
+
+		/* records of this boot follow the generation record */
+		if (!memcmp(&llh->lgh_id, &d->opd_syn_gen_lgl,
+			    sizeof(llh->lgh_id)))
+			return false;
+
+		spin_lock(&d->opd_syn_lock);
+		for (i = 0; i < count; i++) {
+			h = &d->opd_syn_helpers[i];
+			if (!h->osh_ready || osp_sync_helper_stopping(h))
+				continue;
+			llog_handle_get(llh);
+			h->osh_llh = llh;
+			h->osh_cursor = d->opd_syn_cursors++;
+			h->osh_last_idx = 0;
+		}
+		spin_unlock(&d->opd_syn_lock);
+
+		CDEBUG(D_HA, "%s: llog "DOSTID" is processed by %d cursors\n",
+		       d->opd_obd->obd_name, POSTID(&llh->lgh_id.lgl_oi),
+		       d->opd_syn_cursors);
+		wake_up(&d->opd_syn_waitq);
+	}
+
+	return osp_sync_rec_cursor(rec, d->opd_syn_cursors) != 0;
+}
+
+/**
+ * Check whether a helper can send another RPC.
+ *
+ * \param[in] d		OSP device
+ *
+ * \retval 1		there is room
+ * \retval 0		not now
+ */
+static inline int osp_sync_helper_can_send(struct osp_device *d)
+{
+	return atomic_read(&d->opd_syn_barrier) == 0 &&
+	       osp_sync_low_in_progress(d) && osp_sync_low_in_flight(d) &&
+	       d->opd_imp_connected;
+}
+
+/**
+ * Send the change of a llog record of a previous boot.
+ *
+ * Called by llog_process() for the records of the plain llog shared with a
+ * helper, the changes of the other cursors are skipped. Such records are
+ * committed locally, so they are only subject to the flow control. The
+ * committed RPCs are handled by the sync thread. On any other error the
+ * helper stops and leaves the rest of its share to the sync thread, which
+ * waits for the conditions to change before it tries again, see
+ * osp_sync_helpers_takeover().
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] llh	llog handle we're processing
+ * \param[in] rec	current llog record
+ * \param[in] data	the helper
+ *
+ * \retval 0			to ask the caller (llog_process()) to continue
+ * \retval LLOG_PROC_BREAK	to ask the caller to break
+ * \retval negative		the change can't be sent
+ */
+static int osp_sync_helper_process(const struct lu_env *env,
+				   struct llog_handle *llh,
+				   struct llog_rec_hdr *rec,
+				   void *data)
+{
+	struct osp_sync_helper	*h = data;
+	struct osp_device	*d = h->osh_dev;
+	struct l_wait_info	 lwi = { 0 };
+	int			 rc;
+
+	if (osp_sync_rec_cursor(rec, d->opd_syn_cursors) != h->osh_cursor)
+		return 0;
+
+	do {
+		l_wait_event(d->opd_syn_waitq,
+			     !osp_sync_running(d) ||
+			     osp_sync_helper_can_send(d), &lwi);
+		if (!osp_sync_running(d))
+			return LLOG_PROC_BREAK;
+
+		rc = osp_sync_process_record(env, d, llh, rec);
+	} while (rc == -EAGAIN);
+
+	if (rc != 0) {
+		CERROR("%s: helper %d can't send, leaving its share to the "
+		       "sync thread: rc = %d\n",
+		       d->opd_obd->obd_name, h->osh_index, rc);
+		return rc;
+	}
+
+	h->osh_last_idx = rec->lrh_index;
+	return 0;
+}
+
+/**
+ * Check whether changes queued to the helpers are still to be sent.
+ *
+ * \param[in] d		OSP device
+ *
+ * \retval true		some changes are queued
+ * \retval false	the queues are empty
+ */
+static bool osp_sync_helpers_queued(struct osp_device *d)
+{
+	bool	queued = false;
+	int	i;
+
+	spin_lock(&d->opd_syn_lock);
+	for (i = 0; i < d->opd_syn_helper_count && !queued; i++)
+		queued = !list_empty(&d->opd_syn_helpers[i].osh_queue);
+	spin_unlock(&d->opd_syn_lock);
+
+	return queued;
+}
+
+/**
+ * Spread the changes of this boot among the helpers available now.
+ *
+ * The changes already queued are sent first, so that the changes of an
+ * object are still sent in order once it moves to another cursor. The RPCs
+ * they send are committed meanwhile, to make room for them.
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] d		OSP device
+ */
+static void osp_sync_respread(const struct lu_env *env, struct osp_device *d)
+{
+	struct l_wait_info	 lwi = { 0 };
+	struct osp_sync_helper	*h;
+	int			 cursors = 1;
+	int			 i;
+
+	while (osp_sync_helpers_queued(d) && osp_sync_running(d)) {
+		osp_sync_process_committed(env, d);
+		l_wait_event(d->opd_syn_waitq,
+			     !osp_sync_running(d) ||
+			     !osp_sync_helpers_queued(d) ||
+			     !list_empty(&d->opd_syn_committed_there),
+			     &lwi);
+	}
+
+	spin_lock(&d->opd_syn_lock);
+	for (i = 0; i < d->opd_syn_helper_count; i++) {
+		h = &d->opd_syn_helpers[i];
+		if (h->osh_ready && !osp_sync_helper_stopping(h))
+			h->osh_live_cursor = cursors++;
+		else
+			h->osh_live_cursor = 0;
+	}
+	d->opd_syn_live_cursors = cursors;
+	d->opd_syn_live_gen = d->opd_syn_helpers_gen;
+	spin_unlock(&d->opd_syn_lock);
+
+	CDEBUG(D_HA, "%s: changes of this boot are sent by %d cursors\n",
+	       d->opd_obd->obd_name, cursors);
+}
+
+/**
+ * Queue a change of this boot to the helper sending its share.
+ *
+ * The changes of this boot are read by the sync thread alone, once they are
+ * committed locally, and spread by object among the sync thread and the
+ * helpers, so the changes of an object are still sent in order. The room
+ * for the RPC is reserved and the change is accounted as processed here:
+ * the flow control and osp_sync() see it in flight until the helper sent it
+ * and the target replied.
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] d		OSP device
+ * \param[in] llh	llog handle where the record is stored
+ * \param[in] rec	llog record
+ *
+ * \retval 1		the change is queued to a helper
+ * \retval 0		the change is for the sync thread
+ * \retval negative	negated errno, try again later
+ */
+static int osp_sync_dispatch(const struct lu_env *env, struct osp_device *d,
+			     struct llog_handle *llh, struct llog_rec_hdr *rec)
+{
+	struct osp_sync_helper	*h = NULL;
+	struct osp_sync_qrec	*q;
+	int			 size;
+	int			 cursor;
+	int			 rc;
+	int			 i;
+
+	if (d->opd_syn_helpers == NULL)
+		return 0;
+
+	if (d->opd_syn_live_gen != d->opd_syn_helpers_gen) {
+		osp_sync_respread(env, d);
+		if (!osp_sync_running(d))
+			return 0;
+	}
+
+	cursor = osp_sync_rec_cursor(rec, d->opd_syn_live_cursors);
+	if (cursor == 0)
+		return 0;
+
+	size = offsetof(struct osp_sync_qrec, oqr_rec) + rec->lrh_len;
+	OBD_ALLOC(q, size);
+	if (q == NULL)
+		return -ENOMEM;
+
+	rc = osp_sync_reserve(d);
+	if (rc != 0) {
+		OBD_FREE(q, size);
+		return rc;
+	}
+
+	memcpy(&q->oqr_rec, rec, rec->lrh_len);
+	llog_handle_get(llh);
+	q->oqr_llh = llh;
+
+	spin_lock(&d->opd_syn_lock);
+	/* a helper left meanwhile, spread the changes again */
+	if (d->opd_syn_live_gen == d->opd_syn_helpers_gen) {
+		for (i = 0; i < d->opd_syn_helper_count; i++) {
+			if (d->opd_syn_helpers[i].osh_live_cursor == cursor) {
+				h = &d->opd_syn_helpers[i];
+				break;
+			}
+		}
+	}
+	if (h == NULL) {
+		spin_unlock(&d->opd_syn_lock);
+		llog_handle_put(llh);
+		OBD_FREE(q, size);
+		osp_sync_unreserve(d);
+		return -EAGAIN;
+	}
+	list_add_tail(&q->oqr_list, &h->osh_queue);
+	osp_sync_processed_locked(d, rec);
+	spin_unlock(&d->opd_syn_lock);
+
+	wake_up(&d->opd_syn_waitq);
+
+	return 1;
+}
+
+/**
+ * Send the changes of this boot queued to a helper.
+ *
+ * The room for the RPCs is already reserved. A change which can't be sent
+ * is tried again a second later, the changes of the same objects wait
+ * behind it. When the sync thread stops, the changes left are dropped: their
+ * records are not cancelled, they are sent again on the next boot.
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] h		the helper
+ */
+static void osp_sync_helper_send(const struct lu_env *env,
+				 struct osp_sync_helper *h)
+{
+	struct osp_device	*d = h->osh_dev;
+	struct osp_sync_qrec	*q;
+	struct l_wait_info	 lwi;
+	int			 rc;
+
+	while (1) {
+		spin_lock(&d->opd_syn_lock);
+		if (list_empty(&h->osh_queue)) {
+			spin_unlock(&d->opd_syn_lock);
+			break;
+		}
+		q = list_entry(h->osh_queue.next, struct osp_sync_qrec,
+			       oqr_list);
+		spin_unlock(&d->opd_syn_lock);
+
+		rc = 0;
+		if (osp_sync_running(d))
+			rc = osp_sync_send_record(env, d, q->oqr_llh,
+						  &q->oqr_rec);
+		if (rc < 0) {
+			CERROR("%s: helper %d can't send: rc = %d\n",
+			       d->opd_obd->obd_name, h->osh_index, rc);
+			lwi = LWI_TIMEOUT(cfs_time_seconds(1), NULL, NULL);
+			l_wait_event(d->opd_syn_waitq, !osp_sync_running(d),
+				     &lwi);
+			continue;
+		}
+		if (rc == 0)
+			osp_sync_unreserve(d);
+
+		spin_lock(&d->opd_syn_lock);
+		list_del(&q->oqr_list);
+		spin_unlock(&d->opd_syn_lock);
+		llog_handle_put(q->oqr_llh);
+		OBD_FREE(q, offsetof(struct osp_sync_qrec, oqr_rec) +
+			    q->oqr_rec.lrh_len);
+		/* the sync thread may wait for the queues to drain */
+		wake_up(&d->opd_syn_waitq);
+	}
+}
+
+/**
+ * OSP sync helper thread.
+ *
+ * Processes the plain llogs of the previous boots the sync thread shares
+ * with it, and sends the changes of this boot the sync thread queues to it,
+ * until the sync thread stops or the helper is not wanted any more.
+ *
+ * \param[in] _arg	the helper
+ *
+ * \retval 0		always
+ */
+static int osp_sync_helper_thread(void *_arg)
+{
+	struct osp_sync_helper	*h = _arg;
+	struct osp_device	*d = h->osh_dev;
+	struct l_wait_info	 lwi = { 0 };
+	struct llog_handle	*llh;
+	struct lu_env		 env;
+	int			 rc;
+
+	ENTRY;
+
+	rc = lu_env_init(&env, LCT_LOCAL);
+	if (rc) {
+		CERROR("%s: helper %d can't initialize env: rc = %d\n",
+		       d->opd_obd->obd_name, h->osh_index, rc);
+		spin_lock(&d->opd_syn_lock);
+		h->osh_started = 0;
+		spin_unlock(&d->opd_syn_lock);
+		GOTO(out, rc);
+	}
+
+	spin_lock(&d->opd_syn_lock);
+	h->osh_ready = 1;
+	d->opd_syn_helpers_gen++;
+	spin_unlock(&d->opd_syn_lock);
+	wake_up(&d->opd_syn_waitq);
+
+	while (1) {
+		l_wait_event(d->opd_syn_waitq,
+			     !osp_sync_running(d) || osp_sync_helper_stopping(h) ||
+			     h->osh_llh != NULL || !list_empty(&h->osh_queue),
+			     &lwi);
+
+		osp_sync_helper_send(&env, h);
+
+		/* leave once idle, under the lock the work is handed out */
+		spin_lock(&d->opd_syn_lock);
+		llh = h->osh_llh;
+		if (llh == NULL && list_empty(&h->osh_queue) &&
+		    (!osp_sync_running(d) || osp_sync_helper_stopping(h))) {
+			h->osh_ready = 0;
+			h->osh_started = 0;
+			d->opd_syn_helpers_gen++;
+			spin_unlock(&d->opd_syn_lock);
+			break;
+		}
+		spin_unlock(&d->opd_syn_lock);
+		if (llh == NULL)
+			continue;
+
+		rc = 0;
+		if (osp_sync_running(d)) {
+			rc = llog_process_or_fork(&env, llh,
+						  osp_sync_helper_process, h,
+						  NULL, false);
+			if (rc < 0)
+				CERROR("%s: helper %d failed to process llog "
+				       DOSTID": rc = %d\n",
+				       d->opd_obd->obd_name, h->osh_index,
+				       POSTID(&llh->lgh_id.lgl_oi), rc);
+		}
+
+		/* the reference is passed to the sync thread which sends
+		 * the rest of the share */
+		spin_lock(&d->opd_syn_lock);
+		h->osh_llh = NULL;
+		if (rc < 0)
+			h->osh_failed_llh = llh;
+		spin_unlock(&d->opd_syn_lock);
+		if (rc >= 0)
+			llog_handle_put(llh);
+		wake_up(&d->opd_syn_waitq);
+	}
+
+	lu_env_fini(&env);
+out:
+	atomic_dec(&d->opd_syn_helpers_running);
+	wake_up(&d->opd_syn_waitq);
+
+	RETURN(0);
+}
+
 /**
  * The core of the syncing mechanism.
  *
@@ -1101,6 +1836,13 @@ static int osp_sync_process_queues(const struct lu_env *env,
 	struct osp_device	*d = data;
 	int			 rc;
 
+	if (llh != NULL && osp_sync_handoff(env, d, llh, rec)) {
+		if (!osp_sync_running(d))
+			return LLOG_PROC_BREAK;
+		osp_sync_process_committed(env, d);
+		return 0;
+	}
+
 	do {
 		struct l_wait_info lwi = { 0 };
 
@@ -1130,14 +1872,27 @@ static int osp_sync_process_queues(const struct lu_env *env,
 			 * processing till we can send this request
 			 */
 			do {
-				rc = osp_sync_process_record(env, d, llh, rec);
+				/* changes of this boot may go to a helper */
+				rc = d->opd_syn_prev_done ?
+				     osp_sync_dispatch(env, d, llh, rec) : 0;
+				if (rc == 0)
+					rc = osp_sync_process_record(env, d,
+								     llh, rec);
+				else if (rc > 0)
+					rc = 0;
 				/*
 				 * XXX: probably different handling is needed
 				 * for some bugs, like immediate exit or if
 				 * OSP gets inactive
 				 */
-				if (rc) {
+				if (rc == -EAGAIN) {
+					/* helpers took the room, it's
+					 * released by committed RPCs */
+					osp_sync_process_committed(env, d);
+				} else if (rc) {
 					CERROR("can't send: %d\n", rc);
+				}
+				if (rc) {
 					l_wait_event(d->opd_syn_waitq,
 						     !osp_sync_running(d) ||
 						     osp_sync_has_work(d),
@@ -1230,6 +1985,12 @@ static int osp_sync_thread(void *_arg)
 		 d->opd_syn_changes, d->opd_syn_rpc_in_progress,
 		 d->opd_syn_rpc_in_flight);
 
+	/* helpers hold plain llogs and may still send */
+	l_wait_event(d->opd_syn_waitq,
+		     atomic_read(&d->opd_syn_helpers_running) == 0, &lwi);
+	/* release the llogs failed helpers left */
+	osp_sync_helpers_takeover(&env, d);
+
 	/* wait till all the requests are completed */
 	count = 0;
 	while (d->opd_syn_rpc_in_progress > 0) {
@@ -1381,6 +2142,7 @@ static int osp_sync_llog_init(const struct lu_env *env, struct osp_device *d)
 	rc = llog_cat_add(env, lgh, &osi->osi_gen.lgr_hdr, &osi->osi_cookie);
 	if (rc < 0)
 		GOTO(out_close, rc);
+	d->opd_syn_gen_lgl = osi->osi_cookie.lgc_lgl;
 	llog_ctxt_put(ctxt);
 	RETURN(0);
 out_close:
@@ -1409,6 +2171,113 @@ static void osp_sync_llog_fini(const struct lu_env *env, struct osp_device *d)
 	llog_cleanup(env, ctxt);
 }
 
+/**
+ * Allocate the helpers of the sync thread.
+ *
+ * Room is made for the largest number of helpers, so that sync_threads can
+ * be raised later. The sync thread is already running, so the helpers are
+ * published under opd_syn_lock, see osp_sync_handoff().
+ *
+ * \param[in] d		OSP device
+ */
+static void osp_sync_helpers_alloc(struct osp_device *d)
+{
+	struct osp_sync_helper	*helpers;
+	int			 count = OSP_SYNC_THREADS_MAX - 1;
+	int			 i;
+
+	OBD_ALLOC(helpers, count * sizeof(*helpers));
+	if (helpers == NULL)
+		return;
+
+	for (i = 0; i < count; i++) {
+		helpers[i].osh_dev = d;
+		helpers[i].osh_index = i;
+		INIT_LIST_HEAD(&helpers[i].osh_queue);
+	}
+
+	spin_lock(&d->opd_syn_lock);
+	d->opd_syn_helpers = helpers;
+	d->opd_syn_helper_count = count;
+	spin_unlock(&d->opd_syn_lock);
+}
+
+/**
+ * Start the helpers wanted which are not running.
+ *
+ * Failing to start them is not fatal, the sync thread sends the changes no
+ * helper takes.
+ *
+ * \param[in] d		OSP device
+ */
+static void osp_sync_helpers_start(struct osp_device *d)
+{
+	struct osp_sync_helper	*h;
+	struct task_struct	*task;
+	int			 i;
+
+	for (i = 0; i < d->opd_syn_helper_count; i++) {
+		h = &d->opd_syn_helpers[i];
+
+		spin_lock(&d->opd_syn_lock);
+		if (h->osh_started || osp_sync_helper_stopping(h) ||
+		    !osp_sync_running(d)) {
+			spin_unlock(&d->opd_syn_lock);
+			continue;
+		}
+		/* counted under the lock, so the sync thread stopping
+		 * waits for it */
+		h->osh_started = 1;
+		atomic_inc(&d->opd_syn_helpers_running);
+		spin_unlock(&d->opd_syn_lock);
+
+		task = kthread_run(osp_sync_helper_thread, h,
+				   "osp-syn-%u-%u-%d", d->opd_index,
+				   d->opd_group, i);
+		if (IS_ERR(task)) {
+			spin_lock(&d->opd_syn_lock);
+			h->osh_started = 0;
+			spin_unlock(&d->opd_syn_lock);
+			atomic_dec(&d->opd_syn_helpers_running);
+			CWARN("%s: cannot start sync helper %d: rc = %ld\n",
+			      d->opd_obd->obd_name, i, PTR_ERR(task));
+			break;
+		}
+	}
+}
+
+/**
+ * Change the number of threads sending the changes.
+ *
+ * New helpers are started right away. The helpers which are not wanted any
+ * more stop once they sent the changes they have, and the changes of this
+ * boot are spread again among the helpers left, see osp_sync_respread().
+ * The old llog being processed keeps its cursors.
+ *
+ * \param[in] d		OSP device
+ * \param[in] threads	number of threads, the sync thread included
+ *
+ * \retval 0		on success
+ * \retval negative	negated errno on error
+ */
+int osp_sync_threads_set(struct osp_device *d, int threads)
+{
+	if (threads < 1 || threads > OSP_SYNC_THREADS_MAX)
+		return -ERANGE;
+	if (threads > 1 && d->opd_syn_helpers == NULL)
+		return -ENOMEM;
+
+	spin_lock(&d->opd_syn_lock);
+	d->opd_syn_threads = threads;
+	d->opd_syn_helpers_gen++;
+	spin_unlock(&d->opd_syn_lock);
+	wake_up(&d->opd_syn_waitq);
+
+	osp_sync_helpers_start(d);
+
+	return 0;
+}
+
 /**
  * Initialization of the sync component of OSP.
  *
@@ -1448,6 +2317,9 @@ int osp_sync_init(const struct lu_env *env, struct osp_device *d)
 	 */
 	d->opd_syn_max_rpc_in_flight = OSP_MAX_IN_FLIGHT;
 	d->opd_syn_max_rpc_in_progress = OSP_MAX_IN_PROGRESS;
+	d->opd_syn_threads = clamp(osp_sync_threads, 1, OSP_SYNC_THREADS_MAX);
+	d->opd_syn_live_cursors = 1;
+	atomic_set(&d->opd_syn_helpers_running, 0);
 	spin_lock_init(&d->opd_syn_lock);
 	init_waitqueue_head(&d->opd_syn_waitq);
 	init_waitqueue_head(&d->opd_syn_barrier_waitq);
@@ -1466,6 +2338,9 @@ int osp_sync_init(const struct lu_env *env, struct osp_device *d)
 	l_wait_event(d->opd_syn_thread.t_ctl_waitq,
 		     osp_sync_running(d) || osp_sync_stopped(d), &lwi);
 
+	osp_sync_helpers_alloc(d);
+	osp_sync_helpers_start(d);
+
 	RETURN(0);
 err_llog:
 	osp_sync_llog_fini(env, d);
@@ -1493,6 +2368,23 @@ int osp_sync_fini(struct osp_device *d)
 	wake_up(&d->opd_syn_waitq);
 	wait_event(thread->t_ctl_waitq, thread->t_flags & SVC_STOPPED);
 
+	wait_event(d->opd_syn_waitq,
+		   atomic_read(&d->opd_syn_helpers_running) == 0);
+	if (d->opd_syn_helpers != NULL) {
+		struct osp_sync_helper	*helpers = d->opd_syn_helpers;
+		int			 count = d->opd_syn_helper_count;
+		int			 i;
+
+		for (i = 0; i < count; i++)
+			LASSERT(list_empty(&helpers[i].osh_queue));
+
+		spin_lock(&d->opd_syn_lock);
+		d->opd_syn_helpers = NULL;
+		d->opd_syn_helper_count = 0;
+		spin_unlock(&d->opd_syn_lock);
+		OBD_FREE(helpers, count * sizeof(*helpers));
+	}
+
 	/*
 	 * unregister transaction callbacks only when sync thread
 	 * has finished operations with llog
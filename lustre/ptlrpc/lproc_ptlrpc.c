@@ -1057,6 +1057,36 @@ ptlrpc_lprocfs_hp_ratio_seq_write(struct file *file, const char __user *buffer,
 }
 LPROC_SEQ_FOPS(ptlrpc_lprocfs_hp_ratio);
 
+static int ptlrpc_lprocfs_ses_pool_seq_show(struct seq_file *m, void *v)
+{
+	struct ptlrpc_service		*svc = m->private;
+	struct ptlrpc_service_part	*svcpt;
+	struct lu_context_pool		*pool;
+	__u64				 allocated;
+	__u64				 reused;
+	__u64				 freed;
+	unsigned int			 count;
+	int				 i;
+
+	ptlrpc_service_for_each_part(svcpt, i, svc) {
+		pool = &svcpt->scp_ses_pool;
+
+		spin_lock(&pool->lcp_lock);
+		allocated = pool->lcp_allocated;
+		reused	  = pool->lcp_reused;
+		freed	  = pool->lcp_freed;
+		count	  = pool->lcp_count;
+		spin_unlock(&pool->lcp_lock);
+
+		seq_printf(m, "cpt %d: cached %u/%u allocated "LPU64
+			   " reused "LPU64" freed "LPU64"\n", svcpt->scp_cpt,
+			   count, pool->lcp_max, allocated, reused, freed);
+	}
+
+	return 0;
+}
+LPROC_SEQ_FOPS_RO(ptlrpc_lprocfs_ses_pool);
+
 void ptlrpc_lprocfs_register_service(struct proc_dir_entry *entry,
                                      struct ptlrpc_service *svc)
 {
@@ -1085,6 +1115,9 @@ void ptlrpc_lprocfs_register_service(struct proc_dir_entry *entry,
 		{ .name = "nrs_policies",
 		  .fops = &ptlrpc_lprocfs_nrs_fops,
 		  .data = svc },
+		{ .name = "session_pool",
+		  .fops = &ptlrpc_lprocfs_ses_pool_fops,
+		  .data = svc },
 		{ NULL }
         };
         static struct file_operations req_history_fops = {
@@ -656,6 +656,12 @@ ptlrpc_service_part_init(struct ptlrpc_service *svc,
 	 * timeout is less than this, we'll be sending an early reply. */
 	at_init(&svcpt->scp_at_estimate, 10, 0);
 
+	rc = lu_context_pool_init(&svcpt->scp_ses_pool,
+				  LCT_SERVER_SESSION | LCT_NOREF,
+				  PTLRPC_SES_POOL_MAX);
+	if (rc != 0)
+		goto failed;
+
 	/* assign this before call ptlrpc_grow_req_bufs */
 	svcpt->scp_service = svc;
 	/* Now allocate the request buffers, but don't post them now */
@@ -871,7 +877,7 @@ void ptlrpc_server_drop_request(struct ptlrpc_request *req)
 
 	if (req->rq_session.lc_state == LCS_ENTERED) {
 		lu_context_exit(&req->rq_session);
-		lu_context_fini(&req->rq_session);
+		lu_context_pool_put(&svcpt->scp_ses_pool, &req->rq_session);
 	}
 
 	if (req->rq_at_linked) {
@@ -1967,8 +1973,8 @@ ptlrpc_server_handle_req_in(struct ptlrpc_service_part *svcpt,
 	if (thread != NULL) {
 		/* initialize request session, it is needed for request
 		 * processing by target */
-		rc = lu_context_init(&req->rq_session, LCT_SERVER_SESSION |
-						       LCT_NOREF);
+		rc = lu_context_pool_get(&svcpt->scp_ses_pool,
+					 &req->rq_session);
 		if (rc) {
 			CERROR("%s: failure to initialize session: rc = %d\n",
 			       thread->t_name, rc);
@@ -3135,6 +3141,7 @@ ptlrpc_service_free(struct ptlrpc_service *svc)
 
 		/* In case somebody rearmed this in the meantime */
 		cfs_timer_disarm(&svcpt->scp_at_timer);
+		lu_context_pool_fini(&svcpt->scp_ses_pool);
 		array = &svcpt->scp_at_array;
 
 		if (array->paa_reqs_array != NULL) {
@@ -186,12 +186,14 @@ LU_KEY_INIT_GENERIC(tgt);
 
 /* context key constructor/destructor: tgt_ses_key_init, tgt_ses_key_fini */
 LU_KEY_INIT_FINI(tgt_ses, struct tgt_session_info);
+LU_KEY_RESET(tgt_ses, struct tgt_session_info);
 
 /* context key: tgt_session_key */
 struct lu_context_key tgt_session_key = {
 	.lct_tags = LCT_SERVER_SESSION,
 	.lct_init = tgt_ses_key_init,
 	.lct_fini = tgt_ses_key_fini,
+	.lct_reset = tgt_ses_key_reset,
 };
 EXPORT_SYMBOL(tgt_session_key);
 
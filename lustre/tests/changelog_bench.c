@@ -0,0 +1,144 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+
+/*
+ * Read a changelog as fast as possible and report the number of records
+ * received per second, either one record at a time or in batches.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sys/time.h>
+
+#include <lustre/lustreapi.h>
+
+#define BATCH_RECS	1024
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-b] [-e endrec] [-t type[,type...]] "
+		"<mdtname> [startrec]\n"
+		"\t-b: receive records in batches, without copying them\n"
+		"\t-e: stop after record endrec\n"
+		"\t-t: only receive records of these types (CREAT, UNLNK...)\n",
+		prog);
+	exit(EXIT_FAILURE);
+}
+
+static __u32 parse_types(char *list)
+{
+	__u32	 mask = 0;
+	char	*name;
+	int	 type;
+
+	for (name = strtok(list, ","); name != NULL;
+	     name = strtok(NULL, ",")) {
+		for (type = 0; type < CL_LAST; type++) {
+			if (strcasecmp(name, changelog_type2str(type)) == 0)
+				break;
+		}
+		if (type == CL_LAST) {
+			fprintf(stderr, "unknown record type '%s'\n", name);
+			exit(EXIT_FAILURE);
+		}
+		mask |= 1U << type;
+	}
+
+	return mask;
+}
+
+int main(int argc, char **argv)
+{
+	struct changelog_filter	 filter = { 0 };
+	struct changelog_rec	*recs[BATCH_RECS];
+	struct changelog_rec	*rec;
+	struct timeval		 start, end;
+	unsigned long long	 count = 0;
+	long long		 startrec = 0;
+	int			 flags = CHANGELOG_FLAG_BLOCK |
+					 CHANGELOG_FLAG_JOBID;
+	void			*priv;
+	double			 elapsed;
+	int			 rc;
+	int			 c;
+
+	while ((c = getopt(argc, argv, "be:t:")) != -1) {
+		switch (c) {
+		case 'b':
+			flags |= CHANGELOG_FLAG_BATCH;
+			break;
+		case 'e':
+			filter.cf_endrec = strtoll(optarg, NULL, 0);
+			break;
+		case 't':
+			filter.cf_typemask = parse_types(optarg);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (optind >= argc)
+		usage(argv[0]);
+	if (optind + 1 < argc)
+		startrec = strtoll(argv[optind + 1], NULL, 0);
+
+	gettimeofday(&start, NULL);
+
+	rc = llapi_changelog_start_filter(&priv, flags, argv[optind],
+					  startrec, &filter);
+	if (rc < 0) {
+		fprintf(stderr, "cannot start changelog: %s\n", strerror(-rc));
+		return EXIT_FAILURE;
+	}
+
+	if (flags & CHANGELOG_FLAG_BATCH) {
+		while ((rc = llapi_changelog_recv_batch(priv, recs,
+							BATCH_RECS)) > 0)
+			count += rc;
+	} else {
+		while ((rc = llapi_changelog_recv(priv, &rec)) == 0) {
+			count++;
+			llapi_changelog_free(&rec);
+		}
+		if (rc == 1)
+			rc = 0;
+	}
+
+	gettimeofday(&end, NULL);
+	llapi_changelog_fini(&priv);
+
+	if (rc < 0) {
+		fprintf(stderr, "changelog: %s\n", strerror(-rc));
+		return EXIT_FAILURE;
+	}
+
+	elapsed = (end.tv_sec - start.tv_sec) +
+		  (end.tv_usec - start.tv_usec) / 1000000.0;
+	printf("%llu records in %.3fs, %.0f records/s\n", count, elapsed,
+	       elapsed > 0 ? count / elapsed : 0);
+
+	return EXIT_SUCCESS;
+}
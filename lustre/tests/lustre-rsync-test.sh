@@ -658,6 +658,37 @@ test_9() {
 }
 run_test 9 "Replicate recursive directory removal"
 
+# Test 10 - Replicate with several threads
+test_10() {
+	init_src
+	init_changelog
+
+	local i
+
+	for i in $(seq 1 8); do
+		mkdir $DIR/$tdir/d$i
+		createmany -o $DIR/$tdir/d$i/f 100 > /dev/null ||
+			error "createmany failed"
+		dd if=/dev/urandom of=$DIR/$tdir/d$i/data bs=1M count=4 \
+			2> /dev/null || error "dd failed"
+		mv $DIR/$tdir/d$i/f0 $DIR/$tdir/d$i/g0
+		unlinkmany $DIR/$tdir/d$i/f 50 50 > /dev/null ||
+			error "unlinkmany failed"
+	done
+	mv $DIR/$tdir/d1 $DIR/$tdir/d8/d1
+
+	local LRSYNC_LOG=$(generate_logname "lrsync_log")
+	$LRSYNC -s $DIR -t $TGT -m $MDT0 -u $CL_USER -l $LREPL_LOG \
+		-D $LRSYNC_LOG --threads 4 || error "lustre_rsync failed"
+
+	check_diff ${DIR}/$tdir $TGT/$tdir
+
+	fini_changelog
+	cleanup_src_tgt
+	return 0
+}
+run_test 10 "Replicate with several threads"
+
 cd $ORIG_PWD
 complete $SECONDS
 check_and_cleanup_lustre
@@ -4975,6 +4975,31 @@ test_56z() { # LU-4824
 }
 run_test 56z "lfs find should continue after an error"
 
+test_56aa() {
+	local i j
+
+	test_mkdir -p $DIR/$tdir
+	for i in d{0..4}; do
+		test_mkdir -p $DIR/$tdir/$i/sub
+		for j in f{0..9}; do
+			touch $DIR/$tdir/$i/$j $DIR/$tdir/$i/sub/$j
+		done
+	done
+
+	local opts
+	for opts in "" "-type f" "-type d" "-maxdepth 2" "-name f1"; do
+		$LFS find $DIR/$tdir $opts | sort > $TMP/$tfile.serial
+		$LFS find $DIR/$tdir $opts --threads 4 2> $TMP/$tfile.stats |
+			sort > $TMP/$tfile.parallel
+		diff -u $TMP/$tfile.serial $TMP/$tfile.parallel ||
+			error "lfs find $opts --threads 4 differs from serial"
+		grep -q "^scanned [0-9]* entries" $TMP/$tfile.stats ||
+			error "lfs find $opts --threads 4 printed no rate"
+	done
+	rm -f $TMP/$tfile.*
+}
+run_test 56aa "lfs find --threads finds the same entries as serial"
+
 test_57a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
 	# note test will not do anything if MDS is not local
@@ -9005,6 +9030,8 @@ test_133a() {
 	touch ${testdir}/${tfile} || "touch failed"
 	check_stats $SINGLEMDS "open" 1
 	check_stats $SINGLEMDS "close" 1
+	check_stats $SINGLEMDS "open_time" 1
+	check_stats $SINGLEMDS "close_time" 1
 	mknod ${testdir}/${tfile}-pipe p || "mknod failed"
 	check_stats $SINGLEMDS "mknod" 1
 	rm -f ${testdir}/${tfile}-pipe || "pipe remove failed"
@@ -10376,6 +10403,40 @@ test_160c() {
 }
 run_test 160c "verify that changelog log catch the truncate event"
 
+test_160d() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	remote_mds_nodsh && skip "remote MDS with nodsh" && return
+
+	local USER=$(do_facet $SINGLEMDS $LCTL --device $MDT0 \
+		changelog_register -n)
+
+	test_mkdir -p -c1 $DIR/$tdir
+	createmany -o $DIR/$tdir/f 100 || error "createmany failed"
+	unlinkmany $DIR/$tdir/f 100 || error "unlinkmany failed"
+
+	local single=$(changelog_bench $MDT0 | awk '{ print $1 }')
+	local batch=$(changelog_bench -b $MDT0 | awk '{ print $1 }')
+	echo "records: single $single, batch $batch"
+	[ -n "$single" ] && [ "$single" -ge 200 ] ||
+		error "expected at least 200 records, got '$single'"
+	[ "$single" == "$batch" ] ||
+		error "batched read got $batch records, not $single"
+
+	local creates=$(changelog_bench -b -t CREAT $MDT0 | awk '{ print $1 }')
+	local creates2=$($LFS changelog $MDT0 | grep -c "CREAT")
+	[ "$creates" == "$creates2" ] ||
+		error "CREAT filter got $creates records, not $creates2"
+
+	local first=$($LFS changelog $MDT0 | head -n1 | awk '{ print $1 }')
+	local count=$(changelog_bench -b -e $((first + 9)) $MDT0 $first |
+		      awk '{ print $1 }')
+	[ "$count" == "10" ] || error "endrec filter got $count records, not 10"
+
+	$LFS changelog_clear $MDT0 $USER 0
+	do_facet $SINGLEMDS $LCTL --device $MDT0 changelog_deregister $USER
+}
+run_test 160d "batched and filtered changelog reads"
+
 test_161a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
 	test_mkdir -p -c1 $DIR/$tdir
@@ -12848,6 +12909,341 @@ test_243()
 }
 run_test 243 "various group lock tests"
 
+test_244() {
+	local count=$($LCTL get_param -n llite.*.opencache_threshold_count |
+		      head -n1)
+	[ "$count" -gt 0 ] || { skip "open cache disabled" && return 0; }
+
+	touch $DIR/$tfile || error "touch $DIR/$tfile failed"
+	cancel_lru_locks mdc
+	$LCTL set_param -n llite.*.stats=0
+
+	local i
+	for ((i = 0; i < count * 4; i++)); do
+		cat $DIR/$tfile > /dev/null || error "cat $DIR/$tfile failed"
+	done
+
+	local hits=$($LCTL get_param -n llite.*.stats |
+		     awk '/^opencache_hits/ { print $2 }')
+	[ -n "$hits" ] && [ "$hits" -gt 0 ] ||
+		error "no opens served from the open cache"
+
+	rm -f $DIR/$tfile || error "rm $DIR/$tfile failed"
+}
+run_test 244 "repeated opens of a hot file are served from cache"
+
+test_245() {
+	local max=$($LCTL get_param -n llite.*.dir_readahead_max | head -n1)
+	[ -n "$max" ] || { skip "no readdir read-ahead" && return 0; }
+
+	local nfiles=${NFILES:-20000}
+	local sa_max=$($LCTL get_param -n llite.*.statahead_max | head -n1)
+
+	test_mkdir -p -c1 $DIR/$tdir
+	createmany -m $DIR/$tdir/$tfile- $nfiles > /dev/null ||
+		error "createmany failed"
+	$LCTL set_param llite.*.statahead_max=0
+
+	local ra
+	for ra in 0 $max; do
+		$LCTL set_param -n llite.*.dir_readahead_max=$ra
+		cancel_lru_locks mdc
+		$LCTL set_param -n llite.*.stats=0
+
+		local start=$SECONDS
+		local count=$(ls -f $DIR/$tdir | wc -l)
+		[ $count -eq $((nfiles + 2)) ] ||
+			error "found $count entries, expected $((nfiles + 2))"
+
+		local stats=$($LCTL get_param -n llite.*.stats)
+		local hits=$(echo "$stats" |
+			     awk '/^readdir_hits/ { print $2 }')
+		local misses=$(echo "$stats" |
+			       awk '/^readdir_misses/ { print $2 }')
+		echo "read-ahead $ra: $((SECONDS - start))s," \
+		     "hits ${hits:-0}, misses ${misses:-0}"
+		[ $ra -eq 0 ] || [ ${hits:-0} -gt 0 ] ||
+			error "no readdir page read ahead"
+	done
+	$LCTL set_param llite.*.statahead_max=$sa_max
+
+	unlinkmany $DIR/$tdir/$tfile- $nfiles || error "unlinkmany failed"
+}
+run_test 245 "readdir read-ahead"
+
+test_246() {
+	[ $(facet_fstype $SINGLEMDS) != ldiskfs ] &&
+		skip "ldiskfs only test" && return
+	local mdt=$(facet_svc $SINGLEMDS)
+	local stats=osd-ldiskfs.$mdt.oi_stats
+	local max=$(do_facet $SINGLEMDS $LCTL get_param -n $stats |
+		    awk '/^cache_max:/ { print $2 }')
+	[ ${max:-0} -gt 0 ] || { skip "no FID to inode cache" && return 0; }
+
+	local nfiles=2000
+
+	test_mkdir -p -c1 $DIR/$tdir
+	createmany -o $DIR/$tdir/$tfile- $nfiles > /dev/null ||
+		error "createmany failed"
+	cancel_lru_locks mdc
+	do_facet $SINGLEMDS $LCTL set_param -n $stats=0
+	# drop the objects from the lu_site cache
+	do_facet $SINGLEMDS "echo 3 > /proc/sys/vm/drop_caches"
+
+	ls -l $DIR/$tdir > /dev/null || error "ls -l failed"
+	do_facet $SINGLEMDS $LCTL get_param -n $stats
+	local hits=$(do_facet $SINGLEMDS $LCTL get_param -n $stats |
+		     awk '/^cache_hits:/ { print $2 }')
+	[ ${hits:-0} -gt 0 ] || error "no FID lookup served from the cache"
+
+	unlinkmany $DIR/$tdir/$tfile- $nfiles || error "unlinkmany failed"
+}
+run_test 246 "FID to inode cache of the OI"
+
+oi_stat() {
+	do_facet $SINGLEMDS $LCTL get_param -n $1 |
+		awk '/^'$2':/ { print $2 }'
+}
+
+test_247() {
+	[ $(facet_fstype $SINGLEMDS) != ldiskfs ] &&
+		skip "ldiskfs only test" && return
+	remote_mds_nodsh && skip "remote MDS with nodsh" && return
+	local stats=osd-ldiskfs.$(facet_svc $SINGLEMDS).oi_stats
+	[ -z "$(oi_stat $stats iam_locks_shared)" ] &&
+		skip "MDS has no OI lock stats" && return
+	local nfiles=4000
+	local threads=8
+	local fids=$TMP/$tfile.fids
+	local pids=""
+	local shared
+	local waits
+	local i
+
+	test_mkdir -p -c1 $DIR/$tdir
+	createmany -o $DIR/$tdir/f- $nfiles > /dev/null ||
+		error "createmany failed"
+	for ((i = 0; i < nfiles; i++)); do
+		$LFS path2fid $DIR/$tdir/f-$i
+	done > $fids || error "path2fid failed"
+	stack_trap "rm -f $fids"
+
+	# start with empty object and OI caches, so that every stat by FID
+	# looks the FID up in the OI
+	cancel_lru_locks mdc
+	fail $SINGLEMDS
+	cancel_lru_locks mdc
+	do_facet $SINGLEMDS $LCTL set_param -n $stats=0
+
+	for i in $(seq 0 $((threads - 1))); do
+		awk 'NR % '$threads' == '$i $fids | while read fid; do
+			stat $MOUNT/.lustre/fid/$fid > /dev/null || exit 1
+		done &
+		pids="$pids $!"
+	done
+	for i in $pids; do
+		wait $i || error "stat by FID failed"
+	done
+
+	do_facet $SINGLEMDS $LCTL get_param -n $stats
+	shared=$(oi_stat $stats iam_locks_shared)
+	waits=$(oi_stat $stats iam_lock_waits)
+	# lookups share the OI leaves, they only wait for inserts
+	[ ${shared:-0} -ge $((nfiles / 2)) ] ||
+		error "only $shared shared OI locks for $nfiles lookups"
+	[ $((waits * 10)) -lt $shared ] ||
+		error "$waits of $shared OI lookups waited for a lock"
+
+	unlinkmany $DIR/$tdir/f- $nfiles || error "unlinkmany failed"
+}
+run_test 247 "concurrent OI lookups share the IAM leaf locks"
+
+test_248() {
+	[ $(facet_fstype ost1) != ldiskfs ] &&
+		skip "ldiskfs only test" && return
+	local stats=osd-ldiskfs.$(facet_svc ost1).sync_stats
+	local threads=8
+	local count=200
+	local pids=""
+	local commits
+	local waiters
+	local i
+
+	do_facet ost1 $LCTL set_param -n $stats=0 ||
+		{ skip "no journal commit coordinator" && return 0; }
+
+	test_mkdir -p $DIR/$tdir
+	for i in $(seq $threads); do
+		$SETSTRIPE -i 0 -c 1 $DIR/$tdir/$tfile.$i ||
+			error "setstripe $i failed"
+		dd if=/dev/zero of=$DIR/$tdir/$tfile.$i bs=4k count=$count \
+			oflag=sync 2> /dev/null &
+		pids="$pids $!"
+	done
+	for i in $pids; do
+		wait $i || error "sync write failed"
+	done
+
+	do_facet ost1 $LCTL get_param -n $stats
+	commits=$(do_facet ost1 $LCTL get_param -n $stats |
+		  awk '/^commits:/ { print $2 }')
+	waiters=$(do_facet ost1 $LCTL get_param -n $stats |
+		  awk '/^sync_waiters:/ { print $2 }')
+	[ ${commits:-0} -gt 0 ] || error "no commit forced by the sync writes"
+	[ $commits -lt $((threads * count)) ] ||
+		error "$commits commits for $((threads * count)) sync writes"
+	[ ${waiters:-0} -gt $commits ] ||
+		error "$waiters sync requests in $commits commits, not grouped"
+
+	rm -rf $DIR/$tdir
+}
+run_test 248 "grouped journal commits of sync writes"
+
+test_249() {
+	[ $(facet_fstype ost1) != ldiskfs ] &&
+		skip "ldiskfs only test" && return
+	remote_ost_nodsh && skip "remote OST with nodsh" && return
+	local osd=osd-ldiskfs.$(facet_svc ost1)
+	local max=$(do_facet ost1 $LCTL get_param -n $osd.read_prefetch_max_mb)
+	[ ${max:-0} -gt 0 ] || { skip "no read prefetch" && return 0; }
+	[ $(do_facet ost1 $LCTL get_param -n $osd.read_cache_enable) -eq 1 ] ||
+		{ skip "OSS read cache is disabled" && return 0; }
+
+	$SETSTRIPE -i 0 -c 1 $DIR/$tfile || error "setstripe failed"
+	dd if=/dev/urandom of=$DIR/$tfile bs=1M count=32 ||
+		error "dd write failed"
+	cancel_lru_locks osc
+	do_facet ost1 "echo 3 > /proc/sys/vm/drop_caches"
+	do_facet ost1 $LCTL set_param -n $osd.stats=clear
+
+	dd if=$DIR/$tfile of=/dev/null bs=64k || error "dd read failed"
+
+	do_facet ost1 $LCTL get_param -n $osd.stats
+	local prefetch=$(do_facet ost1 $LCTL get_param -n $osd.stats |
+			 awk '$1 == "prefetch" { print $2 }')
+	local hits=$(do_facet ost1 $LCTL get_param -n $osd.stats |
+		     awk '$1 == "prefetch_hit" { print $2 }')
+	[ ${prefetch:-0} -gt 0 ] || error "sequential read not prefetched"
+	[ ${hits:-0} -gt 0 ] || error "no read served from prefetched pages"
+
+	rm -f $DIR/$tfile
+}
+run_test 249 "OSD read prefetch of sequential reads"
+
+test_250() {
+	remote_mds_nodsh && skip "remote MDS with nodsh" && return
+	local mdtosc=$(get_mdtosc_proc_path $SINGLEMDS $FSNAME-OST0000)
+	local param="osc.$mdtosc.sync_destroys"
+	local before=$(do_facet $SINGLEMDS $LCTL get_param -n $param)
+	[ -z "$before" ] && skip "MDS has no sync_destroys" && return
+
+	test_mkdir -p $DIR/$tdir
+	$SETSTRIPE -i 0 -c 1 $DIR/$tdir || error "setstripe failed"
+	createmany -o $DIR/$tdir/f- 500 || error "createmany failed"
+	unlinkmany $DIR/$tdir/f- 500 || error "unlinkmany failed"
+	wait_delete_completed
+
+	local after=$(do_facet $SINGLEMDS $LCTL get_param -n $param)
+	[ $((after - before)) -ge 500 ] ||
+		error "only $((after - before)) of 500 destroys committed"
+
+	# sync_in_progress only drops once the committed records are
+	# cancelled from the llog
+	local p
+	for p in sync_changes sync_in_progress; do
+		wait_update_facet $SINGLEMDS \
+			"$LCTL get_param -n osc.$mdtosc.$p" 0 ||
+			error "$p is not 0 after the destroys committed"
+	done
+	rm -rf $DIR/$tdir
+}
+run_test 250 "OSP cancels the llog records of committed destroys"
+
+test_251() {
+	remote_mds_nodsh && skip "remote MDS with nodsh" && return
+	local mdtosc=$(get_mdtosc_proc_path $SINGLEMDS $FSNAME-OST0000)
+	local param=osc.$mdtosc.sync_threads
+	local old=$(do_facet $SINGLEMDS $LCTL get_param -n $param)
+	[ -z "$old" ] && skip "MDS has no sync_threads" && return 0
+
+	stack_trap "do_facet $SINGLEMDS $LCTL set_param $param=$old"
+	do_facet $SINGLEMDS $LCTL set_param $param=17 &&
+		error "more than 16 sync threads allowed"
+	do_facet $SINGLEMDS $LCTL set_param $param=8 ||
+		error "cannot set $param"
+
+	test_mkdir -p $DIR/$tdir
+	$SETSTRIPE -i 0 -c 1 $DIR/$tdir || error "setstripe failed"
+
+	# the changes of this boot are spread among the helpers too
+	local before=$(do_facet $SINGLEMDS \
+		       $LCTL get_param -n osc.$mdtosc.sync_destroys)
+	createmany -o $DIR/$tdir/f- 5000 || error "createmany failed"
+	unlinkmany $DIR/$tdir/f- 5000 || error "unlinkmany failed"
+	wait_delete_completed
+	local after=$(do_facet $SINGLEMDS \
+		      $LCTL get_param -n osc.$mdtosc.sync_destroys)
+	[ $((after - before)) -ge 5000 ] ||
+		error "only $((after - before)) of 5000 destroys committed"
+	do_facet $SINGLEMDS $LCTL set_param $param=2 ||
+		error "cannot lower $param"
+	wait_update_facet $SINGLEMDS \
+		"$LCTL get_param -n osc.$mdtosc.sync_changes" 0 ||
+		error "changes left after lowering $param"
+
+	createmany -o $DIR/$tdir/f- 5000 || error "createmany failed"
+
+	# leave the destroys to the llog cursors of the next boot
+	do_facet $SINGLEMDS $LCTL --device %$mdtosc deactivate
+	unlinkmany $DIR/$tdir/f- 5000 || error "unlinkmany failed"
+	fail $SINGLEMDS
+
+	wait_mds_ost_sync || error "old changes not synced"
+	wait_delete_completed
+	local destroys=$(do_facet $SINGLEMDS \
+			 $LCTL get_param -n osc.$mdtosc.sync_destroys)
+	[ ${destroys:-0} -ge 5000 ] ||
+		error "only $destroys of 5000 old destroys committed"
+	rm -rf $DIR/$tdir
+}
+run_test 251 "OSP sync threads and the changes of the previous boot"
+
+test_252() {
+	remote_mds_nodsh && skip "remote MDS with nodsh" && return
+	local mdtosc=$(get_mdtosc_proc_path $SINGLEMDS $FSNAME-OST0000)
+	local osp="osc.$mdtosc"
+	local old=$(do_facet $SINGLEMDS $LCTL get_param -n $osp.min_create_count)
+	[ -z "$old" ] && skip "MDS has no min_create_count" && return
+
+	stack_trap "do_facet $SINGLEMDS $LCTL set_param \
+		$osp.min_create_count=$old"
+	do_facet $SINGLEMDS $LCTL set_param $osp.min_create_count=1024 ||
+		error "cannot set min_create_count"
+	do_facet $SINGLEMDS $LCTL set_param $osp.max_create_count=2000 &&
+		error "max_create_count below twice min_create_count allowed"
+	test_mkdir -p $DIR/$tdir
+	$SETSTRIPE -i 0 -c 1 $DIR/$tdir || error "setstripe failed"
+	touch $DIR/$tdir/f0 || error "touch failed"
+
+	local count=$(do_facet $SINGLEMDS $LCTL get_param -n $osp.create_count)
+	local ready=0
+	local i
+
+	for i in $(seq 30); do
+		ready=$(($(do_facet $SINGLEMDS $LCTL get_param -n \
+				$osp.prealloc_last_id) -
+			 $(do_facet $SINGLEMDS $LCTL get_param -n \
+				$osp.prealloc_next_id)))
+		[ $ready -ge 512 ] && break
+		sleep 1
+	done
+
+	[ $count -ge 1024 ] || error "create_count $count < 1024"
+	[ $ready -ge 512 ] || error "only $ready objects precreated"
+	rm -rf $DIR/$tdir
+}
+run_test 252 "OSP keeps min_create_count objects precreated"
+
 cleanup_test_300() {
 	trap 0
 	umask $SAVE_UMASK
@@ -13181,6 +13577,39 @@ test_300h() {
 }
 run_test 300h "client handle unknown hash type striped directory"
 
+test_300i() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	[ $MDSCOUNT -lt 2 ] && skip "needs >= 2 MDTs" && return
+	local nfiles=${NFILES:-10000}
+	local dir
+
+	mkdir -p $DIR/$tdir
+	$LFS mkdir -i 0 $DIR/$tdir/plain_dir || error "mkdir plain failed"
+	$LFS setdirstripe -i 0 -c$MDSCOUNT $DIR/$tdir/striped_dir ||
+		error "set striped dir error"
+
+	for dir in plain_dir striped_dir; do
+		createmany -m $DIR/$tdir/$dir/f- $nfiles > /dev/null ||
+			error "createmany under $dir failed"
+		cancel_lru_locks mdc
+
+		local start=$SECONDS
+		local count=$(ls -f $DIR/$tdir/$dir | wc -l)
+		echo "ls -f $dir: $count entries in $((SECONDS - start))s"
+		[ $count -eq $((nfiles + 2)) ] ||
+			error "$dir: found $count entries, expected $((nfiles+2))"
+
+		local dups=$(ls -f $DIR/$tdir/$dir | sort | uniq -d | wc -l)
+		[ $dups -eq 0 ] || error "$dir: $dups entries listed twice"
+	done
+
+	unlinkmany $DIR/$tdir/plain_dir/f- $nfiles ||
+		error "unlinkmany plain failed"
+	unlinkmany $DIR/$tdir/striped_dir/f- $nfiles ||
+		error "unlinkmany striped failed"
+}
+run_test 300i "readdir of striped directory reads all stripes at once"
+
 test_400a() { # LU-1606, was conf-sanity test_74
 	local extra_flags=''
 	local out=$TMP/$tfile
@@ -4936,6 +4936,22 @@ banner() {
     log "$msg== $(date +"%H:%M:%S (%s)")"
 }
 
+#
+# Add a command to run when the test exits, before the ones already set.
+# As run_one() runs each test in a subshell, the commands also run when
+# the test fails with error().
+#
+stack_trap() {
+	local arg="$1"
+	local sigspec="${2:-EXIT}"
+	local cmd=$(trap -p $sigspec)
+
+	cmd=${cmd#"trap -- '"}
+	cmd=${cmd%"' $sigspec"}
+	[ -n "$cmd" ] || cmd=":"
+	trap "$arg; $cmd" $sigspec
+}
+
 #
 # Run a single test function and cleanup after it.
 #
@@ -57,6 +57,7 @@
 #include <sys/quota.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <fcntl.h>
 #include <dirent.h>
 #include <time.h>
@@ -207,12 +208,15 @@ command_t cmdlist[] = {
          "     [[!] --stripe-count|-c [+-]<stripes>]\n"
          "     [[!] --stripe-index|-i <index,...>]\n"
          "     [[!] --stripe-size|-S [+-]N[kMGT]] [[!] --type|-t <filetype>]\n"
+	 "     [--threads N]\n"
          "     [[!] --gid|-g|--group|-G <gid>|<gname>]\n"
          "     [[!] --uid|-u|--user|-U <uid>|<uname>] [[!] --pool <pool>]\n"
 	 "     [[!] --layout|-L released,raid0]\n"
          "\t !: used before an option indicates 'NOT' requested attribute\n"
          "\t -: used before a value indicates 'AT MOST' requested value\n"
-         "\t +: used before a value indicates 'AT LEAST' requested value\n"},
+         "\t +: used before a value indicates 'AT LEAST' requested value\n"
+	 "\t --threads: scan directories with N threads (at most 64) in\n"
+	 "\t\t parallel and report the number of entries scanned per second\n"},
         {"check", lfs_check, 0,
          "Display the status of MDS or OSTs (as specified in the command)\n"
          "or all the servers (MDS and OSTs).\n"
@@ -1054,11 +1058,13 @@ static int name2layout(__u32 *layout, char *name)
 }
 
 #define FIND_POOL_OPT 3
+#define FIND_THREADS_OPT 4
 static int lfs_find(int argc, char **argv)
 {
 	int c, rc;
 	int ret = 0;
         time_t t;
+	unsigned long threads;
 	struct find_param param = {
 		.fp_max_depth = -1,
 		.fp_quiet = 1,
@@ -1087,6 +1093,7 @@ static int lfs_find(int argc, char **argv)
                 {"size",         required_argument, 0, 's'},
                 {"stripe-size",  required_argument, 0, 'S'},
                 {"stripe_size",  required_argument, 0, 'S'},
+		{"threads",	 required_argument, 0, FIND_THREADS_OPT},
                 {"type",         required_argument, 0, 't'},
                 {"uid",          required_argument, 0, 'u'},
                 {"user",         required_argument, 0, 'U'},
@@ -1099,6 +1106,7 @@ static int lfs_find(int argc, char **argv)
         int *xsign;
         int isoption;
         char *endptr;
+	struct timeval start, end;
 
         time(&t);
 
@@ -1241,6 +1249,23 @@ static int lfs_find(int argc, char **argv)
 			param.fp_exclude_pool = !!neg_opt;
 			param.fp_check_pool = 1;
                         break;
+		case FIND_THREADS_OPT:
+			threads = strtoul(optarg, &endptr, 0);
+			if (*endptr != '\0' || threads == 0) {
+				fprintf(stderr, "error: %s: bad thread count "
+					"'%s'\n", argv[0], optarg);
+				ret = CMD_HELP;
+				goto err;
+			}
+			if (threads > LLAPI_FIND_MAX_THREADS) {
+				fprintf(stderr, "error: %s: thread count %lu "
+					"exceeds %u\n", argv[0], threads,
+					LLAPI_FIND_MAX_THREADS);
+				ret = CMD_HELP;
+				goto err;
+			}
+			param.fp_threads = threads;
+			break;
                 case 'n':
 			param.fp_pattern = (char *)optarg;
 			param.fp_exclude_pattern = !!neg_opt;
@@ -1412,12 +1437,25 @@ err_free:
                 pathend = argc;
         }
 
+	gettimeofday(&start, NULL);
 	do {
 		rc = llapi_find(argv[pathstart], &param);
 		if (rc != 0 && ret == 0)
 			ret = rc;
 	} while (++pathstart < pathend);
 
+	if (param.fp_threads != 0) {
+		double elapsed;
+
+		gettimeofday(&end, NULL);
+		elapsed = (end.tv_sec - start.tv_sec) +
+			  (end.tv_usec - start.tv_usec) / 1000000.0;
+		fprintf(stderr, "scanned %llu entries in %.2fs (%.0f/s) "
+			"with %u threads\n", param.fp_scanned, elapsed,
+			elapsed > 0 ? param.fp_scanned / elapsed : 0,
+			param.fp_threads);
+	}
+
         if (ret)
                 fprintf(stderr, "error: %s failed for %s.\n",
                         argv[0], argv[optind - 1]);
@@ -3275,6 +3313,7 @@ static int lfs_changelog(int argc, char **argv)
 {
         void *changelog_priv;
 	struct changelog_rec *rec;
+	struct changelog_filter filter = { 0 };
         long long startrec = 0, endrec = 0;
         char *mdd;
         struct option long_opts[] = {
@@ -3307,11 +3346,14 @@ static int lfs_changelog(int argc, char **argv)
         if (argc > optind)
                 endrec = strtoll(argv[optind++], NULL, 10);
 
-	rc = llapi_changelog_start(&changelog_priv,
-				   CHANGELOG_FLAG_BLOCK |
-				   CHANGELOG_FLAG_JOBID |
-				   (follow ? CHANGELOG_FLAG_FOLLOW : 0),
-				   mdd, startrec);
+	/* stop reading the changelog past endrec */
+	filter.cf_endrec = endrec;
+	rc = llapi_changelog_start_filter(&changelog_priv,
+					  CHANGELOG_FLAG_BLOCK |
+					  CHANGELOG_FLAG_JOBID |
+					  CHANGELOG_FLAG_BATCH |
+					  (follow ? CHANGELOG_FLAG_FOLLOW : 0),
+					  mdd, startrec, &filter);
 	if (rc < 0) {
 		fprintf(stderr, "Can't start changelog: %s\n",
 			strerror(errno = -rc));
@@ -70,6 +70,9 @@
 #include <unistd.h>
 #endif
 #include <poll.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #include <libcfs/libcfs.h>
 #include <lnet/lnetctl.h>
@@ -2952,6 +2955,7 @@ static int cb_find_init(char *path, DIR *parent, DIR **dirp,
         LASSERT(parent != NULL || dir != NULL);
 
 	param->fp_lmd->lmd_lmm.lmm_stripe_count = 0;
+	param->fp_scanned++;
 
 	/* If a regular expression is presented, make the initial decision */
 	if (param->fp_pattern != NULL) {
@@ -3246,13 +3250,10 @@ obd_matches:
 					  param->fp_exclude_size,
 					  param->fp_size_units, 0);
 
-        if (decision != -1) {
-                llapi_printf(LLAPI_MSG_NORMAL, "%s", path);
-		if (param->fp_zero_end)
-                        llapi_printf(LLAPI_MSG_NORMAL, "%c", '\0');
-                else
-                        llapi_printf(LLAPI_MSG_NORMAL, "\n");
-        }
+	/* print with a single call, so that find threads do not interleave */
+	if (decision != -1)
+		llapi_printf(LLAPI_MSG_NORMAL, "%s%c", path,
+			     param->fp_zero_end ? '\0' : '\n');
 
 decided:
         /* Do not get down anymore? */
@@ -3342,8 +3343,315 @@ int llapi_mv(char *path, struct find_param *param)
 	return param_callback(path, cb_mv_init, cb_common_fini, param);
 }
 
+#ifdef HAVE_LIBPTHREAD
+/* A directory waiting to be scanned by a find thread. */
+struct find_work {
+	struct find_work	*fw_next;
+	unsigned int		 fw_depth;
+	char			 fw_path[0];
+};
+
+/* Directories shared by all the find threads of one llapi_find() call. */
+struct find_queue {
+	pthread_mutex_t		 fq_lock;
+	pthread_cond_t		 fq_cond;
+	/* LIFO, to keep the queue short by scanning depth first */
+	struct find_work	*fq_head;
+	/* threads currently scanning a directory, which may queue more */
+	int			 fq_active;
+	int			 fq_rc;
+};
+
+struct find_thread {
+	pthread_t		 ft_thread;
+	struct find_queue	*ft_queue;
+	struct find_param	 ft_param;
+	int			 ft_started;
+};
+
+static void find_queue_rc(struct find_queue *fq, int rc)
+{
+	pthread_mutex_lock(&fq->fq_lock);
+	if (fq->fq_rc == 0)
+		fq->fq_rc = rc;
+	pthread_mutex_unlock(&fq->fq_lock);
+}
+
+static int find_queue_add(struct find_queue *fq, const char *path,
+			  unsigned int depth)
+{
+	struct find_work *fw;
+	int len = strlen(path);
+
+	fw = malloc(sizeof(*fw) + len + 1);
+	if (fw == NULL) {
+		llapi_error(LLAPI_MSG_ERROR, -ENOMEM,
+			    "error: %s: cannot queue '%s'", __func__, path);
+		return -ENOMEM;
+	}
+	fw->fw_depth = depth;
+	memcpy(fw->fw_path, path, len + 1);
+
+	pthread_mutex_lock(&fq->fq_lock);
+	fw->fw_next = fq->fq_head;
+	fq->fq_head = fw;
+	pthread_cond_signal(&fq->fq_cond);
+	pthread_mutex_unlock(&fq->fq_lock);
+
+	return 0;
+}
+
+/**
+ * Check directory \a fw and all its entries against \a param, queueing its
+ * subdirectories for any find thread to scan instead of descending into
+ * them, see llapi_semantic_traverse() for the serial equivalent.
+ */
+static int find_scan_dir(struct find_queue *fq, struct find_work *fw,
+			 struct find_param *param, char *path)
+{
+	struct dirent64 dir_de = { .d_type = DT_DIR };
+	struct dirent64 *dent;
+	int len = strlen(fw->fw_path);
+	int ret = 0;
+	int rc;
+	DIR *d;
+
+	strcpy(path, fw->fw_path);
+	d = opendir(path);
+	if (d == NULL) {
+		ret = -errno;
+		/* removed since it was queued */
+		if (ret == -ENOENT)
+			return 0;
+		llapi_error(LLAPI_MSG_ERROR, ret, "%s: Failed to open '%s'",
+			    __func__, path);
+		return ret;
+	}
+
+	param->fp_depth = fw->fw_depth;
+	/* the top directory has no dirent */
+	ret = cb_find_init(path, NULL, &d, param,
+			   fw->fw_depth == 0 ? NULL : &dir_de);
+	if (ret != 0)
+		goto out;
+
+	while ((dent = readdir64(d)) != NULL) {
+		if (!strcmp(dent->d_name, ".") || !strcmp(dent->d_name, ".."))
+			continue;
+
+		/* Don't traverse .lustre directory */
+		if (!(strcmp(dent->d_name, dot_lustre_name)))
+			continue;
+
+		path[len] = 0;
+		if ((len + dent->d_reclen + 2) > PATH_MAX + 1) {
+			llapi_err_noerrno(LLAPI_MSG_ERROR,
+					  "error: %s: string buffer is too small",
+					  __func__);
+			break;
+		}
+		strcat(path, "/");
+		strcat(path, dent->d_name);
+
+		if (dent->d_type == DT_UNKNOWN) {
+			lstat_t *st = &param->fp_lmd->lmd_st;
+
+			rc = get_lmd_info(path, d, NULL, param->fp_lmd,
+					  param->fp_lum_size);
+			if (rc == 0)
+				dent->d_type = IFTODT(st->st_mode);
+			else if (ret == 0)
+				ret = rc;
+
+			if (rc == -ENOENT)
+				continue;
+		}
+
+		switch (dent->d_type) {
+		case DT_UNKNOWN:
+			llapi_err_noerrno(LLAPI_MSG_ERROR,
+					  "error: %s: '%s' is UNKNOWN type %d",
+					  __func__, dent->d_name, dent->d_type);
+			break;
+		case DT_DIR:
+			/* fp_depth was bumped by cb_find_init() above */
+			rc = find_queue_add(fq, path, param->fp_depth);
+			if (rc != 0 && ret == 0)
+				ret = rc;
+			break;
+		default:
+			rc = cb_find_init(path, d, NULL, param, dent);
+			if (rc < 0 && ret == 0)
+				ret = rc;
+			if (rc == 0)
+				cb_common_fini(path, d, NULL, param, dent);
+		}
+	}
+out:
+	path[len] = 0;
+	closedir(d);
+
+	return ret < 0 ? ret : 0;
+}
+
+static void *find_thread_main(void *arg)
+{
+	struct find_thread *ft = arg;
+	struct find_queue *fq = ft->ft_queue;
+	struct find_work *fw;
+	char *path;
+	int rc;
+
+	path = malloc(PATH_MAX + 1);
+	if (path == NULL) {
+		find_queue_rc(fq, -ENOMEM);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&fq->fq_lock);
+	while (1) {
+		fw = fq->fq_head;
+		if (fw != NULL) {
+			fq->fq_head = fw->fw_next;
+			fq->fq_active++;
+			pthread_mutex_unlock(&fq->fq_lock);
+
+			rc = find_scan_dir(fq, fw, &ft->ft_param, path);
+			free(fw);
+
+			pthread_mutex_lock(&fq->fq_lock);
+			if (rc != 0 && fq->fq_rc == 0)
+				fq->fq_rc = rc;
+			fq->fq_active--;
+			continue;
+		}
+
+		/* nothing queued and nobody left to queue more */
+		if (fq->fq_active == 0)
+			break;
+
+		pthread_cond_wait(&fq->fq_cond, &fq->fq_lock);
+	}
+	pthread_cond_broadcast(&fq->fq_cond);
+	pthread_mutex_unlock(&fq->fq_lock);
+
+	free(path);
+
+	return NULL;
+}
+
+/**
+ * Parallel llapi_find() over param->fp_threads threads, each with a private
+ * copy of \a param for its per-file state. Directories are scanned as soon
+ * as any thread is idle, so wide and deep trees (and striped directories
+ * spread over several MDTs) are walked with that many RPCs in flight.
+ * The order of the output is not stable.
+ */
+static int llapi_find_parallel(char *path, struct find_param *param)
+{
+	struct find_queue fq = { .fq_head = NULL };
+	struct find_thread *threads;
+	struct find_work *fw;
+	int nthreads = param->fp_threads;
+	int rc, i;
+	DIR *d;
+
+	if (strlen(path) > PATH_MAX) {
+		rc = -EINVAL;
+		llapi_error(LLAPI_MSG_ERROR, rc,
+			    "Path name '%s' is too long", path);
+		return rc;
+	}
+
+	/* a single file, nothing to run in parallel */
+	d = opendir(path);
+	if (d == NULL)
+		return param_callback(path, cb_find_init, cb_common_fini,
+				      param);
+	closedir(d);
+
+	threads = calloc(nthreads, sizeof(*threads));
+	if (threads == NULL)
+		return -ENOMEM;
+
+	pthread_mutex_init(&fq.fq_lock, NULL);
+	pthread_cond_init(&fq.fq_cond, NULL);
+
+	for (i = 0; i < nthreads; i++) {
+		struct find_param *tparam = &threads[i].ft_param;
+
+		threads[i].ft_queue = &fq;
+		*tparam = *param;
+		tparam->fp_lmd = NULL;
+		tparam->fp_lmv_md = NULL;
+		tparam->fp_obd_indexes = NULL;
+		tparam->fp_mdt_indexes = NULL;
+		tparam->fp_obds_printed = 0;
+		tparam->fp_scanned = 0;
+		rc = common_param_init(tparam, path);
+		if (rc != 0)
+			goto out;
+	}
+
+	rc = find_queue_add(&fq, path, 0);
+	if (rc != 0)
+		goto out;
+
+	/* the calling thread is thread 0 */
+	for (i = 1; i < nthreads; i++) {
+		rc = pthread_create(&threads[i].ft_thread, NULL,
+				    find_thread_main, &threads[i]);
+		if (rc != 0) {
+			llapi_error(LLAPI_MSG_WARN, -rc,
+				    "warning: cannot start find thread %d", i);
+			rc = 0;
+			break;
+		}
+		threads[i].ft_started = 1;
+	}
+
+	find_thread_main(&threads[0]);
+
+	for (i = 1; i < nthreads; i++)
+		if (threads[i].ft_started)
+			pthread_join(threads[i].ft_thread, NULL);
+
+	rc = fq.fq_rc;
+out:
+	while ((fw = fq.fq_head) != NULL) {
+		fq.fq_head = fw->fw_next;
+		free(fw);
+	}
+
+	for (i = 0; i < nthreads; i++) {
+		struct find_param *tparam = &threads[i].ft_param;
+
+		param->fp_scanned += tparam->fp_scanned;
+		if (tparam->fp_mdt_indexes != NULL)
+			free(tparam->fp_mdt_indexes);
+		find_param_fini(tparam);
+	}
+	free(threads);
+
+	pthread_cond_destroy(&fq.fq_cond);
+	pthread_mutex_destroy(&fq.fq_lock);
+
+	return rc;
+}
+#endif /* HAVE_LIBPTHREAD */
+
 int llapi_find(char *path, struct find_param *param)
 {
+	if (param->fp_threads > LLAPI_FIND_MAX_THREADS) {
+		llapi_error(LLAPI_MSG_ERROR, -EINVAL,
+			    "too many threads %u, max %u", param->fp_threads,
+			    LLAPI_FIND_MAX_THREADS);
+		return -EINVAL;
+	}
+#ifdef HAVE_LIBPTHREAD
+	if (param->fp_threads > 1)
+		return llapi_find_parallel(path, param);
+#endif
         return param_callback(path, cb_find_init, cb_common_fini, param);
 }
 
@@ -4218,14 +4526,22 @@ int root_ioctl(const char *mdtname, int opc, void *data, int *mdtidxp,
 /****** Changelog API ********/
 
 static int changelog_ioctl(const char *mdtname, int opc, int id,
-                           long long recno, int flags)
+			   long long recno, int flags,
+			   const struct changelog_filter *filter)
 {
-        struct ioc_changelog data;
+	struct ioc_changelog data = { 0 };
         int *idx;
 
         data.icc_id = id;
         data.icc_recno = recno;
         data.icc_flags = flags;
+	if (filter != NULL) {
+		data.icc_flags |= CHANGELOG_FLAG_FILTER;
+		data.icc_endrec = filter->cf_endrec;
+		data.icc_typemask = filter->cf_typemask;
+		data.icc_fid_start = filter->cf_fid_start;
+		data.icc_fid_end = filter->cf_fid_end;
+	}
         idx = (int *)(&data.icc_mdtindex);
 
         return root_ioctl(mdtname, opc, &data, idx, WANT_ERROR);
@@ -4236,6 +4552,11 @@ struct changelog_private {
 	int				magic;
 	enum changelog_send_flag	flags;
 	lustre_kernelcomm		kuc;
+	/* last message received with CHANGELOG_FLAG_BATCH */
+	char				*batch;
+	int				batch_len;
+	int				batch_off;	/* next record */
+	bool				eof;
 };
 
 /** Start reading from a changelog
@@ -4247,6 +4568,24 @@ struct changelog_private {
  */
 int llapi_changelog_start(void **priv, enum changelog_send_flag flags,
 			  const char *device, long long startrec)
+{
+	return llapi_changelog_start_filter(priv, flags, device, startrec,
+					    NULL);
+}
+
+/** Start reading from a changelog, reporting only some records
+ * @param priv Opaque private control structure
+ * @param flags Start flags (e.g. CHANGELOG_FLAG_BLOCK | CHANGELOG_FLAG_BATCH)
+ * @param device Report changes recorded on this MDT
+ * @param startrec Report changes beginning with this record number
+ * @param filter Only report records matching this filter, if not NULL
+ *
+ * With CHANGELOG_FLAG_BATCH the kernel sends many records per message,
+ * which can be read in place with llapi_changelog_recv_batch().
+ */
+int llapi_changelog_start_filter(void **priv, enum changelog_send_flag flags,
+				 const char *device, long long startrec,
+				 const struct changelog_filter *filter)
 {
 	struct changelog_private	*cp;
 	static bool			 warned;
@@ -4260,6 +4599,14 @@ int llapi_changelog_start(void **priv, enum changelog_send_flag flags,
 	cp->magic = CHANGELOG_PRIV_MAGIC;
 	cp->flags = flags;
 
+	if (flags & CHANGELOG_FLAG_BATCH) {
+		cp->batch = malloc(KUC_CHANGELOG_BATCH_MAXSIZE);
+		if (cp->batch == NULL) {
+			rc = -ENOMEM;
+			goto out_free;
+		}
+	}
+
 	/* Set up the receiver */
 	rc = libcfs_ukuc_start(&cp->kuc, 0 /* no group registration */, 0);
 	if (rc < 0)
@@ -4277,7 +4624,7 @@ int llapi_changelog_start(void **priv, enum changelog_send_flag flags,
 
 	/* Tell the kernel to start sending */
 	rc = changelog_ioctl(device, OBD_IOC_CHANGELOG_SEND, cp->kuc.lk_wfd,
-			     startrec, flags);
+			     startrec, flags, filter);
 	/* Only the kernel reference keeps the write side open */
 	close(cp->kuc.lk_wfd);
 	cp->kuc.lk_wfd = LK_NOFD;
@@ -4290,6 +4637,7 @@ int llapi_changelog_start(void **priv, enum changelog_send_flag flags,
 	return 0;
 
 out_free:
+	free(cp->batch);
 	free(cp);
 	return rc;
 }
@@ -4303,6 +4651,7 @@ int llapi_changelog_fini(void **priv)
                 return -EINVAL;
 
         libcfs_ukuc_stop(&cp->kuc);
+	free(cp->batch);
         free(cp);
         *priv = NULL;
         return 0;
@@ -4325,6 +4674,111 @@ int llapi_changelog_fini(void **priv)
  *         1 EOF
  */
 #define DEFAULT_RECORD_FMT	(CLF_VERSION | CLF_RENAME)
+
+/**
+ * Point \a rech to the next record of the current batch in cp->batch,
+ * receiving the next batch first if it is consumed.
+ * \retval 0 valid record, 1 EOF, <0 error
+ */
+static int changelog_batch_next(struct changelog_private *cp,
+				struct changelog_rec **rech)
+{
+	struct kuc_hdr			*kuch = (struct kuc_hdr *)cp->batch;
+	struct changelog_rec		*rec;
+	enum changelog_rec_flags	 rec_fmt = DEFAULT_RECORD_FMT;
+	int				 rc;
+
+	if (cp->flags & CHANGELOG_FLAG_JOBID)
+		rec_fmt |= CLF_JOBID;
+
+	while (cp->batch_off >= cp->batch_len) {
+		if (cp->eof)
+			return 1;
+
+		rc = libcfs_ukuc_msg_get(&cp->kuc, cp->batch,
+					 KUC_CHANGELOG_BATCH_MAXSIZE,
+					 KUC_TRANSPORT_CHANGELOG);
+		if (rc < 0)
+			return rc;
+
+		if (kuch->kuc_transport != KUC_TRANSPORT_CHANGELOG)
+			kuch->kuc_msgtype = 0;
+
+		switch (kuch->kuc_msgtype) {
+		case CL_EOF:
+			/* Ignore EOFs when following */
+			if (!(cp->flags & CHANGELOG_FLAG_FOLLOW))
+				cp->eof = true;
+			break;
+		case CL_RECORD:
+			/* a single record, from a kernel not batching */
+			rec = (struct changelog_rec *)(kuch + 1);
+			changelog_remap_rec(rec, rec_fmt);
+			cp->batch_off = sizeof(*kuch);
+			cp->batch_len = cp->batch_off +
+					changelog_rec_size(rec) +
+					rec->cr_namelen;
+			break;
+		case CL_RECORDS:
+			/* already remapped by the kernel */
+			cp->batch_off = sizeof(*kuch);
+			cp->batch_len = kuch->kuc_msglen;
+			break;
+		default:
+			llapi_err_noerrno(LLAPI_MSG_ERROR,
+					  "Unknown changelog message type "
+					  "%d:%d\n", kuch->kuc_transport,
+					  kuch->kuc_msgtype);
+			return -EPROTO;
+		}
+	}
+
+	rec = (struct changelog_rec *)(cp->batch + cp->batch_off);
+	cp->batch_off += cfs_size_round(changelog_rec_size(rec) +
+					rec->cr_namelen);
+	*rech = rec;
+
+	return 0;
+}
+
+/** Read the next changelog records, without copying them
+ * @param priv Opaque private control structure, started with
+ *             CHANGELOG_FLAG_BATCH
+ * @param recs Filled with pointers to up to \a nrecs records, which are
+ *             valid until the next call or llapi_changelog_fini()
+ * @param nrecs Size of \a recs
+ * @return >0 number of records received
+ *         0 EOF
+ *         <0 error code
+ */
+int llapi_changelog_recv_batch(void *priv, struct changelog_rec **recs,
+			       int nrecs)
+{
+	struct changelog_private	*cp = (struct changelog_private *)priv;
+	int				 i;
+	int				 rc;
+
+	if (!cp || (cp->magic != CHANGELOG_PRIV_MAGIC))
+		return -EINVAL;
+	if (cp->batch == NULL || recs == NULL || nrecs <= 0)
+		return -EINVAL;
+
+	for (i = 0; i < nrecs; i++) {
+		/* records already returned point into the current batch,
+		 * do not receive the next one over them */
+		if (i > 0 && cp->batch_off >= cp->batch_len)
+			break;
+
+		rc = changelog_batch_next(cp, &recs[i]);
+		if (rc < 0)
+			return rc;
+		if (rc > 0)
+			break;
+	}
+
+	return i;
+}
+
 int llapi_changelog_recv(void *priv, struct changelog_rec **rech)
 {
 	struct changelog_private	*cp = (struct changelog_private *)priv;
@@ -4340,6 +4794,20 @@ int llapi_changelog_recv(void *priv, struct changelog_rec **rech)
 	if (kuch == NULL)
 		return -ENOMEM;
 
+	if (cp->batch != NULL) {
+		struct changelog_rec *rec;
+
+		rc = changelog_batch_next(cp, &rec);
+		if (rc != 0)
+			goto out_free;
+
+		/* copy it out, to be released by llapi_changelog_free() */
+		memcpy(kuch + 1, rec, changelog_rec_size(rec) +
+		       rec->cr_namelen);
+		*rech = (struct changelog_rec *)(kuch + 1);
+		return 0;
+	}
+
 	if (cp->flags & CHANGELOG_FLAG_JOBID)
 		rec_fmt |= CLF_JOBID;
 
@@ -4419,7 +4887,8 @@ int llapi_changelog_clear(const char *mdtname, const char *idstr,
                 return -EINVAL;
         }
 
-        return changelog_ioctl(mdtname, OBD_IOC_CHANGELOG_CLEAR, id, endrec, 0);
+	return changelog_ioctl(mdtname, OBD_IOC_CHANGELOG_CLEAR, id, endrec, 0,
+			       NULL);
 }
 
 int llapi_fid2path(const char *device, const char *fidstr, char *buf,
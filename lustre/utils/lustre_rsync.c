@@ -120,6 +120,11 @@
 #include <limits.h>
 #include <utime.h>
 #include <sys/xattr.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #include <libcfs/libcfsutil.h>
 #include <lustre/lustreapi.h>
@@ -132,6 +137,15 @@
 
 #define TYPE_STR_LEN 16
 
+/* Data is copied in kernel in chunks of LR_COPY_CHUNK, or through a
+ * buffer of at least LR_COPY_BUFSIZE if that is not supported */
+#define LR_COPY_CHUNK (64 << 20)
+#define LR_COPY_BUFSIZE (1 << 20)
+
+/* fid2path results cache */
+#define LR_PATH_CACHE_BITS 12
+#define LR_PATH_CACHE_MAX (1 << 16)
+
 #define DEFAULT_MDT "-MDT0000"
 #define SPECIAL_DIR ".lustrerepl"
 #define RSYNC "rsync"
@@ -174,6 +188,17 @@ struct lr_info {
         size_t xsize;
         char *xvalue;
         size_t xvsize;
+
+	/* Dispatched to a replication thread, see lr_replicate_parallel() */
+	unsigned int in_use:1;
+	/* info->path came from path_cache and may be stale */
+	unsigned int path_cached:1;
+};
+
+struct lr_path_entry {
+	struct lr_path_entry *pe_next;
+	char pe_fid[LR_FID_STR_LEN];
+	char pe_path[0];
 };
 
 struct lr_parent_child_list {
@@ -200,6 +225,30 @@ int abort_on_err = 0;
 char rsync[PATH_MAX];
 char rsync_ver[PATH_MAX];
 struct lr_parent_child_list *parents;
+int nthreads = 1; /* Number of replication threads */
+
+/* fid2path results, see lr_get_path_ln() */
+struct lr_path_entry *path_cache[1 << LR_PATH_CACHE_BITS];
+int path_cache_count;
+
+#ifdef HAVE_LIBPTHREAD
+/* Protects errors, parents and path_cache with several replication
+ * threads */
+pthread_mutex_t lr_state_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline void lr_lock(void)
+{
+	pthread_mutex_lock(&lr_state_mutex);
+}
+
+static inline void lr_unlock(void)
+{
+	pthread_mutex_unlock(&lr_state_mutex);
+}
+#else
+static inline void lr_lock(void) {}
+static inline void lr_unlock(void) {}
+#endif
 
 FILE *debug_log;
 
@@ -221,6 +270,7 @@ struct option long_opts[] = {
         {"abort-on-err",no_argument,       0, 'a'},
         {"debug",       required_argument, 0, 'd'},
 	{"debuglog",	required_argument, 0, 'D'},
+	{"threads",	required_argument, 0, 'T'},
 	{0, 0, 0, 0}
 };
 
@@ -236,7 +286,9 @@ void lr_usage()
                 "\t--xattr <yes|no> replicate EAs\n"
                 "\t--abort-on-err   abort at first err\n"
                 "\t--verbose\n"
-                "\t--dry-run        don't write anything\n");
+                "\t--dry-run        don't write anything\n"
+		"\t--threads <n>    replicate independent operations with "
+		"<n> threads\n");
 }
 
 #define DEBUG_ENTRY(info)						       \
@@ -342,6 +394,40 @@ int lr_rsync_data(struct lr_info *info)
         return rc;
 }
 
+/* Copy all of fd_src to fd_dest in the kernel, with copy_file_range() or
+ * sendfile(). Returns 1 if neither can be used for these files. */
+static int lr_copy_data_kernel(int fd_src, int fd_dest)
+{
+	long long copied = 0;
+	ssize_t rsize = -1;
+
+#ifdef __NR_copy_file_range
+	do {
+		rsize = syscall(__NR_copy_file_range, fd_src, NULL, fd_dest,
+				NULL, LR_COPY_CHUNK, 0);
+		if (rsize > 0)
+			copied += rsize;
+	} while (rsize > 0);
+	if (rsize == 0)
+		return 0;
+	if (copied > 0 || (errno != ENOSYS && errno != EXDEV &&
+			   errno != EINVAL && errno != EOPNOTSUPP))
+		return -errno;
+#endif
+
+	do {
+		rsize = sendfile(fd_dest, fd_src, NULL, LR_COPY_CHUNK);
+		if (rsize > 0)
+			copied += rsize;
+	} while (rsize > 0);
+	if (rsize == 0)
+		return 0;
+	if (copied > 0 || (errno != ENOSYS && errno != EINVAL))
+		return -errno;
+
+	return 1;
+}
+
 int lr_copy_data(struct lr_info *info)
 {
         int fd_src = -1;
@@ -356,8 +442,10 @@ int lr_copy_data(struct lr_info *info)
         if (fd_src == -1)
                 return -errno;
         if (fstat(fd_src, &st_src) == -1 ||
-            stat(info->dest, &st_dest) == -1)
+	    stat(info->dest, &st_dest) == -1) {
+		rc = -errno;
                 goto out;
+	}
 
         if (st_src.st_mtime == st_dest.st_mtime &&
             st_src.st_size == st_dest.st_size)
@@ -377,7 +465,15 @@ int lr_copy_data(struct lr_info *info)
                 rc = -errno;
                 goto out;
         }
+
+	rc = lr_copy_data_kernel(fd_src, fd_dest);
+	if (rc <= 0)
+		goto out_sync;
+	rc = 0;
+
         bufsize = st_dest.st_blksize;
+	if (bufsize < LR_COPY_BUFSIZE)
+		bufsize = LR_COPY_BUFSIZE;
 
         if (info->bufsize < bufsize) {
                 /* Grow buffer */
@@ -403,8 +499,10 @@ int lr_copy_data(struct lr_info *info)
                                 rc = -errno;
                         else
                                 rc = -EINTR;
+			goto out;
                 }
         }
+out_sync:
         fsync(fd_dest);
 
 out:
@@ -495,11 +593,16 @@ int lr_copy_xattr(struct lr_info *info)
                         lr_debug(DTRACE, "\tlsetxattr(), rc=%d, errno=%d\n",
                                  rc, errno);
                         if (rc == -1) {
+				/* Let lr_setxattr() retry a stale path */
+				if (errno == ENOENT && info->path_cached)
+					return -ENOENT;
                                 if (errno != ENOTSUP) {
                                         fprintf(stderr, "Error replicating "
                                                 " xattr for %s: %d\n",
                                                 info->dest, errno);
-                                        errors++;
+					lr_lock();
+					errors++;
+					lr_unlock();
                                 }
                                 rc = 0;
                         }
@@ -512,19 +615,121 @@ int lr_copy_xattr(struct lr_info *info)
         return rc;
 }
 
+static unsigned int lr_path_hash(const char *fidstr)
+{
+	unsigned int hash = 5381;
+
+	while (*fidstr != '\0')
+		hash = hash * 33 + *fidstr++;
+
+	return hash & ((1 << LR_PATH_CACHE_BITS) - 1);
+}
+
+/* Drop all cached paths, called with lr_lock() held */
+static void lr_path_cache_flush_locked(void)
+{
+	struct lr_path_entry *pe;
+	int i;
+
+	for (i = 0; i < (1 << LR_PATH_CACHE_BITS); i++) {
+		while ((pe = path_cache[i]) != NULL) {
+			path_cache[i] = pe->pe_next;
+			free(pe);
+		}
+	}
+	path_cache_count = 0;
+}
+
+/* Drop all cached paths, after a rename changed the paths of a subtree */
+void lr_path_cache_flush(void)
+{
+	lr_lock();
+	lr_path_cache_flush_locked();
+	lr_unlock();
+}
+
+/* Drop the cached path of an unlinked FID */
+void lr_path_cache_del(const char *fidstr)
+{
+	struct lr_path_entry **pp;
+	struct lr_path_entry *pe;
+
+	lr_lock();
+	for (pp = &path_cache[lr_path_hash(fidstr)]; (pe = *pp) != NULL;
+	     pp = &pe->pe_next) {
+		if (strcmp(pe->pe_fid, fidstr) == 0) {
+			*pp = pe->pe_next;
+			free(pe);
+			path_cache_count--;
+			break;
+		}
+	}
+	lr_unlock();
+}
+
+static int lr_path_cache_get(const char *fidstr, char *path)
+{
+	struct lr_path_entry *pe;
+	int rc = -ENOENT;
+
+	lr_lock();
+	for (pe = path_cache[lr_path_hash(fidstr)]; pe != NULL;
+	     pe = pe->pe_next) {
+		if (strcmp(pe->pe_fid, fidstr) == 0) {
+			strcpy(path, pe->pe_path);
+			rc = 0;
+			break;
+		}
+	}
+	lr_unlock();
+
+	return rc;
+}
+
+static void lr_path_cache_add(const char *fidstr, const char *path)
+{
+	struct lr_path_entry *pe;
+	unsigned int hash = lr_path_hash(fidstr);
+
+	pe = malloc(sizeof(*pe) + strlen(path) + 1);
+	if (pe == NULL)
+		return;
+	strlcpy(pe->pe_fid, fidstr, sizeof(pe->pe_fid));
+	strcpy(pe->pe_path, path);
+
+	lr_lock();
+	if (path_cache_count >= LR_PATH_CACHE_MAX)
+		lr_path_cache_flush_locked();
+	pe->pe_next = path_cache[hash];
+	path_cache[hash] = pe;
+	path_cache_count++;
+	lr_unlock();
+}
+
 /* Retrieve the filesystem path for a given FID and a given
-   linkno. The path is returned in info->path */
+   linkno. The path is returned in info->path. The first path of
+   a FID is cached until it is removed or anything is renamed, or
+   until an operation on it fails, see lr_refresh_path(). */
 int lr_get_path_ln(struct lr_info *info, char *fidstr, int linkno)
 {
         long long recno = -1;
+	int cacheable = (linkno == 0);
         int rc;
 
+	info->path_cached = 0;
+	if (cacheable && lr_path_cache_get(fidstr, info->path) == 0) {
+		info->path_cached = 1;
+		return 0;
+	}
+
         rc = llapi_fid2path(status->ls_source, fidstr, info->path,
                             PATH_MAX, &recno, &linkno);
         if (rc < 0 && rc != -ENOENT) {
                 fprintf(stderr, "fid2path error: (%s, %s) %d %s\n",
                         status->ls_source, fidstr, -rc, strerror(errno = -rc));
         }
+	if (rc == 0 && cacheable)
+		lr_path_cache_add(fidstr, info->path);
 
         return rc;
 }
@@ -536,6 +741,21 @@ int lr_get_path(struct lr_info *info, char *fidstr)
         return lr_get_path_ln(info, fidstr, 0);
 }
 
+/* An operation on the path of \a fidstr failed with ENOENT. If that path
+   came from the cache, a rename on the source may have made it stale:
+   drop it and query fid2path again. Returns 0 if info->path has been
+   refreshed and the operation is worth retrying. */
+static int lr_refresh_path(struct lr_info *info, char *fidstr)
+{
+	if (!info->path_cached)
+		return -ENOENT;
+
+	lr_debug(DTRACE, "stale cached path %s for %s\n", info->path, fidstr);
+	lr_path_cache_del(fidstr);
+
+	return lr_get_path(info, fidstr);
+}
+
 /* Generate the path for opening by FID */
 void lr_get_FID_PATH(char *mntpt, char *fidstr, char *buf, int bufsize)
 {
@@ -652,6 +872,8 @@ out_err:
 	return -E2BIG;
 }
 
+/* Move the children of fid parked in SPECIAL_DIR to dest, called
+ * with lr_lock() held */
 void lr_cascade_move(const char *fid, const char *dest, struct lr_info *info)
 {
         struct lr_parent_child_list *curr, *prev;
@@ -672,7 +894,7 @@ void lr_cascade_move(const char *fid, const char *dest, struct lr_info *info)
                                 fprintf(stderr, "Error renaming file "
                                         " %s to %s: %d\n",
                                         info->src, d, errno);
-                                errors++;
+				errors++;
                         }
                         lr_cascade_move(curr->pc_log.pcl_tfid, d, info);
                         if (curr == parents)
@@ -723,7 +945,9 @@ int lr_mk_special(struct lr_info *info)
         if (rc)
                 return rc;
 
+	lr_lock();
         rc = lr_add_pc(info->pfid, info->tfid, info->name);
+	lr_unlock();
         return rc;
 }
 
@@ -852,6 +1076,8 @@ int lr_remove(struct lr_info *info)
         int rc = 0;
         int rc1;
 
+	lr_path_cache_del(info->tfid);
+
         for (info->target_no = 0; info->target_no < status->ls_num_targets;
              info->target_no++) {
 
@@ -958,6 +1184,7 @@ int lr_move(struct lr_info *info)
 			lr_debug(DINFO, "rename returns %d\n", rc1);
                 }
 
+		lr_lock();
 		if (special_src) {
 			rc1 = lr_remove_pc(info->spfid, info->sfid);
 			if (!special_dest)
@@ -965,12 +1192,17 @@ int lr_move(struct lr_info *info)
                 }
 		if (special_dest)
 			rc1 = lr_add_pc(info->pfid, info->sfid, info->name);
+		lr_unlock();
 
                 lr_debug(DINFO, "move: %s [to] %s rc1=%d, errno=%d\n",
                          info->src, info->dest, rc1, errno);
                 if (rc1)
                         rc = rc1;
         }
+
+	/* the paths of the whole renamed subtree changed */
+	lr_path_cache_flush();
+
 	return rc;
 }
 
@@ -1063,7 +1295,7 @@ int lr_setattr(struct lr_info *info)
 
         for (info->target_no = 0; info->target_no < status->ls_num_targets;
              info->target_no++) {
-
+again:
                 snprintf(info->dest, PATH_MAX, "%s/%s",
                          status->ls_targets[info->target_no], info->path);
                 lr_debug(DINFO, "setattr: %s %s %s", info->src, info->dest,
@@ -1072,6 +1304,8 @@ int lr_setattr(struct lr_info *info)
                 rc1 = lr_sync_data(info);
                 if (!rc1)
                         rc1 = lr_copy_attr(info->src, info->dest);
+		if (rc1 == -ENOENT && lr_refresh_path(info, info->tfid) == 0)
+			goto again;
                 if (rc1)
                         rc = rc1;
         }
@@ -1094,13 +1328,15 @@ int lr_setxattr(struct lr_info *info)
 
         for (info->target_no = 0; info->target_no < status->ls_num_targets;
              info->target_no++) {
-
+again:
                 snprintf(info->dest, PATH_MAX, "%s/%s",
                         status->ls_targets[info->target_no], info->path);
                 lr_debug(DINFO, "setxattr: %s %s %s\n", info->src, info->dest,
                          info->tfid);
 
                 rc1 = lr_copy_xattr(info);
+		if (rc1 == -ENOENT && lr_refresh_path(info, info->tfid) == 0)
+			goto again;
                 if (rc1)
                         rc = rc1;
         }
@@ -1335,19 +1571,14 @@ int lr_read_log()
         return rc;
 }
 
-/* Clear changelogs every CLEAR_INTERVAL records or at the end of
-   processing. */
-int lr_clear_cl(struct lr_info *info, int force)
+/* Clear changelogs up to record 'rec' every CLEAR_INTERVAL records or
+   at the end of processing. */
+int lr_clear_cl_upto(long long rec, int force)
 {
 	char		mdt_device[LR_NAME_MAXLEN + 1];
-	long long	rec;
 	int		rc = 0;
 
-        if (force || info->recno > status->ls_last_recno + CLEAR_INTERVAL) {
-                if (info->type == CL_RENAME)
-                        rec = info->recno + 1;
-                else
-                        rec = info->recno;
+	if (force || rec > status->ls_last_recno + CLEAR_INTERVAL) {
                 if (!noclear && !dryrun) {
                         /* llapi_changelog_clear modifies the mdt
                          * device name so make a copy of it until this
@@ -1373,6 +1604,15 @@ int lr_clear_cl(struct lr_info *info, int force)
         return rc;
 }
 
+/* Clear changelogs up to the record in 'info' */
+int lr_clear_cl(struct lr_info *info, int force)
+{
+	if (info->type == CL_RENAME)
+		return lr_clear_cl_upto(info->recno + 1, force);
+
+	return lr_clear_cl_upto(info->recno, force);
+}
+
 /* Locate a usable version of rsync. At this point we'll use any
    version. */
 int lr_locate_rsync()
@@ -1448,6 +1688,318 @@ void lr_print_failure(struct lr_info *info, int rc)
                 info->pfid, info->name);
 }
 
+/* Replicate the operation of one changelog record */
+int lr_replicate_one(struct lr_info *info)
+{
+	int rc = 0;
+
+	DEBUG_ENTRY(info);
+
+	switch (info->type) {
+	case CL_CREATE:
+	case CL_MKDIR:
+	case CL_MKNOD:
+	case CL_SOFTLINK:
+		rc = lr_create(info);
+		break;
+	case CL_RMDIR:
+	case CL_UNLINK:
+		rc = lr_remove(info);
+		break;
+	case CL_RENAME:
+		rc = lr_move(info);
+		break;
+	case CL_HARDLINK:
+		rc = lr_link(info);
+		break;
+	case CL_TRUNC:
+	case CL_SETATTR:
+		rc = lr_setattr(info);
+		break;
+	case CL_XATTR:
+		rc = lr_setxattr(info);
+		break;
+	case CL_CLOSE:
+	case CL_EXT:
+	case CL_OPEN:
+	case CL_LAYOUT:
+	case CL_MARK:
+		/* Nothing needs to be done for these entries */
+		/* fallthrough */
+	default:
+		break;
+	}
+
+	DEBUG_EXIT(info, rc);
+
+	return rc;
+}
+
+/* Read the next operation to replicate into 'info', merging the two
+   records of an old style rename using 'ext' */
+int lr_next_op(void *changelog_priv, struct lr_info *info,
+	       struct lr_info *ext)
+{
+	info->sfid[0] = '\0';
+	info->spfid[0] = '\0';
+	if (lr_parse_line(changelog_priv, info) != 0)
+		return -1;
+
+	if (info->type == CL_RENAME && !info->is_extended) {
+		/* Newer rename operations extends changelog to store
+		 * source file information, but old changelog has
+		 * another record.
+		 */
+		if (lr_parse_line(changelog_priv, ext) != 0)
+			return -1;
+		memcpy(info->sfid, info->tfid, sizeof(info->sfid));
+		memcpy(info->spfid, info->pfid, sizeof(info->spfid));
+		memcpy(info->tfid, ext->tfid, sizeof(info->tfid));
+		memcpy(info->pfid, ext->pfid, sizeof(info->pfid));
+		strlcpy(info->sname, info->name, sizeof(info->sname));
+		strlcpy(info->name, ext->name, sizeof(info->name));
+		info->is_extended = 1;
+	}
+
+	return 0;
+}
+
+/* Account for a failed operation. Returns 1 if replication must stop. */
+int lr_op_failed(struct lr_info *info, int rc)
+{
+	if (rc == 0 || rc == -ENOENT)
+		return 0;
+
+	lr_print_failure(info, rc);
+	lr_lock();
+	errors++;
+	lr_unlock();
+
+	return abort_on_err;
+}
+
+#ifdef HAVE_LIBPTHREAD
+/* Replication threads, fed one operation at a time by the reader of the
+   changelog. */
+struct lr_pool {
+	pthread_mutex_t	  lp_lock;
+	pthread_cond_t	  lp_cond;
+	struct lr_info	**lp_infos;	/* nthreads + 2 */
+	struct lr_info	 *lp_todo;	/* waiting for a thread */
+	int		  lp_ninfos;
+	int		  lp_running;	/* in_use infos */
+	int		  lp_stop;
+};
+
+/* Whether 'a' and 'b' name a common FID, and must be replayed in order */
+static int lr_depends(struct lr_info *a, struct lr_info *b)
+{
+	const char *fa[] = { a->tfid, a->pfid, a->sfid, a->spfid };
+	const char *fb[] = { b->tfid, b->pfid, b->sfid, b->spfid };
+	int i, j;
+
+	for (i = 0; i < 4; i++) {
+		if (fa[i][0] == '\0')
+			continue;
+		for (j = 0; j < 4; j++)
+			if (strcmp(fa[i], fb[j]) == 0)
+				return 1;
+	}
+
+	return 0;
+}
+
+/* Whether 'info' depends on any operation still being replicated */
+static int lr_pool_blocked(struct lr_pool *lp, struct lr_info *info)
+{
+	int i;
+
+	if (lp->lp_todo != NULL)
+		return 1;
+
+	for (i = 0; i < lp->lp_ninfos; i++)
+		if (lp->lp_infos[i]->in_use &&
+		    lr_depends(info, lp->lp_infos[i]))
+			return 1;
+
+	return 0;
+}
+
+/* Oldest record not replicated yet, given the last one read */
+static long long lr_pool_done_upto(struct lr_pool *lp, struct lr_info *last)
+{
+	long long rec = last->type == CL_RENAME ? last->recno + 1 :
+						  last->recno;
+	int i;
+
+	for (i = 0; i < lp->lp_ninfos; i++)
+		if (lp->lp_infos[i]->in_use &&
+		    lp->lp_infos[i]->recno <= rec)
+			rec = lp->lp_infos[i]->recno - 1;
+
+	return rec;
+}
+
+static void *lr_pool_thread(void *arg)
+{
+	struct lr_pool *lp = arg;
+	struct lr_info *info;
+	int rc;
+
+	pthread_mutex_lock(&lp->lp_lock);
+	while (1) {
+		info = lp->lp_todo;
+		if (info == NULL) {
+			if (lp->lp_stop)
+				break;
+			pthread_cond_wait(&lp->lp_cond, &lp->lp_lock);
+			continue;
+		}
+		lp->lp_todo = NULL;
+		pthread_cond_broadcast(&lp->lp_cond);
+		pthread_mutex_unlock(&lp->lp_lock);
+
+		rc = lr_replicate_one(info);
+		rc = lr_op_failed(info, rc);
+
+		pthread_mutex_lock(&lp->lp_lock);
+		if (rc)
+			lp->lp_stop = 1;
+		info->in_use = 0;
+		lp->lp_running--;
+		pthread_cond_broadcast(&lp->lp_cond);
+	}
+	pthread_mutex_unlock(&lp->lp_lock);
+
+	return NULL;
+}
+
+/* Replicate operations with 'nthreads' threads. Operations naming a FID of
+   an operation still in progress wait for it to complete, renames wait for
+   all operations since they change the paths of a whole subtree. */
+int lr_replicate_parallel(void *changelog_priv, struct lr_info *ext,
+			  struct lr_info *last)
+{
+	struct lr_pool	 lp = { .lp_todo = NULL };
+	pthread_t	*threads;
+	struct lr_info	*info = NULL;
+	long long	 done;
+	int		 started = 0;
+	int		 rc = 0;
+	int		 i;
+
+	lp.lp_ninfos = nthreads + 2;
+	lp.lp_infos = calloc(lp.lp_ninfos, sizeof(*lp.lp_infos));
+	threads = calloc(nthreads, sizeof(*threads));
+	if (lp.lp_infos == NULL || threads == NULL) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < lp.lp_ninfos; i++) {
+		lp.lp_infos[i] = calloc(1, sizeof(struct lr_info));
+		if (lp.lp_infos[i] == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+	}
+
+	pthread_mutex_init(&lp.lp_lock, NULL);
+	pthread_cond_init(&lp.lp_cond, NULL);
+
+	for (started = 0; started < nthreads; started++) {
+		rc = pthread_create(&threads[started], NULL, lr_pool_thread,
+				    &lp);
+		if (rc != 0) {
+			fprintf(stderr, "cannot start replication thread: "
+				"%s\n", strerror(rc));
+			rc = -rc;
+			break;
+		}
+	}
+	if (started == 0)
+		goto out_stop;
+	rc = 0;
+
+	while (!quit) {
+		/* pick an operation not in progress */
+		pthread_mutex_lock(&lp.lp_lock);
+		for (info = NULL; info == NULL && !lp.lp_stop; ) {
+			for (i = 0; i < lp.lp_ninfos; i++) {
+				if (!lp.lp_infos[i]->in_use) {
+					info = lp.lp_infos[i];
+					break;
+				}
+			}
+			if (info == NULL)
+				pthread_cond_wait(&lp.lp_cond, &lp.lp_lock);
+		}
+		pthread_mutex_unlock(&lp.lp_lock);
+		if (info == NULL || lr_next_op(changelog_priv, info, ext) != 0)
+			break;
+
+		if (dryrun)
+			continue;
+
+		pthread_mutex_lock(&lp.lp_lock);
+		if (info->type == CL_RENAME) {
+			while (lp.lp_running > 0)
+				pthread_cond_wait(&lp.lp_cond, &lp.lp_lock);
+			pthread_mutex_unlock(&lp.lp_lock);
+
+			if (lr_op_failed(info, lr_replicate_one(info)))
+				break;
+			pthread_mutex_lock(&lp.lp_lock);
+		} else {
+			while (!lp.lp_stop && lr_pool_blocked(&lp, info))
+				pthread_cond_wait(&lp.lp_cond, &lp.lp_lock);
+			if (lp.lp_stop) {
+				pthread_mutex_unlock(&lp.lp_lock);
+				break;
+			}
+			info->in_use = 1;
+			lp.lp_running++;
+			lp.lp_todo = info;
+			pthread_cond_broadcast(&lp.lp_cond);
+		}
+
+		last->recno = info->recno;
+		last->type = info->type;
+		done = lr_pool_done_upto(&lp, last);
+		pthread_mutex_unlock(&lp.lp_lock);
+
+		lr_clear_cl_upto(done, 0);
+	}
+
+out_stop:
+	pthread_mutex_lock(&lp.lp_lock);
+	lp.lp_stop = 1;
+	pthread_cond_broadcast(&lp.lp_cond);
+	pthread_mutex_unlock(&lp.lp_lock);
+
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	pthread_cond_destroy(&lp.lp_cond);
+	pthread_mutex_destroy(&lp.lp_lock);
+out:
+	if (lp.lp_infos != NULL) {
+		for (i = 0; i < lp.lp_ninfos; i++) {
+			if (lp.lp_infos[i] == NULL)
+				continue;
+			free(lp.lp_infos[i]->buf);
+			free(lp.lp_infos[i]->xlist);
+			free(lp.lp_infos[i]->xvalue);
+			free(lp.lp_infos[i]);
+		}
+		free(lp.lp_infos);
+	}
+	free(threads);
+
+	return rc;
+}
+#endif /* HAVE_LIBPTHREAD */
+
 /* Replicate filesystem operations from src_path to target_path */
 int lr_replicate()
 {
@@ -1514,70 +2066,24 @@ int lr_replicate()
 		goto out;
         }
 
-        while (!quit && lr_parse_line(changelog_priv, info) == 0) {
-                rc = 0;
-		if (info->type == CL_RENAME && !info->is_extended) {
-			/* Newer rename operations extends changelog to store
-			 * source file information, but old changelog has
-			 * another record.
-			 */
-			if (lr_parse_line(changelog_priv, ext) != 0)
-				break;
-			memcpy(info->sfid, info->tfid, sizeof(info->sfid));
-			memcpy(info->spfid, info->pfid, sizeof(info->spfid));
-			memcpy(info->tfid, ext->tfid, sizeof(info->tfid));
-			memcpy(info->pfid, ext->pfid, sizeof(info->pfid));
-			strlcpy(info->sname, info->name, sizeof(info->sname));
-			strlcpy(info->name, ext->name, sizeof(info->name));
-			info->is_extended = 1;
+#ifdef HAVE_LIBPTHREAD
+	if (nthreads > 1) {
+		rc = lr_replicate_parallel(changelog_priv, ext, info);
+		if (rc < 0) {
+			llapi_changelog_fini(&changelog_priv);
+			goto out;
 		}
+	}
+#endif
 
+	while (nthreads == 1 && !quit &&
+	       lr_next_op(changelog_priv, info, ext) == 0) {
                 if (dryrun)
                         continue;
 
-		DEBUG_ENTRY(info);
-
-                switch(info->type) {
-                case CL_CREATE:
-                case CL_MKDIR:
-                case CL_MKNOD:
-                case CL_SOFTLINK:
-                        rc = lr_create(info);
-                        break;
-                case CL_RMDIR:
-                case CL_UNLINK:
-                        rc = lr_remove(info);
-                        break;
-                case CL_RENAME:
-			rc = lr_move(info);
-                        break;
-                case CL_HARDLINK:
-                        rc = lr_link(info);
-                        break;
-                case CL_TRUNC:
-                case CL_SETATTR:
-                        rc = lr_setattr(info);
-                        break;
-                case CL_XATTR:
-                        rc = lr_setxattr(info);
-                        break;
-		case CL_CLOSE:
-		case CL_EXT:
-		case CL_OPEN:
-		case CL_LAYOUT:
-		case CL_MARK:
-			/* Nothing needs to be done for these entries */
-			/* fallthrough */
-		default:
+		rc = lr_replicate_one(info);
+		if (lr_op_failed(info, rc))
 			break;
-		}
-		DEBUG_EXIT(info, rc);
-                if (rc && rc != -ENOENT) {
-                        lr_print_failure(info, rc);
-                        errors++;
-                        if (abort_on_err)
-                                break;
-                }
                 lr_clear_cl(info, 0);
                 if (debug) {
                         bzero(info, sizeof(struct lr_info));
@@ -1626,7 +2132,7 @@ int main(int argc, char *argv[])
         if ((rc = lr_init_status()) != 0)
                 return rc;
 
-	while ((rc = getopt_long(argc, argv, "as:t:m:u:l:vx:zc:ry:n:d:D:",
+	while ((rc = getopt_long(argc, argv, "as:t:m:u:l:vx:zc:ry:n:d:D:T:",
 				 long_opts, NULL)) >= 0) {
                 switch (rc) {
                 case 'a':
@@ -1729,6 +2235,22 @@ int main(int argc, char *argv[])
 				return -1;
 			}
 			break;
+		case 'T':
+			nthreads = atoi(optarg);
+			if (nthreads < 1) {
+				fprintf(stderr, "error: %s: invalid number of "
+					"threads '%s'\n", argv[0], optarg);
+				return -1;
+			}
+#ifndef HAVE_LIBPTHREAD
+			if (nthreads > 1) {
+				fprintf(stderr, "warning: %s: built without "
+					"thread support, using one thread\n",
+					argv[0]);
+				nthreads = 1;
+			}
+#endif
+			break;
                 default:
                         fprintf(stderr, "error: %s: option '%s' "
                                 "unrecognized.\n", argv[0], argv[optind - 1]);